@@ -0,0 +1,692 @@
+/**
+ * @file    ecg_accuracy.c
+ * @brief   Banc de non-régression : précision de détection des pics R et débit de chaque chemin d'analyse.
+ *
+ * Chaque chemin (noyaux SIMD, noyau fusionné, float32 / int16, décimation, passe-bande, streaming, segments
+ * parallèles, moteur entrelacé) est comparé sur des enregistrements annotés :
+ *  - à la vérité terrain : sensibilité Se = VP / (VP + FN) et valeur prédictive positive PPV = VP / (VP + FP),
+ *    appariement battement par battement à +-tolérance (150 ms par défaut, comme les bancs de détection QRS) ;
+ *  - à son chemin de référence (ecg_analyze(), chaîne multi-passes et noyaux scalaires, sauf indication) :
+ *    pics identiques ou non. Passe-bande par segments et streaming (ecg_push() par blocs de 256 échantillons)
+ *    sont comparés au même algorithme : passe-bande de ecg_analyze(), et analyse par fenêtres (ecg_analyze()
+ *    sur un contexte plus court que le signal, qui passe par le streaming).
+ *
+ * Annotations : fichiers WFDB (.atr, ex. MIT-BIH : seuls les codes de battement comptent) ou vérité terrain
+ * JSON du générateur ("ecg_dealination synth ... --truth"). Enregistrements : CSV, .ecgb ou en-tête WFDB .hea
+ * (formats 212 et 16). Sans argument, une série d'enregistrements synthétiques est générée.
+ *
+ * Sortie machine : une ligne JSON par (enregistrement, chemin), clés dans un ordre fixe (diff entre deux
+ * versions), tableau lisible sur stderr. Code de retour 1 si, sur un enregistrement, un chemin documenté
+ * identique (noyaux SIMD, fusionné, entrelacé, passe-bande par segments, streaming) donne d'autres pics que
+ * sa référence, ou si un chemin approché (précision réduite, décimation, segments) perd plus de --max-drop
+ * points de Se ou de PPV. Passe-bande et analyse par fenêtres (seuil appris sur 2 s) sont des algorithmes
+ * différents de ecg_analyze() : mesurés, non bloquants.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "csv_reader.h"
+#include "ecg_binary.h"
+#include "ecg_processing.h"
+#include "ecg_synth.h"
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+#define DEFAULT_TOLERANCE_MS    150
+#define DEFAULT_MIN_TIME_S      0.2
+#define DEFAULT_MAX_DROP        0.5     // points de pourcentage
+#define MIN_REPETITIONS         3
+#define STREAM_CHUNK            256     // échantillons par ecg_push()
+#define PARALLEL_CHUNKS         4
+#define WINDOWED_CAPACITY       8192    // ECG_Params.max_samples de l'analyse par fenêtres
+#define SYNTH_DURATION_S        300
+
+// Codes WFDB (ecgcodes.h) : pseudo-annotations sans battement et modificateurs de l'annotation suivante
+#define WFDB_SKIP   59
+#define WFDB_NUM    60
+#define WFDB_SUB    61
+#define WFDB_CHN    62
+#define WFDB_AUX    63
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+typedef enum {
+    GATE_EXACT = 0,     // pics identiques à la référence (chemins documentés identiques bit à bit)
+    GATE_ACCURACY,      // Se et PPV au plus --max-drop points sous la référence (précision réduite, décimation)
+    GATE_NONE           // autre algorithme (filtre, seuil appris en ligne) : mesuré, non bloquant
+} Gate;
+
+static const char *const gate_names[] = { "exact", "accuracy", "none" };
+
+typedef enum {
+    RUN_ANALYZE = 0,    // ecg_analyze()
+    RUN_WINDOWED,       // ecg_analyze() sur un contexte de WINDOWED_CAPACITY échantillons (analyse par fenêtres)
+    RUN_REDUCED,        // ecg_analyze_f32() / ecg_analyze_i16()
+    RUN_STREAM,         // ecg_push() par blocs + ecg_flush()
+    RUN_PARALLEL,       // ecg_analyze_parallel()
+    RUN_INTERLEAVED     // ecg_analyze_interleaved(), une dérivation
+} Run_Kind;
+
+// Chemin d'analyse mesuré ; le premier est la référence par défaut
+typedef struct {
+    const char *name;
+    const char *reference;  // chemin comparé (placé avant), NULL = le premier
+    Run_Kind kind;
+    Gate gate;
+    int fused;
+    ECG_Isa isa;
+    ECG_Precision precision;
+    ECG_Filter filter;
+    int decimation;
+} Variant;
+
+static const Variant variants[] = {
+    { "baseline",      NULL,       RUN_ANALYZE,     GATE_EXACT,    0, ECG_ISA_SCALAR, ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "fused",         NULL,       RUN_ANALYZE,     GATE_EXACT,    1, ECG_ISA_SCALAR, ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "avx2",          NULL,       RUN_ANALYZE,     GATE_EXACT,    0, ECG_ISA_AVX2,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "avx2_fused",    NULL,       RUN_ANALYZE,     GATE_EXACT,    1, ECG_ISA_AVX2,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "avx512",        NULL,       RUN_ANALYZE,     GATE_EXACT,    0, ECG_ISA_AVX512, ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "avx512_fused",  NULL,       RUN_ANALYZE,     GATE_EXACT,    1, ECG_ISA_AVX512, ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "f32",           NULL,       RUN_REDUCED,     GATE_ACCURACY, 0, ECG_ISA_AUTO,   ECG_PRECISION_F32, ECG_FILTER_MA,       0 },
+    { "i16",           NULL,       RUN_REDUCED,     GATE_ACCURACY, 0, ECG_ISA_AUTO,   ECG_PRECISION_I16, ECG_FILTER_MA,       0 },
+    { "decim4",        NULL,       RUN_ANALYZE,     GATE_ACCURACY, 1, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_MA,       4 },
+    { "parallel4",     NULL,       RUN_PARALLEL,    GATE_ACCURACY, 1, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "interleaved",   NULL,       RUN_INTERLEAVED, GATE_EXACT,    0, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "bandpass",      NULL,       RUN_ANALYZE,     GATE_NONE,     0, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_BANDPASS, 0 },
+    { "bandpass_par4", "bandpass", RUN_PARALLEL,    GATE_EXACT,    0, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_BANDPASS, 0 },
+    { "windowed",      NULL,       RUN_WINDOWED,    GATE_NONE,     0, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+    { "stream",        "windowed", RUN_STREAM,      GATE_EXACT,    0, ECG_ISA_AUTO,   ECG_PRECISION_F64, ECG_FILTER_MA,       0 },
+};
+
+#define N_VARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+// Enregistrement évalué : une dérivation, ses versions réduites et ses battements annotés
+typedef struct {
+    char name[256];
+    int fs;
+    size_t n;
+    double *signal;
+    float *signal_f32;
+    int16_t *signal_i16;
+    ECG_Peaks truth;
+} Input;
+
+typedef struct {
+    FILE *out;              // lignes JSON
+    double min_time;
+    double max_drop;
+    int tolerance_ms;
+    int lead;               // -1 = automatique (II en CSV / .ecgb, premier signal en WFDB)
+    int fs;                 // fréquence des enregistrements qui ne la portent pas (CSV)
+    int enabled[N_VARIANTS];
+} Harness;
+
+// Appariement de deux listes triées de pics R
+typedef struct {
+    int tp, fn, fp;
+    double mean_offset_ms;
+} Match;
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#define TIME_BEST(best, min_time, stmt)                                         \
+    do {                                                                        \
+        stmt; /* échauffement : pages touchées, caches */                       \
+        double total_ = 0.0;                                                    \
+        best = INFINITY;                                                        \
+        for (int rep_ = 0; rep_ < MIN_REPETITIONS || total_ < (min_time); rep_++) { \
+            const double t0_ = now_s();                                         \
+            stmt;                                                               \
+            const double dt_ = now_s() - t0_;                                   \
+            total_ += dt_;                                                      \
+            if (dt_ < best) best = dt_;                                         \
+        }                                                                       \
+    } while (0)
+
+static int ends_with(const char *s, const char *suffix) {
+    const size_t ls = strlen(s), lx = strlen(suffix);
+    return ls >= lx && strcmp(s + ls - lx, suffix) == 0;
+}
+
+static int push_peak(ECG_Peaks *peaks, int index) {
+    if (ecg_peaks_reserve(peaks, peaks->R_count + 1)) return -1;
+    peaks->R[peaks->R_count++] = index;
+    return 0;
+}
+
+/*
+ * Appariement dans l'ordre : un pic détecté et un pic de référence à moins de tolerance échantillons
+ * forment une paire (VP), les autres sont des faux négatifs (référence) ou des faux positifs (détectés).
+ */
+static Match match_peaks(const ECG_Peaks *ref, const ECG_Peaks *det, int tolerance, int fs) {
+    Match m = { 0, 0, 0, 0.0 };
+    long sum = 0;
+    int i = 0, j = 0;
+    while (i < ref->R_count && j < det->R_count) {
+        const int delta = det->R[j] - ref->R[i];
+        if (delta < -tolerance) {
+            m.fp++;
+            j++;
+        } else if (delta > tolerance) {
+            m.fn++;
+            i++;
+        } else {
+            m.tp++;
+            sum += abs(delta);
+            i++;
+            j++;
+        }
+    }
+    m.fn += ref->R_count - i;
+    m.fp += det->R_count - j;
+    m.mean_offset_ms = m.tp ? (double)sum / m.tp * 1000.0 / fs : 0.0;
+    return m;
+}
+
+static int same_peaks(const ECG_Peaks *a, const ECG_Peaks *b) {
+    return a->R_count == b->R_count && memcmp(a->R, b->R, sizeof(int) * (size_t)a->R_count) == 0;
+}
+
+// Indice du chemin de référence de v (le premier si v->reference est NULL ou inconnu)
+static int reference_index(const Variant *v) {
+    for (int k = 0; v->reference && k < N_VARIANTS; k++)
+        if (strcmp(variants[k].name, v->reference) == 0) return k;
+    return 0;
+}
+
+/* ===============================================================================
+ * Lecture des annotations
+ * =============================================================================== */
+
+// Codes de battement WFDB (isqrs) : N L R a V F J A S E j / Q | e n f ...
+static int wfdb_is_beat(int code) {
+    return (code >= 1 && code <= 13) || code == 16 || code == 25 || code == 30 || code == 34 || code == 35
+        || code == 38 || code == 41;
+}
+
+/*
+ * Annotations WFDB (format MIT) : mots de 16 bits petit-boutistes, code sur 6 bits, écart au précédent
+ * sur 10 bits. SKIP : écart sur 32 bits (mot de poids fort en premier) ; AUX : texte de delta octets.
+ */
+static int read_wfdb_annotations(const char *path, ECG_Peaks *truth) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    unsigned char w[4];
+    long t = 0;
+    int rc = 0;
+    truth->R_count = 0;
+    while (rc == 0 && fread(w, 1, 2, f) == 2) {
+        const int code = w[1] >> 2;
+        const int delta = ((w[1] & 0x03) << 8) | w[0];
+        if (code == 0 && delta == 0) break;
+
+        if (code == WFDB_SKIP) {
+            if (fread(w, 1, 4, f) != 4) rc = -2;
+            else t += (int32_t)(((uint32_t)w[1] << 24) | ((uint32_t)w[0] << 16) | ((uint32_t)w[3] << 8) | w[2]);
+        } else if (code == WFDB_AUX) {
+            if (fseek(f, delta + (delta & 1), SEEK_CUR) != 0) rc = -2;
+        } else if (code != WFDB_NUM && code != WFDB_SUB && code != WFDB_CHN) {
+            t += delta;
+            if (wfdb_is_beat(code) && push_peak(truth, (int)t)) rc = -3;
+        }
+    }
+    fclose(f);
+    return rc;
+}
+
+// Vérité terrain JSON du générateur : tableau "R" de la section "peaks"
+static int read_truth_json(const char *path, ECG_Peaks *truth) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = (size > 0) ? malloc((size_t)size + 1) : NULL;
+    const int ok = text && fread(text, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+    if (!ok) {
+        free(text);
+        return -2;
+    }
+    text[size] = '\0';
+
+    int rc = -2;
+    const char *p = strstr(text, "\"R\"");
+    p = p ? strchr(p, '[') : NULL;
+    truth->R_count = 0;
+    if (p) {
+        rc = 0;
+        for (p++; rc == 0 && *p && *p != ']';) {
+            char *end;
+            const long v = strtol(p, &end, 10);
+            if (end == p) {
+                p++;
+                continue;
+            }
+            rc = push_peak(truth, (int)v);
+            p = end;
+        }
+    }
+    free(text);
+    return rc;
+}
+
+/* ===============================================================================
+ * Lecture des enregistrements
+ * =============================================================================== */
+
+/*
+ * Enregistrement WFDB : en-tête .hea ("nom n_signaux fs n_échantillons", puis une ligne par signal
+ * "fichier format gain(adu/mV) bits zéro ..."), signaux entrelacés en format 212 (deux échantillons de
+ * 12 bits sur 3 octets) ou 16 (int16 petit-boutiste). Un seul fichier de données pour tous les signaux.
+ */
+static int read_wfdb_record(const char *hea, int lead, Input *in) {
+    FILE *f = fopen(hea, "r");
+    if (!f) return -1;
+
+    char line[512], name[128], file[256];
+    int n_signals = 0, fs = 0, format = 0, bits = 0, zero = 0;
+    long samples = 0;
+    double gain = 0.0;
+    int rc = -2;
+    while (fgets(line, sizeof(line), f) && line[0] == '#') {}
+    if (sscanf(line, "%127s %d %d %ld", name, &n_signals, &fs, &samples) == 4 && n_signals > 0 && lead < n_signals) {
+        for (int s = 0; s <= lead && fgets(line, sizeof(line), f);) {
+            if (line[0] == '#') continue;
+            if (s++ == lead && sscanf(line, "%255s %d %lf %d %d", file, &format, &gain, &bits, &zero) >= 3) rc = 0;
+        }
+    }
+    fclose(f);
+    if (rc != 0 || fs <= 0 || samples <= 0 || (format != 212 && format != 16)) return -2;
+    if (format == 212 && n_signals % 2 != 0) return -2;
+    if (gain <= 0.0) gain = 200.0; // défaut WFDB
+
+    // Fichier de données relatif au dossier de l'en-tête
+    char path[512];
+    const char *slash = strrchr(hea, '/');
+    snprintf(path, sizeof(path), "%.*s%s", slash ? (int)(slash - hea + 1) : 0, hea, file);
+    f = fopen(path, "rb");
+    if (!f) return -1;
+
+    in->fs = fs;
+    in->n = (size_t)samples;
+    in->signal = malloc(sizeof(double) * in->n);
+    const size_t frame = (format == 212) ? (size_t)n_signals * 3 / 2 : (size_t)n_signals * 2;
+    unsigned char *buf = malloc(frame);
+    rc = (in->signal && buf) ? 0 : -3;
+
+    size_t i = 0;
+    for (; rc == 0 && i < in->n && fread(buf, 1, frame, f) == frame; i++) {
+        int v;
+        if (format == 16) {
+            v = (int16_t)(buf[2 * lead] | (buf[2 * lead + 1] << 8));
+        } else {
+            // Paire (2k, 2k+1) sur les octets 3k..3k+2
+            const unsigned char *b = buf + 3 * (lead / 2);
+            v = (lead % 2 == 0) ? (b[0] | ((b[1] & 0x0F) << 8)) : (b[2] | ((b[1] & 0xF0) << 4));
+            if (v & 0x800) v -= 0x1000;
+        }
+        in->signal[i] = (v - zero) / gain;
+    }
+    in->n = i;
+    free(buf);
+    fclose(f);
+    return (rc == 0 && in->n > 0) ? 0 : -2;
+}
+
+static int load_record(const Harness *h, const char *path, Input *in) {
+    if (ends_with(path, ".hea")) return read_wfdb_record(path, h->lead >= 0 ? h->lead : 0, in);
+
+    ECG_Record rec;
+    ecg_record_init(&rec);
+    int rc = ecg_record_load(path, &rec);
+    const int lead = (h->lead >= 0) ? h->lead : (rec.leads > 1 ? 1 : 0);
+    if (rc == 0 && lead >= rec.leads) rc = -2;
+    const double *data = (rc == 0) ? ecg_record_lead(&rec, lead) : NULL;
+    if (rc == 0 && !data) rc = -2;
+    if (rc == 0) {
+        in->fs = rec.sampling_rate_hz > 0 ? rec.sampling_rate_hz : h->fs;
+        in->n = (size_t)rec.samples;
+        in->signal = malloc(sizeof(double) * in->n);
+        if (in->signal) memcpy(in->signal, data, sizeof(double) * in->n);
+        else rc = -3;
+    }
+    ecg_record_free(&rec);
+    return rc;
+}
+
+// Versions float32 et int16 (amplitude max -> INT16_MAX, comme un ADC 16 bits), hors chronométrage
+static int prepare_input(Input *in) {
+    in->signal_f32 = malloc(sizeof(float) * in->n);
+    in->signal_i16 = malloc(sizeof(int16_t) * in->n);
+    if (!in->signal_f32 || !in->signal_i16) return -3;
+
+    double max_abs = 0.0;
+    for (size_t i = 0; i < in->n; i++)
+        if (fabs(in->signal[i]) > max_abs) max_abs = fabs(in->signal[i]);
+    const double inv_scale = (max_abs > 0.0) ? INT16_MAX / max_abs : 1.0;
+    for (size_t i = 0; i < in->n; i++) {
+        in->signal_f32[i] = (float)in->signal[i];
+        in->signal_i16[i] = (int16_t)lrint(in->signal[i] * inv_scale);
+    }
+    return 0;
+}
+
+static void free_input(Input *in) {
+    free(in->signal);
+    free(in->signal_f32);
+    free(in->signal_i16);
+    ecg_peaks_free(&in->truth);
+    memset(in, 0, sizeof(*in));
+}
+
+/* ===============================================================================
+ * Mesures
+ * =============================================================================== */
+
+static ECG_Status append_peaks(ECG_Peaks *out, const ECG_Peaks *chunk) {
+    for (int i = 0; i < chunk->R_count; i++)
+        if (push_peak(out, chunk->R[i])) return ECG_ERR_ALLOC;
+    return ECG_OK;
+}
+
+static ECG_Status run_stream(ECG_Context *ctx, const double *signal, size_t n, ECG_Peaks *out, ECG_Peaks *chunk) {
+    ecg_reset(ctx);
+    out->R_count = 0;
+    ECG_Status st = ECG_OK;
+    for (size_t off = 0; off < n && st == ECG_OK; off += STREAM_CHUNK) {
+        const size_t len = (n - off < STREAM_CHUNK) ? n - off : STREAM_CHUNK;
+        st = ecg_push(ctx, signal + off, len, chunk, NULL);
+        if (st == ECG_OK) st = append_peaks(out, chunk);
+    }
+    if (st == ECG_OK) st = ecg_flush(ctx, chunk, NULL);
+    if (st == ECG_OK) st = append_peaks(out, chunk);
+    return st;
+}
+
+/*
+ * Analyse de in par le chemin v, chronométrée (meilleur temps sur min_time secondes).
+ * Retourne 1 si le chemin n'existe pas ici (jeu d'instructions absent, fréquence non décimable, signal
+ * tenant dans une fenêtre), 0 si OK.
+ */
+static int run_variant(const Harness *h, const Variant *v, const Input *in, ECG_Peaks *peaks, double *seconds) {
+    if (v->isa != ECG_ISA_AUTO && !ecg_kernels_get(v->isa)) return 1;
+    if (v->decimation > 1 && in->fs % v->decimation != 0) return 1;
+    if (v->kind == RUN_WINDOWED && in->n <= WINDOWED_CAPACITY) return 1;
+
+    ECG_Params params;
+    memset(&params, 0, sizeof(params));
+    params.sampling_rate_hz = in->fs;
+    params.leads = LEADS;
+    params.gain = 100.0;
+    params.max_samples = (v->kind == RUN_WINDOWED) ? WINDOWED_CAPACITY : in->n;
+    params.fused = v->fused;
+    params.isa = v->isa;
+    params.precision = v->precision;
+    params.filter = v->filter;
+    params.decimation = v->decimation;
+
+    ECG_Status st = ECG_OK;
+    if (v->kind == RUN_PARALLEL) {
+        TIME_BEST(*seconds, h->min_time, st |= ecg_analyze_parallel(&params, in->signal, in->n, 0, PARALLEL_CHUNKS,
+                                                                   peaks, NULL));
+        return st == ECG_OK ? 0 : -1;
+    }
+    if (v->kind == RUN_INTERLEAVED) {
+        TIME_BEST(*seconds, h->min_time, st |= ecg_analyze_interleaved(&params, in->signal, in->n, 1, peaks, NULL,
+                                                                      NULL));
+        return st == ECG_OK ? 0 : -1;
+    }
+
+    ECG_Context *ctx = ecg_create(&params);
+    if (!ctx) return (v->decimation > 1) ? 1 : -1;
+    ECG_Peaks chunk;
+    if (ecg_peaks_init(&chunk, 0) != 0) st = ECG_ERR_ALLOC;
+
+    if (st == ECG_OK && v->kind == RUN_STREAM) {
+        TIME_BEST(*seconds, h->min_time, st |= run_stream(ctx, in->signal, in->n, peaks, &chunk));
+    } else if (st == ECG_OK && v->kind == RUN_REDUCED && v->precision == ECG_PRECISION_I16) {
+        TIME_BEST(*seconds, h->min_time, st |= ecg_analyze_i16(ctx, in->signal_i16, in->n, 0, peaks, NULL));
+    } else if (st == ECG_OK && v->kind == RUN_REDUCED) {
+        TIME_BEST(*seconds, h->min_time, st |= ecg_analyze_f32(ctx, in->signal_f32, in->n, 0, peaks, NULL));
+    } else if (st == ECG_OK) {
+        TIME_BEST(*seconds, h->min_time, st |= ecg_analyze(ctx, in->signal, in->n, 0, peaks, NULL));
+    }
+
+    ecg_peaks_free(&chunk);
+    ecg_destroy(ctx);
+    return st == ECG_OK ? 0 : -1;
+}
+
+/*
+ * Tous les chemins sur un enregistrement, chacun comparé à son chemin de référence (exécuté avant lui).
+ * Retourne le nombre de chemins en régression, -1 en cas d'erreur.
+ */
+static int evaluate(const Harness *h, const Input *in) {
+    const int tolerance = h->tolerance_ms * in->fs / 1000;
+    ECG_Peaks results[N_VARIANTS];
+    double se_of[N_VARIANTS], ppv_of[N_VARIANTS];
+    int ran[N_VARIANTS];
+    int failures = 0;
+    for (int k = 0; k < N_VARIANTS; k++) {
+        ran[k] = 0;
+        if (ecg_peaks_init(&results[k], 0) != 0) failures = -1;
+    }
+
+    for (int k = 0; k < N_VARIANTS && failures >= 0; k++) {
+        // La référence tourne toujours : les autres chemins lui sont comparés
+        if (k > 0 && !h->enabled[k]) continue;
+        const Variant *v = &variants[k];
+        ECG_Peaks *p = &results[k];
+        double seconds = 0.0;
+        const int rc = run_variant(h, v, in, p, &seconds);
+        if (rc == 1) continue;
+        if (rc != 0) {
+            fprintf(stderr, "Erreur: chemin %s en échec sur %s.\n", v->name, in->name);
+            failures = -1;
+            break;
+        }
+        ran[k] = 1;
+
+        const Match m = match_peaks(&in->truth, p, tolerance, in->fs);
+        const double se = (m.tp + m.fn) ? 100.0 * m.tp / (m.tp + m.fn) : 100.0;
+        const double ppv = (m.tp + m.fp) ? 100.0 * m.tp / (m.tp + m.fp) : 100.0;
+        se_of[k] = se;
+        ppv_of[k] = ppv;
+
+        // Référence absente sur cet enregistrement (chemin inexistant ici) : mesuré, non bloquant
+        const int ref = reference_index(v);
+        const Match d = match_peaks(&results[0], p, tolerance, in->fs);
+        const int identical = same_peaks(&results[0], p);
+        const int identical_ref = ran[ref] && same_peaks(&results[ref], p);
+        const int pass = !ran[ref] || ((v->gate == GATE_EXACT) ? identical_ref
+                       : (v->gate == GATE_NONE) || (se >= se_of[ref] - h->max_drop
+                                                    && ppv >= ppv_of[ref] - h->max_drop));
+        failures += !pass;
+
+        fprintf(h->out, "{\"record\": \"%s\", \"variant\": \"%s\", \"fs\": %d, \"samples\": %zu, "
+                        "\"tolerance_ms\": %d, \"beats\": %d, \"detected\": %d, \"tp\": %d, \"fn\": %d, \"fp\": %d, "
+                        "\"sensitivity\": %.3f, \"ppv\": %.3f, \"mean_offset_ms\": %.3f, "
+                        "\"identical_to_baseline\": %s, \"baseline_missed\": %d, \"baseline_extra\": %d, "
+                        "\"reference\": \"%s\", \"identical_to_reference\": %s, "
+                        "\"samples_per_s\": %.0f, \"gate\": \"%s\", \"pass\": %s}\n",
+                in->name, v->name, in->fs, in->n, h->tolerance_ms, in->truth.R_count, p->R_count, m.tp, m.fn, m.fp,
+                se, ppv, m.mean_offset_ms, identical ? "true" : "false", d.fn, d.fp, variants[ref].name,
+                identical_ref ? "true" : "false", (double)in->n / seconds, gate_names[v->gate],
+                pass ? "true" : "false");
+        fprintf(stderr, "%-24s %-13s Se %7.3f %%  PPV %7.3f %%  %s %-8s %8.2f Méch/s%s\n", in->name, v->name, se,
+                ppv, identical_ref ? "=" : "≠", ref ? variants[ref].name : "réf.", (double)in->n / seconds * 1e-6,
+                pass ? "" : "  RÉGRESSION");
+    }
+
+    for (int k = 0; k < N_VARIANTS; k++) ecg_peaks_free(&results[k]);
+    return failures;
+}
+
+/* ===============================================================================
+ * Programme
+ * =============================================================================== */
+
+// Série synthétique par défaut : rythme nominal, bruit fort, fréquence MIT-BIH, dérive, tachycardie
+typedef struct {
+    const char *name;
+    int fs;
+    double hr_bpm, noise, wander;
+} Synth_Case;
+
+static const Synth_Case synth_cases[] = {
+    { "synth_nominal_500", 500,  75.0, 0.01, 0.1 },
+    { "synth_noisy_500",   500,  75.0, 0.15, 0.1 },
+    { "synth_nominal_360", 360,  75.0, 0.01, 0.1 },
+    { "synth_wander_500",  500,  75.0, 0.02, 1.0 },
+    { "synth_tachy_500",   500, 150.0, 0.02, 0.1 },
+};
+
+static int synth_input(const Synth_Case *c, Input *in) {
+    ECG_Synth_Params sp;
+    ecg_synth_defaults(&sp);
+    sp.sampling_rate_hz = c->fs;
+    sp.leads = 2;
+    sp.samples = (size_t)SYNTH_DURATION_S * (size_t)c->fs;
+    sp.heart_rate_bpm = c->hr_bpm;
+    sp.noise_std = c->noise;
+    sp.baseline_wander = c->wander;
+
+    ECG_Record rec;
+    ecg_record_init(&rec);
+    int rc = ecg_synth_generate(&sp, &rec, &in->truth);
+    if (rc == 0) {
+        snprintf(in->name, sizeof(in->name), "%s", c->name);
+        in->fs = c->fs;
+        in->n = sp.samples;
+        in->signal = malloc(sizeof(double) * in->n);
+        if (in->signal) memcpy(in->signal, rec.data[1], sizeof(double) * in->n);
+        else rc = -3;
+    }
+    ecg_record_free(&rec);
+    return rc;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--tolerance <ms>] [--lead <n>] [--fs <Hz>] [--min-time <s>] [--max-drop <points>]\n"
+                    "          [--variants nom1,nom2,...] [--out <rapport.jsonl>]\n"
+                    "          [<enregistrement> <annotations.atr|verite.json>]...\n"
+                    "Enregistrements : .csv (--fs, %d Hz par défaut), .ecgb ou en-tête WFDB .hea (formats 212 / 16).\n"
+                    "Sans enregistrement : série synthétique (%d s par cas). Chemins :", prog, SAMPLING_RATE, SYNTH_DURATION_S);
+    for (int k = 0; k < N_VARIANTS; k++) fprintf(stderr, " %s", variants[k].name);
+    fputc('\n', stderr);
+}
+
+int main(int argc, char *argv[]) {
+    Harness h;
+    memset(&h, 0, sizeof(h));
+    h.out = stdout;
+    h.min_time = DEFAULT_MIN_TIME_S;
+    h.max_drop = DEFAULT_MAX_DROP;
+    h.tolerance_ms = DEFAULT_TOLERANCE_MS;
+    h.lead = -1;
+    h.fs = SAMPLING_RATE;
+    for (int k = 0; k < N_VARIANTS; k++) h.enabled[k] = 1;
+
+    const char *out_path = NULL;
+    const char *files[64];
+    int n_files = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            h.tolerance_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lead") == 0 && i + 1 < argc) {
+            h.lead = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc) {
+            h.fs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            h.min_time = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-drop") == 0 && i + 1 < argc) {
+            h.max_drop = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--variants") == 0 && i + 1 < argc) {
+            const char *list = argv[++i];
+            for (int k = 0; k < N_VARIANTS; k++) {
+                const size_t len = strlen(variants[k].name);
+                const char *p = list;
+                h.enabled[k] = 0;
+                while ((p = strstr(p, variants[k].name)) != NULL) {
+                    if ((p == list || p[-1] == ',') && (p[len] == '\0' || p[len] == ',')) h.enabled[k] = 1;
+                    p += len;
+                }
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (argv[i][0] != '-' && n_files < (int)(sizeof(files) / sizeof(files[0]))) {
+            files[n_files++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // Les références des chemins retenus tournent aussi (placées avant eux dans variants)
+    for (int k = N_VARIANTS - 1; k > 0; k--)
+        if (h.enabled[k]) h.enabled[reference_index(&variants[k])] = 1;
+    if (n_files % 2 != 0 || h.tolerance_ms <= 0 || h.lead < -1 || h.fs <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (out_path && !(h.out = fopen(out_path, "w"))) {
+        perror("fopen");
+        return 1;
+    }
+
+    const int n_inputs = n_files ? n_files / 2 : (int)(sizeof(synth_cases) / sizeof(synth_cases[0]));
+    int rc = 0, failures = 0;
+    for (int r = 0; r < n_inputs && rc == 0; r++) {
+        Input in;
+        memset(&in, 0, sizeof(in));
+        if (ecg_peaks_init(&in.truth, 0) != 0) {
+            rc = 4;
+            break;
+        }
+
+        int st;
+        if (n_files) {
+            const char *record = files[2 * r], *annotations = files[2 * r + 1];
+            const char *base = strrchr(record, '/');
+            snprintf(in.name, sizeof(in.name), "%s", base ? base + 1 : record);
+            st = load_record(&h, record, &in);
+            if (st == 0) st = ends_with(annotations, ".json") ? read_truth_json(annotations, &in.truth)
+                                                             : read_wfdb_annotations(annotations, &in.truth);
+            if (st != 0) fprintf(stderr, "Erreur lecture %s / %s.\n", record, annotations);
+        } else {
+            st = synth_input(&synth_cases[r], &in);
+            if (st != 0) fprintf(stderr, "Erreur: génération de %s impossible.\n", synth_cases[r].name);
+        }
+        if (st == 0) st = prepare_input(&in);
+
+        const int f = (st == 0) ? evaluate(&h, &in) : -1;
+        if (f < 0) rc = 2;
+        else failures += f;
+        free_input(&in);
+    }
+
+    if (out_path) fclose(h.out);
+    if (rc == 0 && failures > 0) {
+        fprintf(stderr, "%d chemin(s) en régression (pics différents de leur référence, ou Se / PPV "
+                        "< référence - %.2f points).\n", failures, h.max_drop);
+        rc = 1;
+    }
+    return rc;
+}
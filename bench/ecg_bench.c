@@ -0,0 +1,301 @@
+/**
+ * @file    ecg_bench.c
+ * @brief   Banc de mesure par étape : parse CSV, filtres (par jeu d'instructions), détection, écriture JSON.
+ *
+ * Chaque mesure est répétée jusqu'à --min-time secondes (au moins 3 fois) et le meilleur temps est gardé.
+ * Sortie machine : une ligne JSON par mesure (stdout ou --out), tableau lisible sur stderr.
+ *
+ * Débit (GB/s) : octets lus + écrits par l'étape au niveau algorithmique
+ * (16 o/échantillon pour un filtre double -> double, 8 o/échantillon d'entrée pour l'analyse complète,
+ * taille du fichier pour le parse CSV et l'écriture JSON).
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "csv_reader.h"
+#include "ecg_processing.h"
+#include "ecg_synth.h"
+#include "ecg_utils.h"
+#include "json_writer.h"
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+#define DEFAULT_MIN_TIME_S  0.1
+#define MIN_REPETITIONS     3
+#define DEFAULT_CSV_MAX     1000000
+
+// Fenêtres identiques à ecg_processing.c (130 ms à la fréquence du banc)
+#define BENCH_WINDOW_MS     130
+
+static const size_t default_sizes[] = { 10000, 100000, 1000000, 10000000, 50000000 };
+
+/* ===============================================================================
+ * Outils
+ * =============================================================================== */
+
+typedef struct {
+    FILE *out;          // lignes JSON
+    double min_time;
+    size_t csv_max;
+    int fs;             // fréquence du signal de test (--fs, SAMPLING_RATE par défaut)
+} Bench;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void report(const Bench *b, const char *stage, const char *variant, size_t n, double seconds, double bytes) {
+    const double ns = seconds * 1e9 / (double)n;
+    const double gbs = bytes / seconds * 1e-9;
+    fprintf(b->out, "{\"stage\": \"%s\", \"variant\": \"%s\", \"fs\": %d, \"samples\": %zu, \"seconds\": %.9f, "
+                    "\"ns_per_sample\": %.4f, \"gb_per_s\": %.3f}\n", stage, variant, b->fs, n, seconds, ns, gbs);
+    fprintf(stderr, "%-12s %-8s %10zu  %10.4f ns/éch  %8.3f GB/s\n", stage, variant, n, ns, gbs);
+}
+
+/* ===============================================================================
+ * Mesures
+ * =============================================================================== */
+
+typedef void (*Kernel_Win)(const double *x, double *y, size_t n, size_t win);
+typedef void (*Kernel)(const double *x, double *y, size_t n);
+
+#define TIME_BEST(best, min_time, stmt)                                         \
+    do {                                                                        \
+        stmt; /* échauffement : pages touchées, caches */                       \
+        double total_ = 0.0;                                                    \
+        best = INFINITY;                                                        \
+        for (int rep_ = 0; rep_ < MIN_REPETITIONS || total_ < (min_time); rep_++) { \
+            const double t0_ = now_s();                                         \
+            stmt;                                                               \
+            const double dt_ = now_s() - t0_;                                   \
+            total_ += dt_;                                                      \
+            if (dt_ < best) best = dt_;                                         \
+        }                                                                       \
+    } while (0)
+
+/* Filtres de ecg_utils, un jeu d'instructions. Retourne la somme des 4 étapes (pour la détection). */
+static double bench_kernels(const Bench *b, const ECG_Kernels *k, const double *x, double *y, double *z, size_t n) {
+    const size_t win = (size_t)((BENCH_WINDOW_MS * b->fs) / 1000);
+    double t_hp, t_d, t_sq, t_mwi;
+    TIME_BEST(t_hp, b->min_time, k->highpass_ma(x, y, n, win));
+    report(b, "highpass_ma", k->name, n, t_hp, 16.0 * (double)n);
+    TIME_BEST(t_d, b->min_time, k->derivative_1(y, z, n));
+    report(b, "derivative_1", k->name, n, t_d, 16.0 * (double)n);
+    TIME_BEST(t_sq, b->min_time, k->square(z, y, n));
+    report(b, "square", k->name, n, t_sq, 16.0 * (double)n);
+    TIME_BEST(t_mwi, b->min_time, k->mwi(y, z, n, win));
+    report(b, "mwi", k->name, n, t_mwi, 16.0 * (double)n);
+    return t_hp + t_d + t_sq + t_mwi;
+}
+
+/*
+ * Analyse complète, chaîne multi-passes, noyau fusionné et détection décimée x4 (fusionnée, si fs s'y prête).
+ * La détection = analyse - filtres.
+ */
+static int bench_analyze(const Bench *b, const ECG_Kernels *k, const double *x, size_t n, double t_filters,
+                         ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    static const char *stages[] = { "analyze", "analyze_fused", "analyze_decim4" };
+    for (int v = 0; v < 3; v++) {
+        const int fused = v > 0;
+        const int decimation = (v == 2) ? 4 : 0;
+        if (decimation && b->fs % decimation != 0) continue;
+
+        ECG_Params params;
+        memset(&params, 0, sizeof(params));
+        params.sampling_rate_hz = b->fs;
+        params.leads = LEADS;
+        params.max_samples = n;
+        params.fused = fused;
+        params.isa = k->isa;
+        params.decimation = decimation;
+
+        ECG_Context *ctx = ecg_create(&params);
+        if (!ctx) {
+            fprintf(stderr, "Erreur: ecg_create() a échoué (%zu échantillons).\n", n);
+            return -1;
+        }
+
+        double t;
+        TIME_BEST(t, b->min_time, ecg_analyze(ctx, x, n, 1, peaks, intervals));
+        report(b, stages[v], k->name, n, t, 8.0 * (double)n);
+        if (!fused && t > t_filters) report(b, "detect", k->name, n, t - t_filters, 8.0 * (double)n);
+        ecg_destroy(ctx);
+    }
+    return 0;
+}
+
+/* Parse d'un CSV d'une dérivation (fichier temporaire, en cache page après l'échauffement). */
+static int bench_csv(const Bench *b, const double *x, size_t n) {
+    char path[] = "/tmp/ecg_bench_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *f = (fd >= 0) ? fdopen(fd, "w") : NULL;
+    if (!f) {
+        perror("mkstemp");
+        return -1;
+    }
+
+    // Même format que les exports : en-tête d'indices puis une ligne par dérivation
+    fputc(',', f);
+    for (size_t i = 0; i < n; i++) fprintf(f, i ? ",%zu" : "%zu", i);
+    fputs("\nlead1", f);
+    for (size_t i = 0; i < n; i++) fprintf(f, ",%.17g", x[i]);
+    fputc('\n', f);
+    const double bytes = (double)ftell(f);
+    fclose(f);
+
+    ECG_Record rec;
+    ecg_record_init(&rec);
+    double t;
+    int rc = 0;
+    TIME_BEST(t, b->min_time, rc |= read_csv_record(path, &rec));
+    if (rc == 0) report(b, "csv_parse", "-", n, t, bytes);
+
+    ecg_record_free(&rec);
+    unlink(path);
+    return rc;
+}
+
+static int bench_json(const Bench *b, size_t n, const ECG_Peaks *peaks, const ECG_Intervals *intervals) {
+    char path[] = "/tmp/ecg_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return -1;
+    }
+    close(fd);
+
+    double t;
+    int rc = 0;
+    TIME_BEST(t, b->min_time, rc |= write_json(path, peaks, intervals));
+
+    FILE *f = fopen(path, "r");
+    double bytes = 0.0;
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        bytes = (double)ftell(f);
+        fclose(f);
+    }
+    if (rc == 0) report(b, "json_write", "-", n, t, bytes);
+
+    unlink(path);
+    return rc;
+}
+
+/* ===============================================================================
+ * Programme
+ * =============================================================================== */
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--sizes n1,n2,...] [--isa all|scalar|avx2|avx512]\n"
+                    "          [--min-time <s>] [--csv-max <n>] [--fs <Hz>] [--out <fichier.jsonl>]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    Bench b = { stdout, DEFAULT_MIN_TIME_S, DEFAULT_CSV_MAX, SAMPLING_RATE };
+    size_t sizes[32];
+    int n_sizes = 0;
+    int isa_filter = -1; // -1 = tous les jeux disponibles
+    const char *out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            char *p = argv[++i];
+            while (*p && n_sizes < (int)(sizeof(sizes) / sizeof(sizes[0]))) {
+                char *end;
+                const unsigned long long v = strtoull(p, &end, 10);
+                if (end == p || v == 0) break;
+                sizes[n_sizes++] = (size_t)v;
+                p = (*end == ',') ? end + 1 : end;
+            }
+        } else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc) {
+            static const char *names[] = { "all", "scalar", "avx2", "avx512" };
+            const char *name = argv[++i];
+            isa_filter = -2;
+            for (int k = 0; k < (int)(sizeof(names) / sizeof(names[0])); k++)
+                if (strcmp(name, names[k]) == 0) isa_filter = k ? k : -1;
+            if (isa_filter == -2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            b.min_time = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv-max") == 0 && i + 1 < argc) {
+            b.csv_max = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc) {
+            b.fs = atoi(argv[++i]);
+            if (b.fs <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (n_sizes == 0) {
+        n_sizes = (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+        memcpy(sizes, default_sizes, sizeof(default_sizes));
+    }
+    if (out_path && !(b.out = fopen(out_path, "w"))) {
+        perror("fopen");
+        return 1;
+    }
+
+    ECG_Peaks peaks;
+    ECG_Intervals intervals;
+    if (ecg_peaks_init(&peaks, 0) != 0 || ecg_intervals_init(&intervals, 0) != 0) return 4;
+
+    // Signal reproductible du générateur (une dérivation, paramètres par défaut, graine fixe)
+    ECG_Record rec;
+    ecg_record_init(&rec);
+    ECG_Synth_Params synth;
+    ecg_synth_defaults(&synth);
+    synth.sampling_rate_hz = b.fs;
+    synth.leads = 1;
+
+    int rc = 0;
+    for (int s = 0; s < n_sizes && rc == 0; s++) {
+        const size_t n = sizes[s];
+        synth.samples = n;
+        double *y = malloc(sizeof(double) * n);
+        double *z = malloc(sizeof(double) * n);
+        if (!y || !z || ecg_synth_generate(&synth, &rec, NULL) != 0) {
+            fprintf(stderr, "Erreur: allocation de %zu échantillons impossible.\n", n);
+            free(y); free(z);
+            rc = 4;
+            break;
+        }
+        const double *x = rec.data[0];
+
+        if (n <= b.csv_max) rc |= bench_csv(&b, x, n);
+
+        for (int isa = ECG_ISA_SCALAR; isa <= ECG_ISA_AVX512 && rc == 0; isa++) {
+            const ECG_Kernels *k = ecg_kernels_get((ECG_Isa)isa);
+            if (!k || (isa_filter >= 0 && isa != isa_filter)) continue;
+            const double t_filters = bench_kernels(&b, k, x, y, z, n);
+            rc |= bench_analyze(&b, k, x, n, t_filters, &peaks, &intervals);
+        }
+
+        if (rc == 0) rc |= bench_json(&b, n, &peaks, &intervals);
+
+        free(y);
+        free(z);
+    }
+
+    ecg_record_free(&rec);
+    ecg_peaks_free(&peaks);
+    ecg_intervals_free(&intervals);
+    if (out_path) fclose(b.out);
+    return rc ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file    ecg_kernels_check.c
+ * @brief   Équivalence des noyaux SIMD (ecg_kernels_get) avec les fonctions scalaires de ecg_utils.
+ *
+ * Chaque table de noyaux disponible sur ce CPU est comparée à la table scalaire, sur des tailles qui couvrent
+ * les restes de boucle (0..70, autour des multiples de 8, grands signaux), des fenêtres de 1 à plus que le
+ * signal et plusieurs familles de signaux (ECG synthétique, bruit, forte composante continue, amplitudes
+ * très dispersées, plateaux pour les égalités, NaN) :
+ *  - gain, dérivée, carré, argmax : identiques bit à bit (NaN : même position) ;
+ *  - mwi_max : le maximum retourné est exactement celui du y qu'il écrit ;
+ *  - sommes glissantes (moyenne glissante, passe-haut, MWI) et remove_dc : écart borné
+ *    (bornes documentées sur ECG_Kernels, ecg_utils.h).
+ *
+ * Sortie machine : une ligne JSON par (jeu d'instructions, noyau), avec le plus grand écart rapporté à la borne ;
+ * tableau lisible sur stderr. Code de retour 1 si un noyau sort de son contrat. Aussi lancé par ctest.
+ */
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ecg_utils.h"
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+#define N_SMALL     71          // toutes les tailles de 0 à 70
+#define SYNTH_FS    500
+
+static const size_t large_sizes[] = { 127, 128, 129, 255, 256, 257, 1000, 4099, 100003 };
+static const size_t windows[] = { 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 65, 180 };
+
+typedef enum {
+    SIG_ECG = 0,    // pics R à 75 bpm, ligne de base
+    SIG_NOISE,      // uniforme [-1, 1]
+    SIG_OFFSET,     // 1000 + bruit : annulations dans les sommes glissantes
+    SIG_SPREAD,     // amplitudes de 1e-6 à 1e6
+    SIG_PLATEAU,    // valeurs quantifiées : égalités pour argmax
+    SIG_NAN,        // bruit avec quelques NaN (noyaux élément par élément et argmax uniquement)
+    SIG_COUNT
+} Signal_Kind;
+
+static const char *const signal_names[] = { "ecg", "noise", "offset", "spread", "plateau", "nan" };
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+// Bilan d'un noyau sur tous les cas
+typedef struct {
+    const char *kernel;
+    int cases;
+    int failures;
+    double worst_ratio;         // max |écart| / borne (0 pour les noyaux exacts)
+    char first_failure[160];
+} Check;
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static double uniform(void) {
+    // xorshift64* : reproductible d'une machine à l'autre
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (double)((rng_state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void make_signal(Signal_Kind kind, double *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const double u = 2.0 * uniform() - 1.0;
+        switch (kind) {
+        case SIG_ECG: {
+            const double t = fmod((double)i / SYNTH_FS, 0.8) - 0.3;
+            x[i] = 1.2 * exp(-t * t / (2.0 * 0.012 * 0.012)) + 0.1 * sin(2.0 * M_PI * 0.3 * (double)i / SYNTH_FS)
+                 + 0.02 * u;
+            break;
+        }
+        case SIG_NOISE:   x[i] = u; break;
+        case SIG_OFFSET:  x[i] = 1000.0 + u; break;
+        case SIG_SPREAD:  x[i] = u * pow(10.0, 12.0 * uniform() - 6.0); break;
+        case SIG_PLATEAU: x[i] = floor(4.0 * u); break;
+        default:          x[i] = (uniform() < 0.02) ? NAN : u; break;
+        }
+    }
+}
+
+static double max_abs(const double *x, size_t n) {
+    double m = 0.0;
+    for (size_t i = 0; i < n; i++)
+        if (fabs(x[i]) > m) m = fabs(x[i]);
+    return m;
+}
+
+// Identiques bit à bit, NaN comparés par position (la charge utile n'est pas spécifiée)
+static int same_bits(const double *a, const double *b, size_t n, size_t *where) {
+    for (size_t i = 0; i < n; i++) {
+        if (isnan(a[i]) && isnan(b[i])) continue;
+        if (memcmp(&a[i], &b[i], sizeof(double)) != 0) {
+            *where = i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void fail(Check *c, const char *isa, Signal_Kind kind, size_t n, size_t win, const char *what) {
+    if (c->failures++ == 0)
+        snprintf(c->first_failure, sizeof(c->first_failure), "%s/%s n=%zu win=%zu : %s", isa, signal_names[kind], n,
+                 win, what);
+}
+
+/*
+ * Somme glissante : chaque pas d'une version arrondit sa somme courante (<= win * M), les deux écarts
+ * s'ajoutent et croissent au plus linéairement avec i ; division par win, puis soustraction du passe-haut.
+ * Borne : ((2 + 16 / win) * (i + 1) + 2) * eps * M, M = max|x|.
+ */
+static void check_sliding(Check *c, const char *isa, Signal_Kind kind, const double *x, size_t n, size_t win,
+                          const double *ref, const double *y) {
+    const double m = max_abs(x, n);
+    char what[96];
+    for (size_t i = 0; i < n; i++) {
+        const double bound = ((2.0 + 16.0 / (double)win) * (double)(i + 1) + 2.0) * DBL_EPSILON * m;
+        const double err = fabs(y[i] - ref[i]);
+        if (!(err <= bound)) {
+            snprintf(what, sizeof(what), "y[%zu] = %.17g au lieu de %.17g", i, y[i], ref[i]);
+            fail(c, isa, kind, n, win, what);
+            return;
+        }
+        if (bound > 0.0 && err / bound > c->worst_ratio) c->worst_ratio = err / bound;
+    }
+}
+
+/* ===============================================================================
+ * Vérifications
+ * =============================================================================== */
+
+enum { K_GAIN, K_DERIVATIVE, K_SQUARE, K_ARGMAX, K_MWI_MAX, K_MOVING_AVERAGE, K_HIGHPASS, K_MWI, K_REMOVE_DC, K_COUNT };
+
+static const char *const kernel_names[] = {
+    "apply_gain", "derivative_1", "square", "argmax", "mwi_max", "moving_average", "highpass_ma", "mwi", "remove_dc"
+};
+
+static void check_size(const ECG_Kernels *s, const ECG_Kernels *k, Signal_Kind kind, size_t n, Check *checks,
+                       double *x, double *ref, double *y) {
+    char what[96];
+    size_t at = 0;
+    make_signal(kind, x, n);
+
+    // Élément par élément : identiques bit à bit
+    memcpy(ref, x, sizeof(double) * n);
+    memcpy(y, x, sizeof(double) * n);
+    s->apply_gain(ref, n, 1.7);
+    k->apply_gain(y, n, 1.7);
+    checks[K_GAIN].cases++;
+    if (!same_bits(ref, y, n, &at)) {
+        snprintf(what, sizeof(what), "différent à l'indice %zu", at);
+        fail(&checks[K_GAIN], k->name, kind, n, 0, what);
+    }
+
+    s->derivative_1(x, ref, n);
+    k->derivative_1(x, y, n);
+    checks[K_DERIVATIVE].cases++;
+    if (!same_bits(ref, y, n, &at)) {
+        snprintf(what, sizeof(what), "différent à l'indice %zu", at);
+        fail(&checks[K_DERIVATIVE], k->name, kind, n, 0, what);
+    }
+
+    s->square(x, ref, n);
+    k->square(x, y, n);
+    checks[K_SQUARE].cases++;
+    if (!same_bits(ref, y, n, &at)) {
+        snprintf(what, sizeof(what), "différent à l'indice %zu", at);
+        fail(&checks[K_SQUARE], k->name, kind, n, 0, what);
+    }
+
+    // argmax : même indice, y compris sur les égalités et les NaN
+    checks[K_ARGMAX].cases++;
+    const size_t ia = s->argmax(x, n), ib = k->argmax(x, n);
+    if (ia != ib) {
+        snprintf(what, sizeof(what), "indice %zu au lieu de %zu", ib, ia);
+        fail(&checks[K_ARGMAX], k->name, kind, n, 0, what);
+    }
+
+    // Sommes glissantes : signal sans NaN
+    if (kind == SIG_NAN) return;
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        const size_t win = windows[w];
+
+        s->moving_average(x, ref, n, win);
+        k->moving_average(x, y, n, win);
+        checks[K_MOVING_AVERAGE].cases++;
+        check_sliding(&checks[K_MOVING_AVERAGE], k->name, kind, x, n, win, ref, y);
+
+        s->highpass_ma(x, ref, n, win);
+        k->highpass_ma(x, y, n, win);
+        checks[K_HIGHPASS].cases++;
+        check_sliding(&checks[K_HIGHPASS], k->name, kind, x, n, win, ref, y);
+
+        s->mwi(x, ref, n, win);
+        k->mwi(x, y, n, win);
+        checks[K_MWI].cases++;
+        check_sliding(&checks[K_MWI], k->name, kind, x, n, win, ref, y);
+
+        // mwi_max : y borné comme la MWI, maximum exactement max(0, max(y))
+        const double mk = k->mwi_max(x, y, n, win);
+        s->mwi(x, ref, n, win);
+        checks[K_MWI_MAX].cases++;
+        check_sliding(&checks[K_MWI_MAX], k->name, kind, x, n, win, ref, y);
+        double expected = 0.0;
+        for (size_t i = 0; i < n; i++)
+            if (y[i] > expected) expected = y[i];
+        if (memcmp(&mk, &expected, sizeof(double)) != 0) {
+            snprintf(what, sizeof(what), "max %.17g au lieu de %.17g", mk, expected);
+            fail(&checks[K_MWI_MAX], k->name, kind, n, win, what);
+        }
+    }
+
+    // remove_dc : moyenne réassociée (plusieurs accumulateurs), borne (n + 4) * eps * M
+    memcpy(ref, x, sizeof(double) * n);
+    memcpy(y, x, sizeof(double) * n);
+    s->remove_dc(ref, n);
+    k->remove_dc(y, n);
+    checks[K_REMOVE_DC].cases++;
+    const double bound = ((double)n + 4.0) * DBL_EPSILON * max_abs(x, n);
+    for (size_t i = 0; i < n; i++) {
+        const double err = fabs(y[i] - ref[i]);
+        if (!(err <= bound)) {
+            snprintf(what, sizeof(what), "x[%zu] = %.17g au lieu de %.17g", i, y[i], ref[i]);
+            fail(&checks[K_REMOVE_DC], k->name, kind, n, 0, what);
+            break;
+        }
+        if (bound > 0.0 && err / bound > checks[K_REMOVE_DC].worst_ratio)
+            checks[K_REMOVE_DC].worst_ratio = err / bound;
+    }
+}
+
+/* ===============================================================================
+ * Programme
+ * =============================================================================== */
+
+int main(int argc, char *argv[]) {
+    FILE *out = stdout;
+    if (argc == 3 && strcmp(argv[1], "--out") == 0) {
+        if (!(out = fopen(argv[2], "w"))) {
+            perror("fopen");
+            return 1;
+        }
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--out <rapport.jsonl>]\n", argv[0]);
+        return 1;
+    }
+
+    size_t n_max = N_SMALL;
+    for (size_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); i++)
+        if (large_sizes[i] > n_max) n_max = large_sizes[i];
+    double *x = malloc(sizeof(double) * n_max);
+    double *ref = malloc(sizeof(double) * n_max);
+    double *y = malloc(sizeof(double) * n_max);
+    if (!x || !ref || !y) {
+        fprintf(stderr, "Erreur: allocation impossible.\n");
+        return 2;
+    }
+
+    const ECG_Kernels *scalar = ecg_kernels_get(ECG_ISA_SCALAR);
+    const ECG_Isa isas[] = { ECG_ISA_AVX2, ECG_ISA_AVX512 };
+    int failures = 0, tested = 0;
+    for (size_t t = 0; t < sizeof(isas) / sizeof(isas[0]); t++) {
+        const ECG_Kernels *k = ecg_kernels_get(isas[t]);
+        if (!k) continue;
+        tested++;
+
+        Check checks[K_COUNT];
+        memset(checks, 0, sizeof(checks));
+        for (int c = 0; c < K_COUNT; c++) checks[c].kernel = kernel_names[c];
+
+        for (int kind = 0; kind < SIG_COUNT; kind++) {
+            for (size_t n = 0; n < N_SMALL; n++) check_size(scalar, k, (Signal_Kind)kind, n, checks, x, ref, y);
+            for (size_t i = 0; i < sizeof(large_sizes) / sizeof(large_sizes[0]); i++)
+                check_size(scalar, k, (Signal_Kind)kind, large_sizes[i], checks, x, ref, y);
+        }
+
+        for (int c = 0; c < K_COUNT; c++) {
+            const Check *ck = &checks[c];
+            failures += ck->failures > 0;
+            fprintf(out, "{\"isa\": \"%s\", \"kernel\": \"%s\", \"cases\": %d, \"failures\": %d, "
+                         "\"worst_error_over_bound\": %.3e, \"pass\": %s}\n",
+                    k->name, ck->kernel, ck->cases, ck->failures, ck->worst_ratio, ck->failures ? "false" : "true");
+            fprintf(stderr, "%-8s %-15s %6d cas  écart/borne %.2e  %s%s\n", k->name, ck->kernel, ck->cases,
+                    ck->worst_ratio, ck->failures ? "ÉCHEC " : "ok", ck->failures ? ck->first_failure : "");
+        }
+    }
+    if (tested == 0) fprintf(stderr, "Aucun jeu SIMD disponible : seule la version scalaire est utilisée.\n");
+
+    free(x);
+    free(ref);
+    free(y);
+    if (out != stdout) fclose(out);
+    return failures ? 1 : 0;
+}
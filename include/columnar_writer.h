@@ -0,0 +1,91 @@
+/**
+ * @file    columnar_writer.h
+ * @brief   Sortie binaire en colonnes des résultats d'analyse (alternative à json_writer.h).
+ * @details Le consommateur projette le fichier et lit les tableaux sans aucun parse
+ *          (numpy.frombuffer, mmap + cast en C). Disposition (ordre des octets de l'hôte) :
+ *          - en-tête ECG_Columnar_Header (64 octets) ;
+ *          - répertoire de n_columns entrées ECG_Columnar_Column (32 octets chacune) ;
+ *          - données de chaque colonne, début aligné sur ECG_COLUMNAR_ALIGN octets.
+ *
+ *          Colonnes, dans cet ordre : "R", "P", "Q", "S", "T" (int32, indices d'échantillons)
+ *          puis "RR" (float32, secondes). Après délinéation, P, Q, S et T ont la longueur de R et leur
+ *          élément k appartient au battement R[k] (-1, ECG_WAVE_NONE, pour une onde absente) ;
+ *          colonnes vides sans délinéation.
+ *
+ */
+
+#ifndef COLUMNAR_WRITER_H
+#define COLUMNAR_WRITER_H
+
+#include <stdint.h>
+#include "output_structs.h"
+
+/* ================================
+ * Constantes
+ * ================================ */
+
+/** @brief Signature en tête de fichier. */
+#define ECG_COLUMNAR_MAGIC    "ECGRES\0\0"
+
+/** @brief Version du format. */
+#define ECG_COLUMNAR_VERSION  1u
+
+/** @brief Alignement (octets) du début de chaque colonne. */
+#define ECG_COLUMNAR_ALIGN    64
+
+/** @brief Nombre de colonnes écrites (R, P, Q, S, T, RR). */
+#define ECG_COLUMNAR_COLUMNS  6
+
+/* ================================
+ * Types
+ * ================================ */
+/**
+ * @brief Type des éléments d'une colonne.
+ */
+typedef enum {
+    ECG_COLUMN_INT32   = 1, /**< int32_t. */
+    ECG_COLUMN_FLOAT32 = 2  /**< float. */
+} ECG_Column_Type;
+
+/**
+ * @brief En-tête du fichier (64 octets).
+ */
+typedef struct {
+    char     magic[8];          /**< ECG_COLUMNAR_MAGIC. */
+    uint32_t version;           /**< ECG_COLUMNAR_VERSION. */
+    uint32_t n_columns;         /**< Nombre d'entrées du répertoire. */
+    uint32_t sampling_rate_hz;  /**< Fréquence d'échantillonnage des indices. */
+    uint8_t  reserved[44];      /**< Zéros. */
+} ECG_Columnar_Header;
+
+/**
+ * @brief Entrée du répertoire des colonnes (32 octets) : nom, type, longueur et position.
+ */
+typedef struct {
+    char     name[8];   /**< Nom de la colonne, complété par des '\0'. */
+    uint32_t type;      /**< ECG_Column_Type. */
+    uint32_t reserved;  /**< Zéro. */
+    uint64_t count;     /**< Nombre d'éléments. */
+    uint64_t offset;    /**< Position des données depuis le début du fichier (multiple de ECG_COLUMNAR_ALIGN). */
+} ECG_Columnar_Column;
+
+/* ================================
+ * API Publique
+ * ================================ */
+/**
+ * @brief Écrit les résultats d'analyse en colonnes binaires.
+ *
+ * Le fichier est assemblé en mémoire puis écrit en un seul write() ; appel réentrant.
+ *
+ * @param[in] filename          Chemin du fichier de sortie.
+ * @param[in] peaks             Pics détectés (non NULL).
+ * @param[in] intervals         Intervalles calculés (non NULL).
+ * @param[in] sampling_rate_hz  Fréquence inscrite dans l'en-tête.
+ *
+ * @return 0 en cas de succès,
+ * @return valeur négative en cas d'erreur
+ */
+int write_columnar(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals,
+                   int sampling_rate_hz);
+
+#endif /* COLUMNAR_WRITER_H */
@@ -4,9 +4,10 @@
  *
  * @file    csv_reader.h
  * @brief   Interface du module de lecture de fichiers CSV pour données ECG.
- * @details Ce module fournit les fonctions et variables nécessaires pour
- *          charger des données ECG depuis un fichier CSV et les stocker
- *          dans des structures globales exploitables par le reste du programme.
+ * @details Ce module fournit les fonctions nécessaires pour charger des données ECG
+ *          depuis un fichier CSV dans un ECG_Record. Aucun état global : chaque enregistrement
+ *          possède ses tableaux et ses buffers d'E/S, les lectures de threads différents
+ *          (un enregistrement chacun) sont indépendantes.
  *
  */
 
@@ -14,42 +15,141 @@
 #ifndef CSV_READER_H
 #define CSV_READER_H
 
+#include <stddef.h>
 #include "output_structs.h"
 
 /* ================================
- * Variables globales
+ * Types
  * ================================ */
-/**
- * @brief Données ECG lues depuis le fichier CSV.
- *
- * Tableau contenant les échantillons ECG pour chaque dérivation.
- * - Dimension 1 : nombre de dérivations (LEADS)
- * - Dimension 2 : nombre maximal d'échantillons (MAX_SAMPLES)
- */
-extern double ecg_data[LEADS][MAX_SAMPLES];
+
+/** @brief Masque de dérivations : toutes (bit l = dérivation l sinon, voir read_csv_record_leads()). */
+#define ECG_LEADS_ALL 0u
 
 /**
- * @brief Nombre d'échantillons effectivement lus.
+ * @brief Enregistrement ECG chargé depuis un fichier (réentrant).
+ *
+ * Possède ses tableaux d'échantillons ainsi que ses buffers d'E/S (ligne et buffer stdio),
+ * conservés d'une lecture à l'autre : relire un fichier de taille similaire n'alloue rien.
+ * Un enregistrement par thread permet des lectures parallèles.
  *
- * Cette variable indique combien d'échantillons valides ont été chargés
- * dans le tableau ecg_data.
+ * data[] est la vue lue par l'analyse : elle pointe sur les buffers propres (buffer[]),
+ * ou directement dans la projection d'un fichier binaire float64 (map, voir ecg_binary.h).
+ * Après une lecture partielle (masque de dérivations), les dérivations non demandées restent brutes
+ * dans la projection (pending) : ecg_record_lead() les décode au premier accès.
  */
-extern int sample_count;
+typedef struct ECG_Record {
+    double *data[LEADS];      /**< Échantillons de chaque dérivation (vue en lecture). */
+    double *buffer[LEADS];    /**< Buffers propres de chaque dérivation. */
+    size_t  capacity[LEADS];  /**< Capacité allouée de chaque buffer. */
+    int     leads;            /**< Nombre de dérivations lues. */
+    int     samples;          /**< Nombre d'échantillons par dérivation. */
+    int     sampling_rate_hz; /**< Fréquence d'échantillonnage du fichier (0 = inconnue, CSV). */
+
+    char   *line;             /**< Buffer de ligne réutilisé (getline, entrées non mappables). */
+    size_t  line_cap;         /**< Capacité du buffer de ligne. */
+    char   *filebuf;          /**< Buffer stdio réutilisé (1 MiB, entrées non mappables). */
+
+    void   *map;              /**< Projection du fichier courant : binaire float64, ou fichier dont des
+                                   dérivations restent à décoder (NULL sinon). */
+    size_t  map_size;         /**< Taille de la projection. */
+
+    unsigned    pending;          /**< Bit l : dérivation l pas encore décodée (data[l] vaut NULL). */
+    const char *raw_begin[LEADS]; /**< Données brutes des dérivations en attente, dans map. */
+    const char *raw_end[LEADS];   /**< Fin des données brutes. */
+    int         raw_dtype;        /**< Format brut (ECG_Dtype d'un binaire, -1 pour une ligne CSV). */
+    double      raw_scale;        /**< Échelle des échantillons int16 bruts. */
+    int       (*decode)(struct ECG_Record *rec, int lead); /**< Décodeur de la lecture en cours. */
+} ECG_Record;
 
 /* ================================
  * API Publique
  * ================================ */
 /**
- * @brief Lit un fichier CSV contenant des données ECG.
+ * @brief Initialise un enregistrement vide (aucune allocation).
+ *
+ * @param[out] rec Enregistrement à initialiser (non NULL).
+ */
+void ecg_record_init(ECG_Record *rec);
+
+/**
+ * @brief Garantit une capacité d'au moins @p n échantillons pour la dérivation @p lead.
+ *
+ * Le buffer propre est agrandi (doublement) et data[lead] repointe dessus.
+ *
+ * @return 0 en cas de succès, valeur négative en cas d'échec d'allocation.
+ */
+int ecg_record_reserve(ECG_Record *rec, int lead, size_t n);
+
+/**
+ * @brief Libère la projection d'un fichier binaire éventuelle : data[] repointe sur les buffers propres.
+ *
+ * Appelée au début de chaque lecture, les vues obtenues avant ne sont alors plus valides.
+ */
+void ecg_record_unmap(ECG_Record *rec);
+
+/**
+ * @brief Lit un fichier CSV dans un enregistrement (réentrant, sans état global).
  *
- * Cette fonction ouvre un fichier CSV, parse son contenu et remplit
- * le tableau ecg_data ainsi que la variable sample_count.
+ * Les tableaux et buffers déjà alloués dans @p rec sont réutilisés et agrandis si nécessaire.
+ * Les valeurs sont converties par parse_double() (indépendant de la locale, arrondi identique à strtod).
+ * Un fichier régulier est mappé (mmap) et ses lignes de dérivation sont parsées en parallèle
+ * (OpenMP, au-delà de 1 MiB) directement dans les tableaux ; les autres entrées (tube...) passent par stdio.
  *
- * @param[in] filename Chemin vers le fichier CSV à lire.
+ * @param[in]     filename Chemin vers le fichier CSV à lire.
+ * @param[in,out] rec      Enregistrement initialisé (non NULL).
  *
  * @return 0 en cas de succès,
- * @return valeur négative en cas d'erreur (fichier introuvable, format invalide, etc.).
+ * @return -4 si une dérivation n'a pas le même nombre d'échantillons que la première,
+ * @return autre valeur négative en cas d'erreur (fichier, allocation, fichier vide).
+ */
+int read_csv_record(const char *filename, ECG_Record *rec);
+
+/**
+ * @brief Lit un fichier CSV en ne décodant que les dérivations de @p lead_mask.
+ *
+ * @details Les lignes non demandées ne sont que repérées (memchr du retour à la ligne), sans conversion
+ *          numérique : une analyse de la seule dérivation II parse 12 fois moins de valeurs. Elles restent
+ *          accessibles par ecg_record_lead(), qui les décode au premier accès (fichier régulier, projection
+ *          gardée jusqu'à la lecture suivante). Entrée non mappable (tube) : elles sont sautées et perdues.
+ *          rec->leads compte toutes les lignes du fichier, rec->samples vient des dérivations décodées.
+ *
+ * @param[in]     filename   Chemin vers le fichier CSV à lire.
+ * @param[in,out] rec        Enregistrement initialisé (non NULL).
+ * @param[in]     lead_mask  Bit l = dérivation l décodée à la lecture, ECG_LEADS_ALL pour toutes.
+ *
+ * @return Comme read_csv_record() ; -2 si aucune dérivation demandée n'existe dans le fichier.
+ */
+int read_csv_record_leads(const char *filename, ECG_Record *rec, unsigned lead_mask);
+
+/**
+ * @brief Échantillons d'une dérivation, décodés à la demande s'ils ne l'ont pas été à la lecture.
+ *
+ * @details Le décodage écrit dans l'enregistrement : pas d'appels concurrents sur un même enregistrement
+ *          (décoder les dérivations voulues avant de les partager entre threads).
+ *
+ * @return rec->data[lead], ou NULL si @p lead est hors limites, perdu (tube) ou de longueur différente
+ *         des dérivations déjà lues.
+ */
+const double *ecg_record_lead(ECG_Record *rec, int lead);
+
+/**
+ * @brief Écrit un enregistrement au format CSV lu par read_csv_record().
+ *
+ * En-tête des indices d'échantillons puis une ligne par dérivation ("lead1", "lead2", ...),
+ * valeurs en "%.17g" (relues à l'identique).
+ *
+ * @param[in] filename Fichier de sortie.
+ * @param[in] rec      Enregistrement chargé ou généré (non NULL).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d'erreur.
+ */
+int write_csv_record(const char *filename, const ECG_Record *rec);
+
+/**
+ * @brief Libère les tableaux et buffers d'un enregistrement.
+ *
+ * @param[in,out] rec Enregistrement à libérer (réinitialisé ensuite).
  */
-int read_csv(const char *filename);
+void ecg_record_free(ECG_Record *rec);
 
 #endif /* CSV_READER_H */
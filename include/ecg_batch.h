@@ -0,0 +1,44 @@
+/**
+ * @file    ecg_batch.h
+ * @brief   Mode batch : analyse de nombreux enregistrements CSV dans un seul processus.
+ * @details Un pool de workers (OpenMP) se répartit les fichiers ; chaque worker possède son
+ *          ECG_Context et son ECG_Record (buffers de parse) réutilisés d'un fichier à l'autre.
+ *          On évite ainsi le démarrage de processus, les allocations et les ouvertures de sortie
+ *          qui dominent le temps d'exécution sur des fichiers de cette taille.
+ *
+ */
+
+#ifndef ECG_BATCH_H
+#define ECG_BATCH_H
+
+#include "ecg_processing.h"
+
+/* ================================
+ * Types
+ * ================================ */
+/**
+ * @brief Options du mode batch.
+ */
+typedef struct {
+    ECG_Params params;  /**< Paramètres d'analyse (max_samples adapté par worker). */
+    int lead_index;     /**< Dérivation analysée (0..LEADS-1). */
+    int jobs;           /**< Nombre de workers (0 = nombre de cœurs). */
+} ECG_Batch_Options;
+
+/* ================================
+ * API Publique
+ * ================================ */
+/**
+ * @brief Analyse une liste d'enregistrements avec un pool de workers.
+ *
+ * @param[in] input   Dossier (tous les fichiers *.csv et *.ecgb, triés) ou fichier liste (un chemin par ligne).
+ * @param[in] output  Fichier *.jsonl (une ligne JSON par enregistrement, ordre d'achèvement)
+ *                    ou dossier (un fichier <nom>.json par enregistrement, créé si absent).
+ * @param[in] opt     Options (non NULL).
+ *
+ * @return Nombre d'enregistrements en échec (0 = tout est OK),
+ * @return valeur négative si l'entrée ou la sortie est inutilisable.
+ */
+int ecg_batch_run(const char *input, const char *output, const ECG_Batch_Options *opt);
+
+#endif /* ECG_BATCH_H */
@@ -0,0 +1,108 @@
+/**
+ * @file    ecg_binary.h
+ * @brief   Format binaire compact des enregistrements ECG (conversion CSV -> binaire et chargement sans copie).
+ * @details Disposition du fichier (ordre des octets de l'hôte, little-endian en pratique) :
+ *          - un en-tête ECG_Bin_Header de 64 octets ;
+ *          - puis, pour chaque dérivation, un bloc contigu de n_samples échantillons,
+ *            chaque bloc commençant à un multiple de ECG_BIN_ALIGN octets (chargements SIMD alignés).
+ *
+ *          Un fichier float64 est projeté (mmap) et l'analyse lit directement dans la projection ;
+ *          int16 (valeur = échantillon x scale) et float32 sont convertis en double au chargement.
+ *
+ */
+
+#ifndef ECG_BINARY_H
+#define ECG_BINARY_H
+
+#include <stdint.h>
+#include "csv_reader.h"
+
+/* ================================
+ * Constantes
+ * ================================ */
+
+/** @brief Signature en tête de fichier. */
+#define ECG_BIN_MAGIC     "ECGBIN\0\0"
+
+/** @brief Version du format (un fichier d'ordre des octets inversé est rejeté via ce champ). */
+#define ECG_BIN_VERSION   1u
+
+/** @brief Alignement (octets) de l'en-tête et de chaque bloc de dérivation. */
+#define ECG_BIN_ALIGN     64
+
+/** @brief Extension conventionnelle des fichiers binaires. */
+#define ECG_BIN_EXTENSION ".ecgb"
+
+/* ================================
+ * Types
+ * ================================ */
+/**
+ * @brief Type des échantillons stockés.
+ */
+typedef enum {
+    ECG_DTYPE_I16 = 1, /**< Entier 16 bits, valeur physique = échantillon x scale. */
+    ECG_DTYPE_F32 = 2, /**< Flottant simple précision. */
+    ECG_DTYPE_F64 = 3  /**< Flottant double précision (chargement sans copie). */
+} ECG_Dtype;
+
+/**
+ * @brief En-tête du fichier (64 octets).
+ */
+typedef struct {
+    char     magic[8];         /**< ECG_BIN_MAGIC. */
+    uint32_t version;          /**< ECG_BIN_VERSION. */
+    uint32_t dtype;            /**< ECG_Dtype. */
+    uint32_t leads;            /**< Nombre de dérivations (1..LEADS). */
+    uint32_t sampling_rate_hz; /**< Fréquence d'échantillonnage. */
+    uint64_t samples;          /**< Échantillons par dérivation. */
+    double   scale;            /**< Facteur d'échelle int16 (1.0 pour les flottants). */
+    uint64_t lead_stride;      /**< Octets entre deux blocs de dérivation (multiple de ECG_BIN_ALIGN). */
+    uint64_t data_offset;      /**< Début du premier bloc (multiple de ECG_BIN_ALIGN). */
+    uint8_t  reserved[8];      /**< Zéros. */
+} ECG_Bin_Header;
+
+/* ================================
+ * API Publique
+ * ================================ */
+/**
+ * @brief Écrit un enregistrement au format binaire.
+ *
+ * @param[in] filename          Fichier de sortie.
+ * @param[in] rec               Enregistrement chargé (non NULL).
+ * @param[in] dtype             Type des échantillons stockés.
+ * @param[in] sampling_rate_hz  Fréquence d'échantillonnage à inscrire (> 0).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d'erreur.
+ */
+int ecg_binary_write(const char *filename, const ECG_Record *rec, ECG_Dtype dtype, int sampling_rate_hz);
+
+/**
+ * @brief Charge un fichier binaire dans un enregistrement.
+ *
+ * float64 : rec->data[] pointe dans la projection du fichier (valide jusqu'à la lecture
+ * suivante ou ecg_record_free()). int16/float32 : conversion dans les buffers propres.
+ * rec->sampling_rate_hz reçoit la fréquence de l'en-tête.
+ *
+ * @return 0 en cas de succès, valeur négative si le fichier est illisible ou invalide.
+ */
+int ecg_binary_load(const char *filename, ECG_Record *rec);
+
+/**
+ * @brief Charge un enregistrement CSV ou binaire (détecté par la signature).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d'erreur.
+ */
+int ecg_record_load(const char *filename, ECG_Record *rec);
+
+/**
+ * @brief ecg_record_load() en ne décodant que les dérivations de @p lead_mask (voir read_csv_record_leads()).
+ *
+ * Binaire float64 : toutes les dérivations sont projetées sans copie (pages lues à la demande), le masque
+ * est sans effet. int16 / float32 : seules les dérivations demandées sont converties au chargement,
+ * les autres par ecg_record_lead() au premier accès.
+ *
+ * @return 0 en cas de succès, valeur négative en cas d'erreur.
+ */
+int ecg_record_load_leads(const char *filename, ECG_Record *rec, unsigned lead_mask);
+
+#endif /* ECG_BINARY_H */
@@ -0,0 +1,122 @@
+/**
+ * @file    ecg_delineation.h
+ * @brief   Délinéation des ondes P, Q, S et T autour des pics R détectés.
+ * @details Étape exécutée après la détection des R : pour chaque battement, des fenêtres de recherche
+ *          bornées (durées en ms, adaptées à l'intervalle RR local) sont parcourues :
+ *          - Q : minimum du passe-haut de la chaîne (x - MA 130 ms, recentrée) dans les 80 ms avant R ;
+ *          - S : minimum du passe-haut dans les 80 ms après R ;
+ *          - T : maximum de S + 40 ms à R + min(0.6 RR suivant, 450 ms) ;
+ *          - P : maximum de R - min(0.35 RR précédent, 350 ms) à Q - 20 ms.
+ *          T et P ne sont pas cherchées sur la bande de la chaîne : le passe-haut x - MA 130 ms (coupure
+ *          ~3 Hz) atténue ces ondes lentes (1 à 5 Hz) au point que leur sommet s'y déplace vers les fronts du
+ *          QRS. Leur maximum est cherché sur le signal brut dont on retire la droite joignant les bords de la
+ *          fenêtre (ligne de base locale, insensible à la dérive) ; la haute fréquence du bruit n'est pas
+ *          filtrée pour ces deux ondes.
+ *
+ *          Coût O(battements × fenêtre), aucune allocation : les tableaux P/Q/S/T de ECG_Peaks ont déjà
+ *          la capacité des R. Appariement : une entrée par R dans chaque tableau, P[k]..T[k] appartenant au
+ *          battement R[k] (P_count == Q_count == S_count == T_count == R_count). Une onde dont la fenêtre
+ *          (tronquée au signal) est vide, aux bords du signal, vaut ECG_WAVE_NONE (-1).
+ *
+ */
+
+#ifndef ECG_DELINEATION_H
+#define ECG_DELINEATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ecg_processing.h"
+
+/* ================================
+ * API Publique
+ * ================================ */
+
+/**
+ * @brief Taille (en échantillons) du buffer de travail des variantes *_raw.
+ *
+ * Couvre deux fois la fenêtre d'un battement (350 ms avant R, 450 ms après) à la fréquence donnée :
+ * bande de recherche de Q/S et copie double du signal brut (variantes float et int16).
+ *
+ * @param[in] sampling_rate_hz  Fréquence d'échantillonnage (> 0).
+ * @return Nombre de doubles à allouer, 0 si la fréquence est invalide.
+ */
+size_t ecg_delineation_scratch_size(int sampling_rate_hz);
+
+/**
+ * @brief Délinéation à partir du passe-haut de la chaîne multi-passes (pas de nouveau filtrage).
+ *
+ * La bande de recherche est x - MA centrée : la moyenne glissante causale de la chaîne se déduit de
+ * MA[j] = x[j] - hp[j] et est recentrée de low_pass_window / 2 échantillons (pas de décalage de Q et S
+ * dû au retard du filtre).
+ *
+ * @param[in]     signal            Signal brut analysé (non NULL).
+ * @param[in]     high_pass         Passe-haut causal x - MA(x) de @p signal (non NULL).
+ * @param[in]     n_samples         Nombre d'échantillons.
+ * @param[in]     sampling_rate_hz  Fréquence d'échantillonnage (> 0).
+ * @param[in]     low_pass_window   Fenêtre de la moyenne glissante du passe-haut (échantillons).
+ * @param[out]    scratch           Buffer de travail de ecg_delineation_scratch_size() doubles (non NULL).
+ * @param[in,out] peaks             Pics R en entrée (croissants), P/Q/S/T parallèles à R en sortie (non NULL).
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM.
+ */
+ECG_Status ecg_delineate(const double *signal, const double *high_pass, size_t n_samples, int sampling_rate_hz,
+                         size_t low_pass_window, double *scratch, ECG_Peaks *peaks);
+
+/**
+ * @brief ecg_delineate() sur les battements [first_beat, end_beat) seulement (délinéation découpée entre threads).
+ *
+ * Chaque battement voit ses voisins R[k - 1] et R[k + 1] (fenêtres de P et T) quelle que soit la plage :
+ * des plages disjointes traitées en parallèle donnent le même résultat qu'un seul appel sur tous les R.
+ * P/Q/S/T ne sont écrits qu'aux indices de la plage et les compteurs ne sont pas modifiés : l'appelant
+ * les fixe à R_count une fois toutes les plages traitées.
+ *
+ * @param[in]     high_pass         Passe-haut causal de @p signal sur [high_pass_begin, ...) : l'échantillon j
+ *                                  est high_pass[j - high_pass_begin] (doit couvrir les fenêtres QRS de la
+ *                                  plage, plus low_pass_window / 2 échantillons).
+ * @param[in]     high_pass_begin   Indice dans @p signal du premier échantillon de @p high_pass.
+ * @param[in]     first_beat        Premier battement traité.
+ * @param[in]     end_beat          Fin (exclue) de la plage, first_beat <= end_beat <= peaks->R_count.
+ *
+ * Autres paramètres : voir ecg_delineate().
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM (fréquence ou plage invalide).
+ */
+ECG_Status ecg_delineate_beats(const double *signal, const double *high_pass, size_t high_pass_begin,
+                              size_t n_samples, int sampling_rate_hz, size_t low_pass_window,
+                              int first_beat, int end_beat, double *scratch, ECG_Peaks *peaks);
+
+/**
+ * @brief Délinéation sur le signal brut : la moyenne glissante n'est recalculée que sur la fenêtre QRS de chaque battement.
+ *
+ * Pour les chemins qui ne gardent pas le passe-haut complet (noyau fusionné, précision réduite,
+ * analyse par fenêtres). Même bande que ecg_delineate() (écart d'arrondi près, la somme glissante
+ * repartant du début de chaque fenêtre).
+ *
+ * @param[in]     signal            Signal brut (non NULL).
+ * @param[in]     n_samples         Nombre d'échantillons.
+ * @param[in]     sampling_rate_hz  Fréquence d'échantillonnage (> 0).
+ * @param[in]     low_pass_window   Fenêtre de la moyenne glissante du passe-haut (échantillons).
+ * @param[out]    scratch           Buffer de travail de ecg_delineation_scratch_size() doubles (non NULL).
+ * @param[in,out] peaks             Pics R en entrée, P/Q/S/T parallèles à R en sortie (non NULL).
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM.
+ */
+ECG_Status ecg_delineate_raw(const double *signal, size_t n_samples, int sampling_rate_hz,
+                             size_t low_pass_window, double *scratch, ECG_Peaks *peaks);
+
+/**
+ * @brief ecg_delineate_raw() sur les battements [first_beat, end_beat) seulement (mêmes règles que ecg_delineate_beats()).
+ */
+ECG_Status ecg_delineate_raw_beats(const double *signal, size_t n_samples, int sampling_rate_hz,
+                                   size_t low_pass_window, int first_beat, int end_beat, double *scratch,
+                                   ECG_Peaks *peaks);
+
+/** @brief ecg_delineate_raw() sur un signal float32. */
+ECG_Status ecg_delineate_raw_f32(const float *signal, size_t n_samples, int sampling_rate_hz,
+                                 size_t low_pass_window, double *scratch, ECG_Peaks *peaks);
+
+/** @brief ecg_delineate_raw() sur un signal int16 (l'échelle n'influence pas les indices). */
+ECG_Status ecg_delineate_raw_i16(const int16_t *signal, size_t n_samples, int sampling_rate_hz,
+                                 size_t low_pass_window, double *scratch, ECG_Peaks *peaks);
+
+#endif /* ECG_DELINEATION_H */
@@ -13,7 +13,9 @@
 #define ECG_PROCESSING_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "output_structs.h"
+#include "ecg_utils.h"
 
 /* ================================
  * Types
@@ -26,6 +28,31 @@
  */
 typedef struct ECG_Context ECG_Context;
 
+/**
+ * @brief Précision des échantillons et des buffers de l'analyse globale.
+ *
+ * Les précisions réduites divisent par 2 (float32) ou 4 (int16) les octets lus par échantillon
+ * et n'allouent qu'un buffer MWI float32 : chaîne en une passe (comme ECG_Params.fused),
+ * accumulateurs des fenêtres glissantes en double (float32) ou en int32 exact (int16).
+ */
+typedef enum {
+    ECG_PRECISION_F64 = 0, /**< double (défaut), ecg_analyze(). */
+    ECG_PRECISION_F32,     /**< float32, ecg_analyze_f32(). */
+    ECG_PRECISION_I16      /**< int16 (ADC brut), ecg_analyze_i16(). */
+} ECG_Precision;
+
+/**
+ * @brief Filtre de l'étape 1 (avant dérivée, carré et MWI).
+ *
+ * Le passe-bande de Butterworth (5-15 Hz par défaut, bande du QRS) coupe aussi le bruit musculaire et le
+ * secteur que le passe-haut x - MA(x) laisse passer : moins de faux pics R sur les signaux ambulatoires bruités.
+ */
+typedef enum {
+    ECG_FILTER_MA = 0,              /**< x - MA(x) sur 130 ms (défaut, résultats de référence). */
+    ECG_FILTER_BANDPASS,            /**< Passe-bande causal (cascade de biquads) : analyse globale et ecg_push(). */
+    ECG_FILTER_BANDPASS_ZERO_PHASE  /**< Passe-bande aller-retour, sans retard : analyse globale d'un signal
+                                         qui tient dans les buffers (ECG_Params.max_samples) uniquement. */
+} ECG_Filter;
 
 /**
  * @brief Paramètres d'analyse ECG.
@@ -34,13 +61,42 @@ typedef struct ECG_Context ECG_Context;
  */
 typedef struct
 {
-    int sampling_rate_hz;   /**< Fréquence d'échantillonnage (Hz). */
+    int sampling_rate_hz;   /**< Fréquence d'échantillonnage (Hz, quelconque : 250, 360, 500, 1000, 2000...).
+                                 Fenêtres recalculées à ecg_create ; noyau fusionné spécialisé à 360 et 500 Hz. */
     int leads;              /**< Nombre de dérivations disponibles. */
 
     double gain; /**< Gain de l'amplification (optionnel). */
 
     /*ADD NECESSARY PARAMETERS*/
 
+    size_t max_samples;     /**< Capacité des buffers de l'analyse globale (0 = MAX_SAMPLES).
+                                 Les signaux plus longs sont analysés par fenêtres (anneaux du streaming) :
+                                 seuil initialisé sur les 2 premières secondes au lieu du max global de la MWI,
+                                 les pics peuvent différer de ceux d'un contexte dimensionné sur le signal.
+                                 ecg_analysis_windowed() indique si le dernier ecg_analyze() a pris ce chemin.
+                                 Pour les pics de référence : max_samples >= nombre d'échantillons analysés. */
+    int fused;              /**< 1 = noyau fusionné passe-haut/dérivée/carré/MWI en une passe (résultat identique),
+                                 0 = une passe par filtre de ecg_utils. */
+    ECG_Isa isa;            /**< Noyaux de filtrage (ECG_ISA_AUTO = meilleur jeu SIMD du CPU, choisi à ecg_create). */
+    ECG_Precision precision; /**< Précision de l'analyse globale (ECG_PRECISION_F64 par défaut). */
+    int delineate;          /**< 1 = ondes P, Q, S, T après la détection des R (ecg_delineation.h), 0 = R uniquement.
+                                 Tableaux P/Q/S/T parallèles à R (ECG_WAVE_NONE pour une onde absente).
+                                 Analyse globale seulement : ecg_push() ne produit que les R. */
+
+    ECG_Filter filter;      /**< Filtre de l'étape 1 (ECG_FILTER_MA par défaut). Passe-bande : chaîne multi-passes
+                                 (ECG_Params.fused ignoré), précision double uniquement. */
+    double band_low_hz;     /**< Coupure basse du passe-bande (0 = 5 Hz). */
+    double band_high_hz;    /**< Coupure haute du passe-bande (0 = 15 Hz). */
+    int band_order;         /**< Ordre du prototype de Butterworth, 1..ECG_BIQUAD_MAX_SECTIONS
+                                 (0 = 2 : passe-bande d'ordre 4, deux biquads). */
+
+    int decimation;         /**< Détection sur le signal décimé d'un facteur entier (0 ou 1 = pleine résolution),
+                                 ex. 4 : 500 -> 125 Hz pour le dépistage de longs enregistrements. Les pics R sont
+                                 affinés sur le signal pleine résolution autour de chaque candidat. fs multiple du
+                                 facteur, fs / facteur >= 50 Hz, précision double. Analyse globale d'un signal qui
+                                 tient dans les buffers seulement : ecg_push() et l'analyse par fenêtres restent
+                                 à pleine résolution. */
+
     double r_threshold_hint; /**< Seuil initial pour la détection des pics R (optionnel). */
 
 } ECG_Params;
@@ -58,6 +114,85 @@ typedef enum
     ECG_ERR_FAIL  = -4   /**< Erreur générique. */
 } ECG_Status;
 
+/** @brief Nombre de seuils conservés dans ECG_Stats.threshold_history. */
+#define ECG_STATS_THRESHOLD_HISTORY 64
+
+/**
+ * @brief Compteurs d'instrumentation d'un contexte (ecg_get_stats()).
+ *
+ * Renseignés uniquement si la bibliothèque est compilée avec ECG_ENABLE_STATS (option CMake du même nom) :
+ * sans cette option, l'instrumentation disparaît à la compilation (aucun coût) et enabled vaut 0.
+ * Les compteurs sont cumulés sur tous les appels depuis ecg_create() ou ecg_reset_stats().
+ * Temps en nanosecondes (clock_gettime, CLOCK_MONOTONIC), mesurés par étape et non par échantillon.
+ */
+typedef struct {
+    int enabled;                    /**< 1 si l'instrumentation est compilée, 0 sinon. */
+
+    uint64_t calls;                 /**< Appels d'analyse (ecg_analyze*, ecg_push, ecg_flush ;
+                                         une analyse par fenêtres compte aussi ses blocs). */
+    uint64_t samples;               /**< Échantillons traités. */
+
+    uint64_t ns_highpass;           /**< Passe-haut (chaîne multi-passes). */
+    uint64_t ns_derivative;         /**< Dérivée (chaîne multi-passes). */
+    uint64_t ns_square;             /**< Mise au carré (chaîne multi-passes). */
+    uint64_t ns_mwi;                /**< MWI et son maximum (chaîne multi-passes). */
+    uint64_t ns_fused;              /**< Noyau fusionné ou chaîne en précision réduite (filtres + max). */
+    uint64_t ns_detect;             /**< Détection à seuil adaptatif + affinage des pics R. */
+    uint64_t ns_delineate;          /**< Délinéation P/Q/S/T (ECG_Params.delineate). */
+    uint64_t ns_intervals;          /**< Calcul des intervalles RR. */
+    uint64_t ns_stream;             /**< Temps total passé dans ecg_push() / ecg_flush(). */
+
+    uint64_t local_maxima;          /**< Maxima locaux de la MWI examinés par le détecteur. */
+    uint64_t rejected_refractory;   /**< Candidats rejetés dans la période réfractaire. */
+    uint64_t rejected_threshold;    /**< Candidats sous le seuil (pics de bruit). */
+    uint64_t accepted;              /**< Pics R acceptés. */
+
+    double threshold_min;           /**< Plus petit seuil adaptatif observé. */
+    double threshold_max;           /**< Plus grand seuil adaptatif observé. */
+    double threshold_last;          /**< Seuil courant. */
+    double signal_peak;             /**< Dernière estimation du niveau des pics R. */
+    double noise_peak;              /**< Dernière estimation du niveau du bruit. */
+
+    int threshold_history_count;    /**< Entrées valides de threshold_history. */
+    double threshold_history[ECG_STATS_THRESHOLD_HISTORY]; /**< Seuil après chacun des derniers pics R acceptés,
+                                                                du plus ancien au plus récent. */
+} ECG_Stats;
+
+/**
+ * @brief Indicateurs de variabilité cardiaque (ecg_get_hrv(), ecg_hrv_get()).
+ *
+ * Calculés sur les intervalles RR retenus (200 ms .. 2 s, comme ECG_Intervals). Valeurs à 0 tant qu'il
+ * n'y a pas assez d'intervalles (1 pour les moyennes, 2 pour SDNN, RMSSD et pNN50).
+ */
+typedef struct {
+    int    count;           /**< Intervalles RR pris en compte. */
+    double last_rr_s;       /**< Dernier intervalle RR (s). */
+    double mean_rr_s;       /**< Moyenne des RR (s). */
+    double sdnn_s;          /**< Écart-type des RR (s, estimateur non biaisé). */
+    double rmssd_s;         /**< Racine de la moyenne des carrés des différences successives (s). */
+    double pnn50;           /**< Pourcentage de différences successives > 50 ms. */
+    double mean_hr_bpm;     /**< Fréquence cardiaque moyenne (60 / mean_rr_s). */
+    double rolling_hr_bpm;  /**< Fréquence cardiaque sur les MAX_RR_HISTORY derniers RR. */
+} ECG_Hrv;
+
+/**
+ * @brief État incrémental des indicateurs ECG_Hrv : O(1) par battement, mémoire constante.
+ *
+ * Moyenne et variance par l'algorithme de Welford (pas de perte de précision sur un Holter 24 h,
+ * contrairement à la somme des carrés), sommes des différences successives, et anneau des
+ * MAX_RR_HISTORY derniers RR pour la fréquence glissante. Champs internes : utiliser ecg_hrv_*().
+ */
+typedef struct {
+    int    count;
+    double mean;            /**< Moyenne courante (Welford). */
+    double m2;              /**< Somme des carrés des écarts à la moyenne (Welford). */
+    double prev_rr;
+    double sum_sq_diff;     /**< Somme des (RR[i] - RR[i-1])^2. */
+    int    nn50;            /**< Différences successives > 50 ms. */
+    int    history_head;
+    double history[MAX_RR_HISTORY];
+} ECG_Hrv_State;
+
 /* ================================
  * API Publique
  * ================================ */
@@ -77,6 +212,37 @@ ECG_Context *ecg_create(const ECG_Params *params);
  */
 void ecg_destroy(ECG_Context *ctx);
 
+/**
+ * @brief Remet un contexte dans l'état de ecg_create() sans rien libérer ni réallouer.
+ *
+ * Efface l'état du seuil adaptatif et des filtres du streaming (ecg_stream_reset()) et les compteurs
+ * d'instrumentation (ecg_reset_stats()). Les paramètres, les noyaux et les buffers sont conservés :
+ * un même contexte peut enchaîner des enregistrements sans coût d'allocation.
+ *
+ * @param[in,out] ctx Contexte d'analyse (non NULL).
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_reset(ECG_Context *ctx);
+
+/**
+ * @brief Fenêtre de la MWI du contexte (échantillons), pour aligner les blocs passés à ecg_push().
+ *
+ * @param[in] ctx Contexte d'analyse.
+ * @return Taille de la fenêtre, 0 si @p ctx est NULL.
+ */
+size_t ecg_mwi_window(const ECG_Context *ctx);
+
+/**
+ * @brief Indique si le dernier ecg_analyze() est passé par l'analyse par fenêtres.
+ *
+ * @details Signal plus long que ECG_Params.max_samples : mémoire bornée, mais seuil initialisé sur la phase
+ *          d'apprentissage (2 s) au lieu du max global de la MWI, pics pas forcément identiques.
+ *
+ * @param[in] ctx Contexte d'analyse.
+ * @return 1 si le signal du dernier ecg_analyze() dépassait ECG_Params.max_samples, 0 sinon (ou si @p ctx est NULL).
+ */
+int ecg_analysis_windowed(const ECG_Context *ctx);
+
 
 /**
  * @brief Analyse un signal ECG et extrait les pics/caractéristiques.
@@ -95,6 +261,13 @@ void ecg_destroy(ECG_Context *ctx);
  *
  * @note L'implémentation est libre (analyse globale ou incrémentale).
  * @note Les indices stockés dans @p peaks sont des indices d'échantillons (0..n_samples-1).
+ * @note @p peaks et @p intervals doivent avoir été initialisés (ecg_peaks_init / ecg_intervals_init),
+ *       ils sont agrandis si nécessaire.
+ * @note Si @p n_samples dépasse ECG_Params.max_samples, l'analyse passe par le chemin streaming
+ *       (mémoire bornée, seuil initialisé sur la phase d'apprentissage au lieu du max global) :
+ *       ecg_analysis_windowed() vaut alors 1. Les pics peuvent différer de ceux de l'analyse globale.
+ * @note Un contexte en précision réduite (ECG_Params.precision) renvoie ECG_ERR_PARAM :
+ *       utiliser ecg_analyze_f32() / ecg_analyze_i16().
  */
 ECG_Status ecg_analyze(
     ECG_Context *ctx,
@@ -106,6 +279,296 @@ ECG_Status ecg_analyze(
 );
 
 
+/**
+ * @brief Analyse un signal float32 (contexte créé avec ECG_PRECISION_F32).
+ *
+ * Mêmes paramètres et résultats que ecg_analyze().
+ *
+ * @return ECG_OK en cas de succès,
+ * @return ECG_ERR_PARAM si le contexte n'est pas en float32 ou si @p n_samples dépasse ECG_Params.max_samples
+ *         (pas de chemin par fenêtres en précision réduite).
+ */
+ECG_Status ecg_analyze_f32(ECG_Context *ctx, const float *signal, size_t n_samples, int lead_idx,
+                           ECG_Peaks *peaks, ECG_Intervals *intervals);
+
+/**
+ * @brief Analyse un signal int16 (contexte créé avec ECG_PRECISION_I16).
+ *
+ * Les indices des pics ne dépendent pas de l'échelle : les échantillons ADC bruts conviennent.
+ *
+ * @return Comme ecg_analyze_f32() (contexte en int16 requis).
+ */
+ECG_Status ecg_analyze_i16(ECG_Context *ctx, const int16_t *signal, size_t n_samples, int lead_idx,
+                           ECG_Peaks *peaks, ECG_Intervals *intervals);
+
+/**
+ * @brief Calcule les intervalles RR (en secondes) à partir des pics R.
+ *
+ * @details Les intervalles hors [200 ms, 2 s] sont considérés comme aberrants et ignorés.
+ *
+ * @param[in]  peaks             Pics détectés (non NULL).
+ * @param[in]  sampling_rate_hz  Fréquence d'échantillonnage (> 0).
+ * @param[out] intervals         Intervalles calculés (non NULL, initialisé).
+ *
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_compute_intervals(const ECG_Peaks *peaks, int sampling_rate_hz, ECG_Intervals *intervals);
+
+/**
+ * @brief Copie les compteurs d'instrumentation du contexte.
+ *
+ * @param[in]  ctx    Contexte d'analyse (non NULL).
+ * @param[out] stats  Compteurs cumulés (non NULL).
+ *
+ * @return ECG_OK en cas de succès,
+ * @return ECG_ERR_FAIL si l'instrumentation n'est pas compilée (@p stats est alors mis à zéro).
+ */
+ECG_Status ecg_get_stats(const ECG_Context *ctx, ECG_Stats *stats);
+
+/**
+ * @brief Remet à zéro les compteurs d'instrumentation du contexte.
+ *
+ * @param[in,out] ctx Contexte d'analyse (non NULL).
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_reset_stats(ECG_Context *ctx);
+
+/**
+ * @brief Indicateurs de variabilité cardiaque tenus par le contexte, en O(1) (sans relire les battements).
+ *
+ * @details Mis à jour à chaque intervalle RR : sur le dernier signal pour ecg_analyze*() (même sans
+ *          @p intervals), cumulés depuis ecg_stream_reset() pour ecg_push() / ecg_flush(). Un tableau de
+ *          bord peut l'interroger entre deux blocs du flux.
+ *
+ * @param[in]  ctx  Contexte d'analyse (non NULL).
+ * @param[out] hrv  Indicateurs (non NULL).
+ *
+ * @return ECG_OK, ou ECG_ERR_NULL.
+ */
+ECG_Status ecg_get_hrv(const ECG_Context *ctx, ECG_Hrv *hrv);
+
+/**
+ * @brief Remet à zéro un état HRV (pour cumuler soi-même des intervalles, ex. résultat de consensus).
+ */
+void ecg_hrv_reset(ECG_Hrv_State *state);
+
+/**
+ * @brief Ajoute un intervalle RR (en secondes) à l'état, en O(1).
+ */
+void ecg_hrv_update(ECG_Hrv_State *state, double rr_s);
+
+/**
+ * @brief Calcule les indicateurs à partir de l'état (O(MAX_RR_HISTORY)).
+ *
+ * @return ECG_OK, ou ECG_ERR_NULL.
+ */
+ECG_Status ecg_hrv_get(const ECG_Hrv_State *state, ECG_Hrv *hrv);
+
+/* ================================
+ * API Streaming
+ * ================================ */
+
+/**
+ * @brief Remet à zéro l'état du flux (filtres, seuils, compteur d'échantillons, indicateurs HRV).
+ *
+ * @param[in,out] ctx Contexte d'analyse (non NULL).
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_stream_reset(ECG_Context *ctx);
+
+/**
+ * @brief Ajoute un bloc d'échantillons au flux et émet les pics R confirmés.
+ *
+ * @details L'état des filtres (sommes glissantes passe-haut et MWI, dérivée) et du seuil adaptatif
+ *          est conservé d'un appel à l'autre : la mémoire utilisée est constante.
+ *          Le seuil est initialisé après une phase d'apprentissage de 2 s, puis un pic R est émis
+ *          dès que sa fenêtre d'affinage (demi-période réfractaire) est complète.
+ *
+ * @param[in]  ctx        Contexte d'analyse (non NULL).
+ * @param[in]  chunk      Échantillons du bloc (peut être NULL si @p n vaut 0).
+ * @param[in]  n          Nombre d'échantillons du bloc.
+ * @param[out] peaks      Pics R confirmés pendant cet appel (non NULL, initialisé, remis à zéro).
+ * @param[out] intervals  Intervalles RR confirmés pendant cet appel (peut être NULL).
+ *
+ * @return ECG_OK en cas de succès, ECG_ERR_ALLOC si les résultats n'ont pas pu être agrandis.
+ *
+ * @note Les indices sont absolus depuis le début du flux (ou le dernier ecg_stream_reset()).
+ */
+ECG_Status ecg_push(ECG_Context *ctx,
+                    const double *chunk,
+                    size_t n,
+                    ECG_Peaks *peaks,
+                    ECG_Intervals *intervals);
+
+/**
+ * @brief Termine le flux et émet le dernier pic R en attente d'affinage.
+ *
+ * @param[in]  ctx        Contexte d'analyse (non NULL).
+ * @param[out] peaks      Pics R restants (non NULL, remis à zéro).
+ * @param[out] intervals  Intervalles RR restants (peut être NULL).
+ *
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_flush(ECG_Context *ctx, ECG_Peaks *peaks, ECG_Intervals *intervals);
+
+/**
+ * @brief Analyse hors ligne d'un long signal en segments recouvrants, en parallèle (OpenMP).
+ *
+ * @details Le signal est découpé en @p n_chunks segments, chacun analysé dans son propre ECG_Context
+ *          sur un thread. Chaque segment est élargi de 60 s en tête et des fenêtres des filtres + période
+ *          réfractaire en queue (le segment fait au moins 60 s). Le seuil initial vient du max de la MWI sur tout
+ *          le signal, comme ecg_analyze(). Le détecteur de chaque segment tourne sur le recouvrement de
+ *          tête avant ses propres pics (signal_peak / noise_peak réchauffés). Les doublons des zones de
+ *          recouvrement sont écartés à l'assemblage.
+ *          Résultat déterministe : le découpage ne dépend que de @p n_samples et @p n_chunks, pas du
+ *          nombre de threads. Pics de ecg_analyze(), à l'arrondi des sommes glissantes près (qui repartent du
+ *          début de chaque segment) ; pas d'ECG_Hrv de contexte
+ *          (voir ecg_hrv_update() sur les intervalles).
+ *          Délinéation (params->delineate) sur la liste assemblée, une plage de battements par segment
+ *          et par thread (ecg_delineate_beats()) : les battements de bord voient leurs voisins, ondes de ecg_analyze().
+ *
+ * @param[in]  params     Paramètres d'analyse (non NULL), précision double, sans décimation.
+ * @param[in]  signal     Échantillons de la dérivation (non NULL).
+ * @param[in]  n_samples  Nombre d'échantillons (<= INT_MAX).
+ * @param[in]  lead_idx   Index de la dérivation (0..params->leads-1).
+ * @param[in]  n_chunks   Nombre de segments (> 0), réduit si un segment durerait moins de 60 s.
+ * @param[out] peaks      Pics R (et P/Q/S/T si params->delineate) du signal entier (initialisé).
+ * @param[out] intervals  Intervalles RR calculés (peut être NULL).
+ *
+ * @return ECG_OK en cas de succès, sinon le premier code d'erreur rencontré.
+ */
+ECG_Status ecg_analyze_parallel(const ECG_Params *params,
+                                const double *signal,
+                                size_t n_samples,
+                                int lead_idx,
+                                int n_chunks,
+                                ECG_Peaks *peaks,
+                                ECG_Intervals *intervals);
+
+/* ================================
+ * API Multi-dérivations
+ * ================================ */
+
+/**
+ * @brief Analyse toutes les dérivations en parallèle (OpenMP, un ECG_Context par worker).
+ *
+ * @details Chaque dérivation passe par ecg_analyze() avec les mêmes paramètres. Si @p consensus est
+ *          fourni, les pics R sont fusionnés par vote majoritaire : un battement est retenu si plus de
+ *          la moitié des dérivations ont un pic R à moins de 50 ms, à la position médiane du groupe.
+ *
+ * @param[in]  params      Paramètres d'analyse communs (non NULL).
+ * @param[in]  signals     Tableau de @p n_leads pointeurs vers les échantillons (non NULL).
+ * @param[in]  n_samples   Nombre d'échantillons par dérivation.
+ * @param[in]  n_leads     Nombre de dérivations à analyser (1..params->leads, <= 32).
+ * @param[out] peaks       @p n_leads résultats par dérivation (initialisés).
+ * @param[out] intervals   @p n_leads intervalles par dérivation (peut être NULL).
+ * @param[out] consensus   Pics R fusionnés entre dérivations (peut être NULL, initialisé sinon).
+ *
+ * @return ECG_OK en cas de succès, sinon le premier code d'erreur rencontré.
+ */
+ECG_Status ecg_analyze_all_leads(const ECG_Params *params,
+                                 const double *const signals[],
+                                 size_t n_samples,
+                                 int n_leads,
+                                 ECG_Peaks peaks[],
+                                 ECG_Intervals intervals[],
+                                 ECG_Peaks *consensus);
+
+/**
+ * @brief Fusionne les pics R de plusieurs dérivations par vote majoritaire (règle de ecg_analyze_all_leads()).
+ *
+ * @param[in]  peaks             @p n_leads résultats par dérivation (non NULL).
+ * @param[in]  n_leads           Nombre de dérivations (1..32).
+ * @param[in]  sampling_rate_hz  Fréquence d'échantillonnage (> 0), pour la tolérance de 50 ms.
+ * @param[out] consensus         Pics R fusionnés (non NULL, initialisé).
+ *
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_fuse_leads(const ECG_Peaks peaks[], int n_leads, int sampling_rate_hz, ECG_Peaks *consensus);
+
+/**
+ * @brief Entrelace des dérivations séparées échantillon par échantillon : interleaved[t * n_leads + l] = signals[l][t].
+ *
+ * @param[in]  signals      Tableau de @p n_leads pointeurs vers les échantillons (non NULL).
+ * @param[in]  n_samples    Nombre d'échantillons par dérivation.
+ * @param[in]  n_leads      Nombre de dérivations (> 0).
+ * @param[out] interleaved  Buffer de @p n_samples * @p n_leads échantillons (non NULL).
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM.
+ */
+ECG_Status ecg_interleave_leads(const double *const signals[], size_t n_samples, int n_leads, double *interleaved);
+
+/**
+ * @brief Détecte les pics R de toutes les dérivations en une passe sur un signal entrelacé (ecg_interleaved.c).
+ *
+ * @details Une voie SIMD par dérivation (8 en AVX-512, 4 en AVX2, selon params->isa) : filtres et détecteur
+ *          avancent pour toutes les dérivations à chaque échantillon, le signal est lu une seule fois.
+ *          Pics R identiques bit à bit à ecg_analyze() avec le noyau fusionné ; pas de délinéation
+ *          (params->delineate ignoré), double précision uniquement. Passe-bande (params->filter) filtré
+ *          pour toutes les dérivations à la fois (ecg_biquad_cascade_leads()) avant la passe commune.
+ *          Toujours à pleine résolution : params->decimation > 1 est refusé (ECG_ERR_PARAM).
+ *
+ * @param[in]  params       Paramètres d'analyse communs (non NULL, precision = ECG_PRECISION_F64).
+ * @param[in]  interleaved  Échantillons entrelacés, x[t * n_leads + l] (non NULL, voir ecg_interleave_leads()).
+ * @param[in]  n_samples    Nombre d'échantillons par dérivation.
+ * @param[in]  n_leads      Nombre de dérivations (1..params->leads, <= 32).
+ * @param[out] peaks        @p n_leads résultats par dérivation (initialisés), pics R uniquement.
+ * @param[out] intervals    @p n_leads intervalles par dérivation (peut être NULL).
+ * @param[out] consensus    Pics R fusionnés entre dérivations (peut être NULL, initialisé sinon).
+ *
+ * @return ECG_OK en cas de succès, sinon un code d'erreur négatif.
+ */
+ECG_Status ecg_analyze_interleaved(const ECG_Params *params,
+                                   const double *interleaved,
+                                   size_t n_samples,
+                                   int n_leads,
+                                   ECG_Peaks peaks[],
+                                   ECG_Intervals intervals[],
+                                   ECG_Peaks *consensus);
+
+/* ================================
+ * API Pool de contextes
+ * ================================ */
+
+/** @brief Pool de contextes partagé entre threads (opaque, ecg_pool.c). */
+typedef struct ECG_Pool ECG_Pool;
+
+/**
+ * @brief Crée un pool de contextes de mêmes paramètres.
+ *
+ * @details Les contextes sont créés à la demande par ecg_pool_acquire() et gardés au plus @p max_idle
+ *          à la fois quand ils sont rendus : un serveur qui analyse beaucoup d'enregistrements courts
+ *          ne paie ecg_create() qu'une fois par thread.
+ *
+ * @param[in] params    Paramètres de tous les contextes du pool (non NULL, copiés).
+ * @param[in] max_idle  Nombre maximal de contextes libres conservés (> 0).
+ * @return Pointeur vers le pool en cas de succès, NULL sinon.
+ */
+ECG_Pool *ecg_pool_create(const ECG_Params *params, int max_idle);
+
+/**
+ * @brief Prend un contexte libre du pool, ou en crée un si aucun n'est libre.
+ *
+ * @param[in,out] pool Pool de contextes (non NULL). Appel sûr depuis plusieurs threads.
+ * @return Contexte remis à zéro (ecg_reset()), NULL si @p pool est NULL ou en cas d'échec d'allocation.
+ */
+ECG_Context *ecg_pool_acquire(ECG_Pool *pool);
+
+/**
+ * @brief Rend un contexte au pool (remis à zéro, ou détruit si le pool garde déjà max_idle contextes).
+ *
+ * @param[in,out] pool Pool dont provient @p ctx (non NULL). Appel sûr depuis plusieurs threads.
+ * @param[in]     ctx  Contexte obtenu par ecg_pool_acquire() sur ce pool (peut être NULL).
+ */
+void ecg_pool_release(ECG_Pool *pool, ECG_Context *ctx);
+
+/**
+ * @brief Détruit le pool et ses contextes libres.
+ *
+ * @param[in,out] pool Pool à libérer (peut être NULL). Tous les contextes doivent avoir été rendus.
+ */
+void ecg_pool_destroy(ECG_Pool *pool);
+
 /* AJOUTER N'IMPORTE QU'ELLE FONCTION UTILE */
 
-#endif ECG_PROCESSING_H
\ No newline at end of file
+#endif /* ECG_PROCESSING_H */
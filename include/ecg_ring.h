@@ -0,0 +1,165 @@
+/**
+ * @file    ecg_ring.h
+ * @brief   Anneau d'échantillons sans verrou, un producteur / un consommateur, devant le pipeline streaming.
+ * @details Le thread d'acquisition écrit les paquets du capteur (ecg_ring_write(), jamais bloquant),
+ *          le thread d'analyse les vide par lots alignés sur la fenêtre MWI dans ecg_push()
+ *          (ecg_ring_consume()). Les deux threads ne partagent que deux indices atomiques, chacun
+ *          sur sa propre ligne de cache : la gigue de l'acquisition ne bloque jamais la détection.
+ *
+ *          Un consommateur trop lent ne fait jamais perdre d'échantillons en silence : ce qui ne tient
+ *          pas dans l'anneau est refusé et compté (ECG_Ring_Counters.dropped / overruns).
+ *
+ */
+
+#ifndef ECG_RING_H
+#define ECG_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ecg_processing.h"
+
+/* ================================
+ * Types
+ * ================================ */
+
+/** @brief Anneau SPSC (opaque, ecg_ring.c). */
+typedef struct ECG_Ring ECG_Ring;
+
+/**
+ * @brief Compteurs de l'anneau (ecg_ring_get_counters()), cumulés depuis ecg_ring_create().
+ */
+typedef struct {
+    uint64_t written;       /**< Échantillons acceptés par ecg_ring_write(). */
+    uint64_t dropped;       /**< Échantillons refusés (anneau plein). */
+    uint64_t overruns;      /**< Appels à ecg_ring_write() qui ont refusé au moins un échantillon. */
+    uint64_t consumed;      /**< Échantillons transmis à ecg_push(). */
+    uint64_t batches;       /**< Lots transmis à ecg_push(). */
+    size_t   high_water;    /**< Remplissage maximal observé par le consommateur (échantillons). */
+} ECG_Ring_Counters;
+
+/**
+ * @brief Reçoit les résultats de chaque lot de ecg_ring_consume() (thread consommateur).
+ *
+ * @param[in] user       Pointeur passé à ecg_ring_consume().
+ * @param[in] peaks      Pics R confirmés par le lot (indices absolus depuis le début du flux).
+ * @param[in] intervals  Intervalles RR confirmés par le lot.
+ *
+ * @return ECG_OK pour continuer, un code d'erreur pour arrêter la consommation.
+ */
+typedef ECG_Status (*ECG_Ring_Sink)(void *user, const ECG_Peaks *peaks, const ECG_Intervals *intervals);
+
+/* ================================
+ * API Publique
+ * ================================ */
+
+/**
+ * @brief Crée un anneau d'au moins @p capacity échantillons (arrondi à la puissance de deux supérieure).
+ *
+ * @param[in] capacity Capacité minimale (> 0).
+ * @return Pointeur vers l'anneau en cas de succès, NULL sinon.
+ */
+ECG_Ring *ecg_ring_create(size_t capacity);
+
+/**
+ * @brief Libère l'anneau (peut être NULL). Producteur et consommateur doivent être arrêtés.
+ */
+void ecg_ring_destroy(ECG_Ring *ring);
+
+/**
+ * @brief Écrit un paquet d'échantillons (thread producteur uniquement, jamais bloquant).
+ *
+ * Si l'anneau n'a pas la place, seul le début du paquet est écrit : le reste est compté comme
+ * perdu (dropped, overruns) et ne doit pas être réécrit.
+ *
+ * @param[in,out] ring     Anneau (non NULL).
+ * @param[in]     samples  Échantillons du paquet (peut être NULL si @p n vaut 0).
+ * @param[in]     n        Nombre d'échantillons du paquet.
+ * @return Nombre d'échantillons écrits (0 si @p ring ou @p samples est NULL ou si l'anneau est fermé).
+ */
+size_t ecg_ring_write(ECG_Ring *ring, const double *samples, size_t n);
+
+/**
+ * @brief Place libre pour ecg_ring_write() (thread producteur) : le consommateur ne peut que l'agrandir.
+ *
+ * Pour un producteur qui peut attendre (relecture d'un fichier) plutôt que perdre des échantillons.
+ *
+ * @return Nombre d'échantillons qui tiennent dans l'anneau, 0 si @p ring est NULL.
+ */
+size_t ecg_ring_write_space(ECG_Ring *ring);
+
+/**
+ * @brief Signale la fin du flux (thread producteur) : ecg_ring_consume() vide l'anneau puis se termine.
+ */
+void ecg_ring_close(ECG_Ring *ring);
+
+/**
+ * @brief Boucle du consommateur : vide l'anneau dans ecg_push() jusqu'à sa fermeture, puis ecg_flush().
+ *
+ * @details Les lots sont des multiples de la fenêtre MWI du contexte (au plus @p max_batch échantillons,
+ *          arrondi à une fenêtre au moins) ; seul le dernier lot après ecg_ring_close() peut être plus court.
+ *          Les échantillons sont passés à ecg_push() directement depuis l'anneau (aucune copie, un lot à
+ *          cheval sur la fin de l'anneau fait deux appels). Anneau vide : le thread cède le CPU (sched_yield).
+ *          Les résultats ne dépendent pas du découpage : mêmes pics qu'un seul ecg_push() du signal complet.
+ *          Un producteur qui attend la place libre (ecg_ring_write_space()) pour des paquets de p échantillons
+ *          a besoin d'un anneau d'au moins p + 1 fenêtre MWI, sinon producteur et consommateur s'attendent.
+ *
+ * @param[in,out] ring       Anneau (non NULL), un seul consommateur.
+ * @param[in,out] ctx        Contexte d'analyse (non NULL), état du flux conservé.
+ * @param[in]     max_batch  Taille maximale d'un lot (0 = 8 fenêtres MWI).
+ * @param[in]     sink       Reçoit les pics de chaque lot qui en produit (non NULL).
+ * @param[in]     user       Pointeur transmis à @p sink.
+ *
+ * @return ECG_OK quand le flux est fermé et entièrement analysé,
+ * @return sinon le premier code d'erreur de ecg_push(), ecg_flush() ou @p sink.
+ */
+ECG_Status ecg_ring_consume(ECG_Ring *ring, ECG_Context *ctx, size_t max_batch, ECG_Ring_Sink sink, void *user);
+
+/**
+ * @brief Un pas de ecg_ring_consume() sans attente : au plus un lot transmis à ecg_push() (thread consommateur).
+ *
+ * Pour un ordonnanceur qui sert beaucoup de flux avec peu de threads. Même découpage en lots que
+ * ecg_ring_consume() ; n'appelle pas ecg_flush() (à faire quand ecg_ring_finished() devient vrai).
+ *
+ * @param[in,out] ring       Anneau (non NULL), un seul consommateur à la fois.
+ * @param[in,out] ctx        Contexte d'analyse (non NULL).
+ * @param[in]     max_batch  Taille maximale d'un lot (0 = 8 fenêtres MWI).
+ * @param[out]    peaks      Buffer de travail des pics (initialisé, non NULL).
+ * @param[out]    intervals  Buffer de travail des intervalles (initialisé, non NULL).
+ * @param[in]     sink       Reçoit les pics du lot s'il en produit (non NULL).
+ * @param[in]     user       Pointeur transmis à @p sink.
+ * @param[out]    consumed   Échantillons analysés par cet appel, 0 si aucun lot complet n'était prêt (non NULL).
+ *
+ * @return ECG_OK en cas de succès, sinon le code d'erreur de ecg_push() ou de @p sink.
+ */
+ECG_Status ecg_ring_poll(ECG_Ring *ring, ECG_Context *ctx, size_t max_batch, ECG_Peaks *peaks,
+                         ECG_Intervals *intervals, ECG_Ring_Sink sink, void *user, size_t *consumed);
+
+/**
+ * @brief Échantillons écrits et pas encore analysés.
+ *
+ * @return Remplissage de l'anneau (instantané, 0 si @p ring est NULL).
+ */
+size_t ecg_ring_available(const ECG_Ring *ring);
+
+/**
+ * @brief Indique si le flux est fermé et entièrement analysé.
+ *
+ * @return 1 si ecg_ring_close() a été appelé et que l'anneau est vide, 0 sinon.
+ */
+int ecg_ring_finished(const ECG_Ring *ring);
+
+/**
+ * @brief Vide l'anneau et remet ses compteurs à zéro pour un nouveau flux (ni producteur ni consommateur actif).
+ */
+void ecg_ring_reset(ECG_Ring *ring);
+
+/**
+ * @brief Copie les compteurs de l'anneau (appel possible depuis n'importe quel thread).
+ *
+ * @param[in]  ring      Anneau (non NULL).
+ * @param[out] counters  Compteurs (non NULL).
+ * @return ECG_OK, ou ECG_ERR_NULL.
+ */
+ECG_Status ecg_ring_get_counters(const ECG_Ring *ring, ECG_Ring_Counters *counters);
+
+#endif /* ECG_RING_H */
@@ -0,0 +1,147 @@
+/**
+ * @file    ecg_server.h
+ * @brief   Mode serveur : beaucoup de flux patients en streaming sur un nombre fixe de workers (vol de travail).
+ * @details Chaque flux possède un ECG_Context (pris dans un ECG_Pool) et un anneau SPSC (ecg_ring.h) :
+ *          le thread qui lit le capteur écrit dans l'anneau (ecg_server_feed(), jamais bloquant),
+ *          les workers analysent les lots prêts (ecg_ring_poll()). Un thread par flux gaspillerait
+ *          les cœurs, une file globale unique deviendrait un point de contention : chaque flux
+ *          appartient à un worker, qui ne parcourt que ses propres flux.
+ *
+ *          Un worker sans travail vole un flux en retard au worker le plus chargé (échange atomique
+ *          du propriétaire) : les flux migrent d'un cœur à l'autre quand la charge devient inégale.
+ *          Un flux n'est jamais analysé par deux workers à la fois (drapeau atomique par flux).
+ *
+ *          Les résultats sont ceux d'ecg_push() (pics R et RR) : identiques à l'analyse streaming du
+ *          même signal, quel que soit le worker ou le découpage. Latence suivie par flux : temps entre
+ *          l'écriture d'un paquet et la fin de l'analyse du lot qui contient son premier échantillon.
+ *
+ */
+
+#ifndef ECG_SERVER_H
+#define ECG_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ecg_processing.h"
+#include "ecg_ring.h"
+
+/* ================================
+ * Types
+ * ================================ */
+
+/** @brief Serveur de flux (opaque, ecg_server.c). */
+typedef struct ECG_Server ECG_Server;
+
+/**
+ * @brief Options du serveur (0 = valeur par défaut pour chaque champ).
+ */
+typedef struct {
+    int    workers;         /**< Nombre de workers (0 = nombre de cœurs en ligne). */
+    int    max_streams;     /**< Nombre maximal de flux ouverts à la fois (0 = 256). */
+    size_t ring_capacity;   /**< Capacité de l'anneau de chaque flux en échantillons (0 = 2 s). */
+    size_t batch;           /**< Taille maximale d'un lot (0 = 8 fenêtres MWI). */
+    int    pin_workers;     /**< 1 = worker k fixé sur le cœur k (Linux), 0 = placement libre. */
+} ECG_Server_Options;
+
+/**
+ * @brief Statistiques d'un flux (ecg_server_get_stream_stats()).
+ */
+typedef struct {
+    int        open;            /**< 1 tant que le flux n'est pas entièrement analysé. */
+    ECG_Status status;          /**< Premier code d'erreur de l'analyse du flux (ECG_OK sinon). */
+    int        worker;          /**< Worker propriétaire actuel. */
+    uint64_t   samples;         /**< Échantillons analysés. */
+    uint64_t   batches;         /**< Lots analysés. */
+    uint64_t   migrations;      /**< Vols du flux par un autre worker. */
+    uint64_t   dropped;         /**< Échantillons refusés (anneau plein, voir ECG_Ring_Counters). */
+    uint64_t   service_ns;      /**< Temps total d'analyse des lots. */
+    uint64_t   latency_last_ns; /**< Latence du dernier lot. */
+    uint64_t   latency_max_ns;  /**< Latence maximale. */
+    uint64_t   latency_sum_ns;  /**< Somme des latences mesurées. */
+    uint64_t   latency_count;   /**< Lots dont la latence a été mesurée (moyenne = latency_sum_ns / latency_count). */
+    ECG_Hrv    hrv;             /**< Variabilité cardiaque du flux, à jour au dernier lot analysé (ecg_get_hrv()). */
+} ECG_Server_Stream_Stats;
+
+/* ================================
+ * API Publique
+ * ================================ */
+
+/**
+ * @brief Crée un serveur (aucun thread lancé, voir ecg_server_start()).
+ *
+ * Les contextes sont créés pour ecg_push() uniquement : buffers de l'analyse globale réduits au minimum,
+ * pas de délinéation (ECG_Params.max_samples et delineate ignorés). Passe-bande causal accepté,
+ * pas ECG_FILTER_BANDPASS_ZERO_PHASE.
+ *
+ * @param[in] params  Paramètres d'analyse communs à tous les flux (non NULL, copiés).
+ * @param[in] opt     Options (peut être NULL : valeurs par défaut).
+ * @return Pointeur vers le serveur en cas de succès, NULL sinon.
+ */
+ECG_Server *ecg_server_create(const ECG_Params *params, const ECG_Server_Options *opt);
+
+/**
+ * @brief Lance les workers.
+ *
+ * @return ECG_OK, ECG_ERR_NULL, ECG_ERR_PARAM si déjà lancé, ECG_ERR_FAIL si un thread n'a pas pu être créé.
+ */
+ECG_Status ecg_server_start(ECG_Server *server);
+
+/**
+ * @brief Ouvre un flux (thread quelconque).
+ *
+ * @param[in,out] server  Serveur (non NULL).
+ * @param[in]     sink    Reçoit les pics R de chaque lot, depuis le worker qui l'analyse (non NULL).
+ *                        Appelé par un seul worker à la fois pour un même flux.
+ * @param[in]     user    Pointeur transmis à @p sink.
+ *
+ * @return Identifiant du flux (>= 0),
+ * @return ECG_ERR_NULL, ECG_ERR_PARAM si tous les flux sont ouverts, ECG_ERR_ALLOC si aucun contexte n'a pu être créé.
+ */
+int ecg_server_open(ECG_Server *server, ECG_Ring_Sink sink, void *user);
+
+/**
+ * @brief Écrit un paquet d'échantillons dans un flux (un seul thread producteur par flux, jamais bloquant).
+ *
+ * @return Nombre d'échantillons acceptés ; le reste est compté comme perdu (ECG_Server_Stream_Stats.dropped).
+ */
+size_t ecg_server_feed(ECG_Server *server, int stream, const double *samples, size_t n);
+
+/**
+ * @brief Place libre dans l'anneau d'un flux (producteur qui préfère attendre que perdre des échantillons).
+ *
+ * Le worker laisse dans l'anneau moins d'une fenêtre MWI non analysée : un producteur qui attend la place
+ * d'un paquet entier doit avoir ring_capacity >= paquet + fenêtre MWI, sinon il écrit ce qui tient et
+ * reporte le reste.
+ */
+size_t ecg_server_feed_space(ECG_Server *server, int stream);
+
+/**
+ * @brief Termine un flux (thread producteur) : il est vidé, ecg_flush() émet le dernier pic, puis le flux
+ *        se ferme et son contexte retourne au pool. Ses statistiques restent lisibles jusqu'à sa réouverture.
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM si @p stream n'est pas ouvert.
+ */
+ECG_Status ecg_server_close(ECG_Server *server, int stream);
+
+/**
+ * @brief Attend que tous les flux fermés par ecg_server_close() soient analysés, puis arrête les workers.
+ *
+ * Les flux encore ouverts (jamais fermés) sont abandonnés avec leurs échantillons en attente.
+ *
+ * @return ECG_OK, ECG_ERR_NULL.
+ */
+ECG_Status ecg_server_stop(ECG_Server *server);
+
+/**
+ * @brief Copie les statistiques d'un flux (thread quelconque).
+ *
+ * @return ECG_OK, ECG_ERR_NULL ou ECG_ERR_PARAM si @p stream est hors limites.
+ */
+ECG_Status ecg_server_get_stream_stats(ECG_Server *server, int stream, ECG_Server_Stream_Stats *stats);
+
+/**
+ * @brief Arrête le serveur si nécessaire et libère flux, contextes et anneaux (peut être NULL).
+ */
+void ecg_server_destroy(ECG_Server *server);
+
+#endif /* ECG_SERVER_H */
@@ -0,0 +1,71 @@
+/**
+ * @file    ecg_synth.h
+ * @brief   Générateur d'ECG synthétique 12 dérivations avec vérité terrain (tests de charge et de précision).
+ * @details Modèle inspiré d'ECGSYN (McSharry et al., 2003) : chaque battement parcourt une phase
+ *          θ ∈ [-π, π[ et la forme d'onde est la solution du modèle dynamique, une somme de 5 gaussiennes
+ *          en phase (P, Q, R, S, T) dont les largeurs s'adaptent à la fréquence cardiaque.
+ *          Les intervalles RR suivent un tachogramme à deux composantes (Mayer ~0.1 Hz, arythmie
+ *          respiratoire ~0.25 Hz, rapport LF/HF 0.5) plus une part aléatoire.
+ *          Chaque dérivation est une projection (gains P / QRS / T) de la même activité cardiaque,
+ *          à laquelle s'ajoutent une dérive de ligne de base et un bruit gaussien indépendants.
+ *
+ *          Générateur pseudo-aléatoire local (graine dans les paramètres) : même graine, même signal,
+ *          pas d'état global.
+ *
+ */
+
+#ifndef ECG_SYNTH_H
+#define ECG_SYNTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "csv_reader.h"
+#include "output_structs.h"
+
+/* ================================
+ * Types
+ * ================================ */
+/**
+ * @brief Paramètres du générateur (ecg_synth_defaults() pour les valeurs par défaut).
+ */
+typedef struct {
+    int      sampling_rate_hz;   /**< Fréquence d'échantillonnage (Hz). */
+    int      leads;              /**< Nombre de dérivations (1..LEADS), ordre I, II, III, aVR, aVL, aVF, V1..V6. */
+    size_t   samples;            /**< Nombre d'échantillons par dérivation (<= INT_MAX). */
+    double   heart_rate_bpm;     /**< Fréquence cardiaque moyenne (30..240 bpm). */
+    double   hrv_std_s;          /**< Écart-type des intervalles RR (s), 0 = rythme régulier. */
+    double   noise_std;          /**< Écart-type du bruit blanc gaussien (mV). */
+    double   baseline_wander;    /**< Amplitude de la dérive de ligne de base (mV). */
+    double   wander_hz;          /**< Fréquence de la dérive (Hz, respiration ~0.3 Hz). */
+    double   amplitude;          /**< Amplitude du pic R sur la dérivation II (mV). */
+    uint64_t seed;               /**< Graine du générateur pseudo-aléatoire. */
+} ECG_Synth_Params;
+
+/* ================================
+ * API Publique
+ * ================================ */
+/**
+ * @brief Remplit @p params avec les valeurs par défaut : 500 Hz, 12 dérivations, 60 s à 75 bpm,
+ *        RR ± 50 ms, bruit 0.01 mV, dérive 0.1 mV à 0.3 Hz, R = 1 mV, graine fixe.
+ *
+ * @param[out] params Paramètres à initialiser (non NULL).
+ */
+void ecg_synth_defaults(ECG_Synth_Params *params);
+
+/**
+ * @brief Génère un enregistrement synthétique et sa vérité terrain.
+ *
+ * Les buffers de @p rec sont réutilisés et agrandis si nécessaire (comme read_csv_record()).
+ * La vérité terrain donne, pour chaque battement entièrement contenu dans le signal, l'indice
+ * du sommet de chaque onde (P, Q, R, S, T) du modèle sans bruit.
+ *
+ * @param[in]     params  Paramètres du générateur (non NULL).
+ * @param[in,out] rec     Enregistrement initialisé (non NULL) ; rec->sampling_rate_hz est renseigné.
+ * @param[out]    truth   Indices de vérité terrain (initialisé, peut être NULL).
+ *
+ * @return 0 en cas de succès,
+ * @return -1 si un pointeur est NULL, -2 si les paramètres sont invalides, -3 en cas d'échec d'allocation.
+ */
+int ecg_synth_generate(const ECG_Synth_Params *params, ECG_Record *rec, ECG_Peaks *truth);
+
+#endif /* ECG_SYNTH_H */
@@ -89,6 +89,193 @@ void ecg_square(const double *x, double *y, size_t n);
  */
 void ecg_mwi(const double *x, double *y, size_t n, size_t win);
 
+/**
+ * @brief Intégration sur fenêtre glissante, avec le maximum du signal intégré.
+ *
+ * Même sortie que ecg_mwi() ; le maximum est calculé pendant l'écriture de @p y
+ * (évite une passe de plus sur le signal intégré).
+ *
+ * @return max(0, max(y)) (les NaN sont ignorés), 0 si n vaut 0.
+ */
+double ecg_mwi_max(const double *x, double *y, size_t n, size_t win);
+
+/**
+ * @brief Indice de la première occurrence du maximum de @p x.
+ *
+ * @param[in] x  Signal (les NaN sont ignorés, sauf en x[0] : l'indice 0 est alors retourné).
+ * @param[in] n  Nombre d'échantillons.
+ * @return Indice dans [0, n), 0 si n vaut 0.
+ */
+size_t ecg_argmax(const double *x, size_t n);
+
+/**
+ * @brief Décime un signal d'un facteur entier, avec filtre anti-repliement.
+ *
+ * @details Filtre triangulaire de 2 x @p factor - 1 points (deux moyennes de @p factor en cascade, CIC d'ordre 2),
+ *          à phase linéaire et centré : y[j] correspond à x[j * factor], gain unité en continu.
+ *          Zéros doubles aux multiples de fs / @p factor : les bandes qui se replieraient sur les basses
+ *          fréquences sont atténuées d'au moins ~28 dB (facteur 4 à 500 Hz, bande du QRS < 20 Hz),
+ *          atténuation de ~4 % à 15 Hz. Bords : premier et dernier échantillons répétés.
+ *
+ * @param[in]  x       Signal d'entrée.
+ * @param[in]  n       Nombre d'échantillons.
+ * @param[in]  factor  Facteur de décimation (>= 1).
+ * @param[out] y       Signal décimé, ceil(n / factor) échantillons.
+ * @return Nombre d'échantillons écrits dans @p y.
+ */
+size_t ecg_decimate(const double *x, size_t n, size_t factor, double *y);
+
+/* ================================
+ * Passe-bande IIR (cascade de biquads)
+ * ================================ */
+
+/** @brief Nombre maximal de sections d'une cascade (ordre maximal de ecg_butterworth_bandpass()). */
+#define ECG_BIQUAD_MAX_SECTIONS 8
+
+/**
+ * @brief Section du second ordre : H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2).
+ */
+typedef struct
+{
+    double b0, b1, b2;
+    double a1, a2;
+} ECG_Biquad;
+
+/**
+ * @brief État d'une section (forme directe II transposée : deux retards).
+ */
+typedef struct
+{
+    double z1, z2;
+} ECG_Biquad_State;
+
+/**
+ * @brief Calcule un passe-bande de Butterworth en sections du second ordre.
+ *
+ * @details Prototype analogique d'ordre @p order, transformation passe-bas -> passe-bande puis
+ *          transformation bilinéaire avec pré-distorsion des deux fréquences de coupure.
+ *          Filtre d'ordre 2 x @p order, gain unité au centre de la bande (moyenne géométrique des coupures),
+ *          gain nul en continu. Pôles rangés du plus amorti au moins amorti.
+ *
+ * @param[in]  fs        Fréquence d'échantillonnage (Hz, > 0).
+ * @param[in]  low_hz    Coupure basse (Hz, 0 < low_hz < high_hz).
+ * @param[in]  high_hz   Coupure haute (Hz, < fs / 2).
+ * @param[in]  order     Ordre du prototype (1..ECG_BIQUAD_MAX_SECTIONS).
+ * @param[out] sections  @p order sections.
+ * @return Nombre de sections (= @p order), ou -1 si les paramètres sont invalides.
+ */
+int ecg_butterworth_bandpass(double fs, double low_hz, double high_hz, int order, ECG_Biquad *sections);
+
+/**
+ * @brief État de la cascade en régime établi pour une entrée constante @p x0.
+ *
+ * @details Démarrer sur x[0] plutôt que sur un état nul supprime le transitoire de l'échelon d'entrée
+ *          (la ligne de base d'un ECG est rarement à 0).
+ *
+ * @param[in]  sections    Sections de la cascade.
+ * @param[in]  n_sections  Nombre de sections.
+ * @param[in]  x0          Valeur d'entrée constante.
+ * @param[out] state       @p n_sections états.
+ */
+void ecg_biquad_steady_state(const ECG_Biquad *sections, int n_sections, double x0, ECG_Biquad_State *state);
+
+/**
+ * @brief Filtre causal par la cascade (état repris d'un appel à l'autre).
+ *
+ * @details Traitement par blocs : chaque section filtre un bloc qui tient en L1 avant de le passer à la
+ *          suivante (coefficients et état en registres). Résultat identique bit à bit à un traitement
+ *          échantillon par échantillon ; in-place autorisé (@p y == @p x).
+ *
+ * @param[in]     sections    Sections de la cascade.
+ * @param[in]     n_sections  Nombre de sections.
+ * @param[in,out] state       @p n_sections états (ecg_biquad_steady_state() ou zéros pour un nouveau signal).
+ * @param[in]     x           Signal d'entrée.
+ * @param[out]    y           Signal filtré.
+ * @param[in]     n           Nombre d'échantillons.
+ */
+void ecg_biquad_cascade(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                        const double *x, double *y, size_t n);
+
+/**
+ * @brief Filtre causal de @p n_leads dérivations entrelacées (x[t * n_leads + l]).
+ *
+ * @details La récurrence est séquentielle dans le temps mais indépendante d'une dérivation à l'autre :
+ *          la boucle interne porte sur les dérivations (vectorisée par le compilateur).
+ *          Par dérivation, résultat identique bit à bit à ecg_biquad_cascade().
+ *
+ * @param[in,out] state  @p n_sections x @p n_leads états (state[s * n_leads + l]).
+ */
+void ecg_biquad_cascade_leads(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                              const double *x, double *y, size_t n, size_t n_leads);
+
+/**
+ * @brief Filtre à phase nulle (aller puis retour, comme filtfilt) : aucun retard, réponse en module au carré.
+ *
+ * @details Hors ligne uniquement (le retour part de la fin du signal). Chaque passe démarre en régime établi
+ *          sur son premier échantillon. In-place autorisé.
+ */
+void ecg_biquad_zero_phase(const ECG_Biquad *sections, int n_sections, const double *x, double *y, size_t n);
+
+/**
+ * @brief ecg_biquad_zero_phase() pour @p n_leads dérivations entrelacées.
+ *
+ * @param[out] state  Buffer de travail de @p n_sections x @p n_leads états.
+ */
+void ecg_biquad_zero_phase_leads(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                                 const double *x, double *y, size_t n, size_t n_leads);
+
+/* ================================
+ * Noyaux vectorisés (SIMD)
+ * ================================ */
+
+/**
+ * @brief Jeux d'instructions disponibles pour les noyaux de filtrage.
+ */
+typedef enum
+{
+    ECG_ISA_AUTO = 0,   /**< Meilleur jeu x86 disponible sur le CPU (détecté à l'exécution), sinon scalaire. */
+    ECG_ISA_SCALAR,     /**< Fonctions scalaires ci-dessus (référence). */
+    ECG_ISA_AVX2,       /**< x86-64 AVX2, 4 doubles par vecteur. */
+    ECG_ISA_AVX512      /**< x86-64 AVX-512F, 8 doubles par vecteur. */
+} ECG_Isa;
+
+/**
+ * @brief Table de noyaux, mêmes signatures que les fonctions scalaires.
+ *
+ * @details Les opérations élément par élément (gain, carré, dérivée) donnent un résultat identique
+ *          bit à bit à la version scalaire, argmax le même indice (égalités et NaN compris).
+ *          Les sommes glissantes (moyenne glissante, passe-haut, MWI) et la moyenne de ecg_remove_dc sont
+ *          réassociées (sommes préfixes en registre, plusieurs accumulateurs). Avec M = max|x| et eps = DBL_EPSILON :
+ *          - sommes glissantes, sortie i : |y - y_scalaire| <= ((2 + 16 / win) * (i + 1) + 2) * eps * M ;
+ *          - ecg_remove_dc : |x - x_scalaire| <= (n + 4) * eps * M.
+ *          Bornes de pire cas (arrondis des deux sommes courantes) ; écarts mesurés < 15 % de la borne.
+ *          mwi_max retourne exactement max(0, max(y)) du y qu'il écrit.
+ *          Vérifié pour chaque table disponible par ecg_kernels_check (ctest).
+ */
+typedef struct
+{
+    const char *name;   /**< Nom du jeu d'instructions. */
+    ECG_Isa     isa;    /**< Jeu d'instructions. */
+
+    void (*apply_gain)(double *x, size_t n, double gain);
+    void (*remove_dc)(double *x, size_t n);
+    void (*moving_average)(const double *x, double *y, size_t n, size_t win);
+    void (*highpass_ma)(const double *x, double *y, size_t n, size_t win);
+    void (*derivative_1)(const double *x, double *y, size_t n);
+    void (*square)(const double *x, double *y, size_t n);
+    void (*mwi)(const double *x, double *y, size_t n, size_t win);
+    double (*mwi_max)(const double *x, double *y, size_t n, size_t win);
+    size_t (*argmax)(const double *x, size_t n);
+} ECG_Kernels;
+
+/**
+ * @brief Retourne la table de noyaux pour un jeu d'instructions.
+ *
+ * @param[in] isa  Jeu demandé, ECG_ISA_AUTO pour le meilleur disponible.
+ * @return Table de noyaux, ou NULL si le jeu n'est pas supporté par ce CPU / cette compilation.
+ */
+const ECG_Kernels *ecg_kernels_get(ECG_Isa isa);
+
 #ifdef __cplusplus
 }
 #endif
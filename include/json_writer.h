@@ -14,8 +14,31 @@
 #ifndef JSON_WRITER_H
 #define JSON_WRITER_H
 
+#include <stdio.h>
+#include "ecg_processing.h"
 #include "output_structs.h"
 
+/* ================================
+ * Types
+ * ================================ */
+
+/**
+ * @brief Écrit aussi les pics P, Q, S et T (sinon R uniquement).
+ *
+ * Tableaux parallèles à "R" après délinéation : "P"[k] .. "T"[k] sont les ondes du battement "R"[k],
+ * -1 (ECG_WAVE_NONE) pour une onde absente au bord du signal ; tableaux vides sans délinéation.
+ */
+#define ECG_JSON_ALL_PEAKS 0x1
+
+/**
+ * @brief Résultats d’une dérivation pour la section "leads" du JSON.
+ */
+typedef struct {
+    const char *name;                /**< Nom de la dérivation (champ "name"). */
+    const ECG_Peaks *peaks;          /**< Pics détectés (non NULL). */
+    const ECG_Intervals *intervals;  /**< Intervalles calculés (non NULL). */
+} ECG_Json_Lead;
+
 /* ================================
  * API Publique
  * ================================ */
@@ -34,7 +57,46 @@
  *
  * @note Le format exact du JSON dépend de l’implémentation (.c) et des champs
  *       présents dans ECG_Peaks et ECG_Intervals.
+ * @note Équivaut à write_json_ex(filename, peaks, intervals, NULL, 0, 0, NULL, NULL).
  */
 int write_json(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals);
 
+/**
+ * @brief Écrit les résultats dans un fichier JSON, avec options.
+ *
+ * Le document est formaté dans un buffer (entiers et RR "%.2f" formatés à la main, même texte que printf)
+ * puis écrit en un seul write() : pas de stdio ni d’état statique, appel réentrant.
+ *
+ * @param[in] filename   Chemin vers le fichier JSON de sortie.
+ * @param[in] peaks      Pics du résultat principal (non NULL).
+ * @param[in] intervals  Intervalles du résultat principal (non NULL).
+ * @param[in] leads      Résultats par dérivation (section "leads"), NULL si non demandés.
+ * @param[in] n_leads    Nombre d’entrées de @p leads.
+ * @param[in] flags      Combinaison de ECG_JSON_* (0 = R et RR uniquement).
+ * @param[in] stats      Compteurs d’instrumentation (section "stats", ecg_get_stats()), NULL si non demandés.
+ * @param[in] hrv        Variabilité cardiaque (section "hrv", ecg_get_hrv()), NULL si non demandée.
+ *
+ * @return 0 en cas de succès,
+ * @return valeur négative en cas d’erreur
+ */
+int write_json_ex(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals,
+                  const ECG_Json_Lead *leads, int n_leads, int flags, const ECG_Stats *stats,
+                  const ECG_Hrv *hrv);
+
+/**
+ * @brief Écrit les résultats d’un enregistrement sur une ligne JSON (format JSON Lines).
+ *
+ * La ligne est formatée hors verrou puis écrite en un seul fwrite sous verrou du flux (flockfile) :
+ * plusieurs threads peuvent partager @p f sans entrelacer leurs lignes.
+ *
+ * @param[in] f          Flux de sortie ouvert en écriture (non NULL).
+ * @param[in] name       Nom de l’enregistrement (champ "file").
+ * @param[in] peaks      Pics détectés (non NULL).
+ * @param[in] intervals  Intervalles calculés (non NULL).
+ *
+ * @return 0 en cas de succès,
+ * @return valeur négative en cas d’erreur
+ */
+int write_json_line(FILE *f, const char *name, const ECG_Peaks *peaks, const ECG_Intervals *intervals);
+
 #endif /* JSON_WRITER_H */
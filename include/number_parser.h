@@ -0,0 +1,26 @@
+/**
+ * @file    number_parser.h
+ * @brief   Conversion rapide texte -> double, indépendante de la locale.
+ * @details Remplace strtod() dans la lecture CSV : mantisse décimale accumulée sur 64 bits puis
+ *          conversion d'Eisel-Lemire (produit 64x128 bits par une puissance de 5 tabulée),
+ *          arrondi correct au plus proche pair comme strtod. Les cas hors de la table
+ *          (exposant extrême, sous-normaux, plus de 19 chiffres ambigus, inf/nan) repassent par strtod.
+ *
+ */
+
+#ifndef NUMBER_PARSER_H
+#define NUMBER_PARSER_H
+
+/**
+ * @brief Lit un nombre décimal ([+-]chiffres[.chiffres][(e|E)[+-]chiffres]).
+ *
+ * @param[in]  p    Début du texte (les espaces en tête ne sont pas sautés).
+ * @param[in]  end  Fin du texte (exclue) ; le texte n'a pas besoin d'être terminé par '\0'
+ *                  sauf pour les nombres qui repassent par strtod (inf/nan, > 19 chiffres ambigus).
+ * @param[out] out  Valeur lue (non NULL).
+ *
+ * @return Pointeur après le dernier caractère du nombre, ou @p p si aucun nombre n'est lu.
+ */
+const char *parse_double(const char *p, const char *end, double *out);
+
+#endif /* NUMBER_PARSER_H */
@@ -13,11 +13,18 @@
 #ifndef OUTPUT_STRUCTS_H
 #define OUTPUT_STRUCTS_H
 
+#include <stddef.h>
+
 /* ================================
  * Constantes globales
  * ================================ */
 
-/** @brief Nombre maximal d’échantillons ECG traités. */
+/**
+ * @brief Capacité par défaut (en échantillons) des buffers d’analyse.
+ *
+ * Ce n’est plus une limite : la capacité réelle est donnée par ECG_Params.max_samples,
+ * et les signaux plus longs sont traités par fenêtres (anneaux du mode streaming).
+ */
 #define MAX_SAMPLES     10000
 
 /** @brief Nombre de dérivations ECG. */
@@ -26,7 +33,12 @@
 /** @brief Taille maximale de l’historique RR. */
 #define MAX_RR_HISTORY  8
 
-/** @brief Fréquence d’échantillonnage ECG (en Hz). */
+/**
+ * @brief Fréquence d’échantillonnage par défaut (en Hz).
+ *
+ * Utilisée quand l'entrée ne donne pas sa fréquence (CSV) ; l'analyse accepte toute fréquence
+ * (ECG_Params.sampling_rate_hz, option --fs).
+ */
 #define SAMPLING_RATE   500
 
 /** @brief Fréquence cardiaque maximale théorique (en BPM). */
@@ -35,9 +47,12 @@
 /** @brief Durée maximale des données ECG (en secondes). */
 #define DURATION_S      (MAX_SAMPLES / SAMPLING_RATE)
 
-/** @brief Nombre maximal de battements cardiaques attendus. */
+/** @brief Capacité initiale des tableaux de pics (agrandis à la demande, quelle que soit la fréquence). */
 #define MAX_BEATS       ((HR_MAX_BPM * DURATION_S) / 60 + 16)
 
+/** @brief Indice d'une onde P, Q, S ou T absente (fenêtre de recherche vide au bord du signal). */
+#define ECG_WAVE_NONE   (-1)
+
 /* ================================
  * Structures de données
  * ================================ */
@@ -46,19 +61,24 @@
  *
  * Chaque tableau stocke les indices (échantillons) correspondant aux
  * différents types de pics (P, Q, R, S, T).
+ * Après délinéation, P, Q, S et T sont parallèles à R : P[k], Q[k], S[k] et T[k] sont les ondes du
+ * battement R[k] (compteurs égaux à R_count), ECG_WAVE_NONE quand l'onde n'a pas pu être cherchée.
+ * Sans délinéation, leurs compteurs valent 0.
  */
 typedef struct {
-    int R[MAX_BEATS]; /**< Indices des pics R détectés. */
-    int P[MAX_BEATS]; /**< Indices des pics P détectés. */
-    int Q[MAX_BEATS]; /**< Indices des pics Q détectés. */
-    int S[MAX_BEATS]; /**< Indices des pics S détectés. */
-    int T[MAX_BEATS]; /**< Indices des pics T détectés. */
+    int *R; /**< Indices des pics R détectés. */
+    int *P; /**< Indices des pics P détectés. */
+    int *Q; /**< Indices des pics Q détectés. */
+    int *S; /**< Indices des pics S détectés. */
+    int *T; /**< Indices des pics T détectés. */
 
     int R_count; /**< Nombre de pics R détectés. */
-    int P_count; /**< Nombre de pics P détectés. */
-    int Q_count; /**< Nombre de pics Q détectés. */
-    int S_count; /**< Nombre de pics S détectés. */
-    int T_count; /**< Nombre de pics T détectés. */
+    int P_count; /**< Nombre de pics P (R_count après délinéation, 0 sinon). */
+    int Q_count; /**< Nombre de pics Q (R_count après délinéation, 0 sinon). */
+    int S_count; /**< Nombre de pics S (R_count après délinéation, 0 sinon). */
+    int T_count; /**< Nombre de pics T (R_count après délinéation, 0 sinon). */
+
+    int capacity; /**< Capacité allouée de chacun des tableaux. */
 } ECG_Peaks;
 
 /**
@@ -68,8 +88,64 @@ typedef struct {
  * généralement exprimé en secondes ou en échantillons selon l’implémentation.
  */
 typedef struct {
-    double RR[MAX_BEATS];   /**< Valeurs des intervalles RR. */
-    int    count;           /**< Nombre d’intervalles RR valides. */
+    double *RR;     /**< Valeurs des intervalles RR. */
+    int    count;   /**< Nombre d’intervalles RR valides. */
+    int    capacity;/**< Capacité allouée du tableau RR. */
 } ECG_Intervals;
 
+/* ================================
+ * Gestion mémoire des résultats
+ * ================================ */
+/**
+ * @brief Alloue les tableaux de pics avec une capacité initiale.
+ *
+ * @param[out] peaks     Structure à initialiser (non NULL).
+ * @param[in]  capacity  Capacité initiale (<= 0 pour MAX_BEATS).
+ * @return 0 en cas de succès, valeur négative en cas d’échec d’allocation.
+ */
+int ecg_peaks_init(ECG_Peaks *peaks, int capacity);
+
+/**
+ * @brief Garantit une capacité d’au moins @p capacity pics par tableau (agrandissement x2).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d’échec d’allocation.
+ */
+int ecg_peaks_reserve(ECG_Peaks *peaks, int capacity);
+
+/**
+ * @brief Libère les tableaux de pics (la structure peut être réinitialisée ensuite).
+ */
+void ecg_peaks_free(ECG_Peaks *peaks);
+
+/**
+ * @brief Alloue le tableau RR avec une capacité initiale (<= 0 pour MAX_BEATS).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d’échec d’allocation.
+ */
+int ecg_intervals_init(ECG_Intervals *intervals, int capacity);
+
+/**
+ * @brief Garantit une capacité d’au moins @p capacity intervalles (agrandissement x2).
+ *
+ * @return 0 en cas de succès, valeur négative en cas d’échec d’allocation.
+ */
+int ecg_intervals_reserve(ECG_Intervals *intervals, int capacity);
+
+/**
+ * @brief Libère le tableau RR.
+ */
+void ecg_intervals_free(ECG_Intervals *intervals);
+
+/* ================================
+ * Écriture des fichiers de résultats
+ * ================================ */
+/**
+ * @brief Crée (ou tronque) @p filename et y écrit @p len octets en un seul write(), bouclé sur les écritures partielles.
+ *
+ * Partagé par les écrivains JSON et colonnes, qui assemblent le document en mémoire avant de l'écrire.
+ *
+ * @return 0 en cas de succès, -1 si le fichier ne s'ouvre pas, -2 en cas d'échec d'écriture ou de fermeture.
+ */
+int ecg_write_file(const char *filename, const void *data, size_t len);
+
 #endif /* OUTPUT_STRUCTS_H */
@@ -0,0 +1,57 @@
+"""
+Génère src/number_parser_table.h : puissances de 5 tronquées sur 128 bits
+pour l'algorithme d'Eisel-Lemire (même construction que fast_float).
+
+Usage : python3 scripts/gen_pow5_table.py > src/number_parser_table.h
+"""
+
+Q_MIN = -100
+Q_MAX = 100
+
+
+def pow5_128(q):
+    if q < 0:
+        power5 = 5 ** -q
+        z = 0
+        while (1 << z) < power5:
+            z += 1
+        if q >= -27:
+            b = z + 127
+            c = 2 ** b // power5 + 1
+        else:
+            b = 2 * z + 2 * 64
+            c = 2 ** b // power5 + 1
+            while c >= (1 << 128):
+                c //= 2
+        return c
+
+    power5 = 5 ** q
+    while power5 < (1 << 127):
+        power5 *= 2
+    while power5 >= (1 << 128):
+        power5 //= 2
+    return power5
+
+
+def main():
+    print("/* Généré par scripts/gen_pow5_table.py, ne pas modifier. */")
+    print("#ifndef NUMBER_PARSER_TABLE_H")
+    print("#define NUMBER_PARSER_TABLE_H")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("#define POW5_Q_MIN (%d)" % Q_MIN)
+    print("#define POW5_Q_MAX (%d)" % Q_MAX)
+    print()
+    print("/* 5^q normalisé (bit 127 à 1), tronqué sur 128 bits : { 64 bits hauts, 64 bits bas }. */")
+    print("static const uint64_t pow5_128[%d][2] = {" % (Q_MAX - Q_MIN + 1))
+    for q in range(Q_MIN, Q_MAX + 1):
+        c = pow5_128(q)
+        print("    { 0x%016xULL, 0x%016xULL }, /* 5^%d */" % (c >> 64, c & ((1 << 64) - 1), q))
+    print("};")
+    print()
+    print("#endif /* NUMBER_PARSER_TABLE_H */")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,8 +1,43 @@
 import json
 import argparse
 import matplotlib.pyplot as plt
+import numpy as np
 import pandas as pd
 
+# Sortie binaire en colonnes de ecg_dealination (--format columnar), voir include/columnar_writer.h
+COLUMNAR_MAGIC = b"ECGRES\0\0"
+COLUMNAR_HEADER = np.dtype([("magic", "S8"), ("version", "<u4"), ("n_columns", "<u4"),
+                            ("sampling_rate_hz", "<u4"), ("reserved", "V44")])
+COLUMNAR_ENTRY = np.dtype([("name", "S8"), ("type", "<u4"), ("reserved", "<u4"),
+                           ("count", "<u8"), ("offset", "<u8")])
+COLUMNAR_TYPES = {1: np.int32, 2: np.float32}
+
+# Onde absente (ECG_WAVE_NONE, include/output_structs.h) : P/Q/S/T sont parallèles à R
+WAVE_NONE = -1
+
+
+def load_columnar(buf):
+    """Colonnes R/P/Q/S/T/RR d'un fichier columnar, sans copie (numpy.frombuffer)."""
+    header = np.frombuffer(buf, dtype=COLUMNAR_HEADER, count=1)[0]
+    entries = np.frombuffer(buf, dtype=COLUMNAR_ENTRY, count=int(header["n_columns"]),
+                            offset=COLUMNAR_HEADER.itemsize)
+    columns = {}
+    for e in entries:
+        columns[e["name"].decode()] = np.frombuffer(buf, dtype=COLUMNAR_TYPES[int(e["type"])],
+                                                    count=int(e["count"]), offset=int(e["offset"]))
+    return columns
+
+
+def load_results(path):
+    """Résultats JSON ou columnar (détecté par la signature) : dict {"peaks": {...}, "intervals": {...}}."""
+    with open(path, "rb") as f:
+        buf = f.read()
+    if buf.startswith(COLUMNAR_MAGIC):
+        columns = load_columnar(buf)
+        peaks = {name: columns[name] for name in ("R", "P", "Q", "S", "T") if name in columns}
+        return {"peaks": peaks, "intervals": {"RR": columns.get("RR", np.empty(0, np.float32))}}
+    return json.loads(buf)
+
 
 def main():
     parser = argparse.ArgumentParser(
@@ -17,7 +52,7 @@ def main():
     parser.add_argument(
         "--json",
         required=True,
-        help="Chemin vers le fichier JSON des pics"
+        help="Chemin vers le fichier des pics (JSON ou --format columnar)"
     )
     parser.add_argument(
         "--lead",
@@ -41,14 +76,14 @@ def main():
 
     ecg_signal = df.loc[args.lead].values[:args.samples]
 
-    # Charger le fichier JSON contenant les pics
-    with open(args.json, "r") as f:
-        data = json.load(f)
+    # Charger le fichier contenant les pics (JSON ou colonnes binaires)
+    data = load_results(args.json)
 
     peaks = data["peaks"]
 
+    # Ondes absentes (WAVE_NONE) et pics hors de la fenêtre affichée écartés
     def filter_peaks(name):
-        return [p for p in peaks.get(name, []) if p < args.samples]
+        return [int(p) for p in peaks.get(name, []) if 0 <= p < len(ecg_signal)]
 
     p_peaks = filter_peaks("P")
     q_peaks = filter_peaks("Q")
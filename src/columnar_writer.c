@@ -0,0 +1,57 @@
+#include "columnar_writer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* En-tête et entrées du répertoire de taille fixe (format documenté dans columnar_writer.h). */
+typedef char columnar_header_size_check[(sizeof(ECG_Columnar_Header) == 64) ? 1 : -1];
+typedef char columnar_column_size_check[(sizeof(ECG_Columnar_Column) == 32) ? 1 : -1];
+
+static uint64_t align_up(uint64_t n) {
+    return (n + ECG_COLUMNAR_ALIGN - 1) & ~(uint64_t)(ECG_COLUMNAR_ALIGN - 1);
+}
+
+int write_columnar(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals,
+                   int sampling_rate_hz) {
+    if (!filename || !peaks || !intervals) return -1;
+
+    const int *int_columns[] = { peaks->R, peaks->P, peaks->Q, peaks->S, peaks->T };
+    const int counts[] = { peaks->R_count, peaks->P_count, peaks->Q_count, peaks->S_count, peaks->T_count,
+                           intervals->count };
+    static const char names[ECG_COLUMNAR_COLUMNS][8] = { "R", "P", "Q", "S", "T", "RR" };
+
+    // Répertoire : positions calculées avant l'assemblage, un seul buffer alloué
+    ECG_Columnar_Column dir[ECG_COLUMNAR_COLUMNS];
+    uint64_t offset = align_up(sizeof(ECG_Columnar_Header) + sizeof(dir));
+    for (int c = 0; c < ECG_COLUMNAR_COLUMNS; c++) {
+        memset(&dir[c], 0, sizeof(dir[c]));
+        memcpy(dir[c].name, names[c], sizeof(dir[c].name));
+        dir[c].type = (c < 5) ? ECG_COLUMN_INT32 : ECG_COLUMN_FLOAT32;
+        dir[c].count = (uint64_t)(counts[c] > 0 ? counts[c] : 0);
+        dir[c].offset = offset;
+        offset = align_up(offset + dir[c].count * 4);
+    }
+
+    const size_t size = (size_t)offset;
+    unsigned char *buf = calloc(1, size);
+    if (!buf) return -3;
+
+    ECG_Columnar_Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ECG_COLUMNAR_MAGIC, sizeof(h.magic));
+    h.version = ECG_COLUMNAR_VERSION;
+    h.n_columns = ECG_COLUMNAR_COLUMNS;
+    h.sampling_rate_hz = (uint32_t)(sampling_rate_hz > 0 ? sampling_rate_hz : 0);
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), dir, sizeof(dir));
+
+    for (int c = 0; c < 5; c++) {
+        int32_t *dst = (int32_t *)(void *)(buf + dir[c].offset);
+        for (uint64_t i = 0; i < dir[c].count; i++) dst[i] = (int32_t)int_columns[c][i];
+    }
+    float *rr = (float *)(void *)(buf + dir[5].offset);
+    for (uint64_t i = 0; i < dir[5].count; i++) rr[i] = (float)intervals->RR[i];
+
+    const int rc = ecg_write_file(filename, buf, size);
+    free(buf);
+    return rc;
+}
@@ -1,87 +1,322 @@
 #include "csv_reader.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
-#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "number_parser.h"
 
-double ecg_data[LEADS][MAX_SAMPLES];
-int sample_count = 0;
+#define FILEBUF_SIZE (1 << 20) // 1 MiB
 
-static void skip_spaces(char **p) {
-    while (**p && isspace((unsigned char)**p)) (*p)++;
+// En dessous, le démarrage des threads coûte plus que le parse d'une ligne
+#define PARALLEL_MIN_BYTES (1 << 20) // 1 MiB
+
+/* Agrandit la dérivation lead (doublement de capacité), pas de limite de longueur. */
+static int grow_lead(ECG_Record *rec, int lead) {
+    size_t cap = rec->capacity[lead] ? rec->capacity[lead] * 2 : MAX_SAMPLES;
+    double *p = realloc(rec->buffer[lead], sizeof(double) * cap);
+    if (!p) return -1;
+    rec->buffer[lead] = p;
+    rec->capacity[lead] = cap;
+    return 0;
 }
 
-int read_csv(const char *filename) {
-    FILE *f = fopen(filename, "r");
-    if (!f) {
-        perror("fopen");
-        return -1;
+/* Champ suivant : juste après la prochaine virgule, ou end s'il n'y en a plus. */
+static const char *next_field(const char *p, const char *end) {
+    const char *comma = memchr(p, ',', (size_t)(end - p));
+    return comma ? comma + 1 : end;
+}
+
+void ecg_record_init(ECG_Record *rec) {
+    if (!rec) return;
+    for (int lead = 0; lead < LEADS; lead++) {
+        rec->data[lead] = NULL;
+        rec->buffer[lead] = NULL;
+        rec->capacity[lead] = 0;
+    }
+    rec->leads = 0;
+    rec->samples = 0;
+    rec->sampling_rate_hz = 0;
+    rec->line = NULL;
+    rec->line_cap = 0;
+    rec->filebuf = NULL;
+    rec->map = NULL;
+    rec->map_size = 0;
+    rec->pending = 0;
+    for (int lead = 0; lead < LEADS; lead++) rec->raw_begin[lead] = rec->raw_end[lead] = NULL;
+    rec->raw_dtype = -1;
+    rec->raw_scale = 1.0;
+    rec->decode = NULL;
+}
+
+void ecg_record_unmap(ECG_Record *rec) {
+    if (!rec) return;
+    if (rec->map) munmap(rec->map, rec->map_size);
+    rec->map = NULL;
+    rec->map_size = 0;
+    // Les dérivations en attente pointaient dans la projection
+    rec->pending = 0;
+    rec->decode = NULL;
+    for (int lead = 0; lead < LEADS; lead++) rec->data[lead] = rec->buffer[lead];
+}
+
+void ecg_record_free(ECG_Record *rec) {
+    if (!rec) return;
+    ecg_record_unmap(rec);
+    for (int lead = 0; lead < LEADS; lead++) free(rec->buffer[lead]);
+    free(rec->line);
+    free(rec->filebuf);
+    ecg_record_init(rec);
+}
+
+int ecg_record_reserve(ECG_Record *rec, int lead, size_t n) {
+    while (rec->capacity[lead] < n) {
+        if (grow_lead(rec, lead) != 0) return -1;
     }
+    rec->data[lead] = rec->buffer[lead];
+    return 0;
+}
 
-    static char filebuf[1 << 20]; // 1 MiB
-    setvbuf(f, filebuf, _IOFBF, sizeof(filebuf));
+/*
+ * Parse une ligne de dérivation [line, end) (sans '\n') dans rec->data[lead].
+ * Retourne le nombre d'échantillons lus, -3 si l'allocation échoue.
+ * Ne lit jamais au-delà de end : utilisable directement sur un fichier mappé.
+ */
+static int parse_row(ECG_Record *rec, int lead, const char *line, const char *end) {
+    while (end > line && (end[-1] == '\r' || end[-1] == '\n')) end--;
 
-    int c;
-    while ((c = fgetc(f)) != '\n' && c != EOF) { /* skip */ }
+    // Première colonne : nom de la dérivation
+    const char *p = next_field(line, end);
 
-    char *line = NULL;
-    size_t cap = 0;
+    // Une valeur au plus par virgule restante : capacité réservée une fois, pas de test dans la boucle
+    size_t fields = 1;
+    for (const char *c = p; (c = memchr(c, ',', (size_t)(end - c))) != NULL; c++) fields++;
+    if (ecg_record_reserve(rec, lead, fields) != 0) return -3;
 
-    int lead = 0;
-    int loaded_samples = -1;
+    // HPC : une seule passe sur la ligne, parse_double s'arrête sur le délimiteur,
+    // memchr ne sert qu'à sauter les champs non numériques
+    double *dst = rec->data[lead];
+    int s = 0;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) break;
 
-    while (lead < LEADS) {
-        ssize_t n = getline(&line, &cap, f);
-        if (n == -1) break;
+        const char *q = parse_double(p, end, &dst[s]);
+        if (q == p) {
+            p = next_field(p, end);
+            continue;
+        }
+        s++;
 
-        char *p = line;
+        p = (q < end && *q == ',') ? q + 1 : next_field(q, end);
+    }
+    return s;
+}
+
+/* Dérivation l demandée par le masque (ECG_LEADS_ALL : toutes). */
+static int lead_wanted(unsigned lead_mask, int lead) {
+    return lead_mask == ECG_LEADS_ALL || (lead_mask >> lead) & 1u;
+}
 
-        while (n > 0 && (line[n-1] == '\n' || line[n-1] == '\r')) {
-            line[--n] = '\0';
+/* Toutes les dérivations décodées doivent avoir la même longueur que la première décodée. */
+static int check_rows(ECG_Record *rec, const int *counts, int rows, unsigned lead_mask, const char *filename) {
+    int first = -1;
+    for (int lead = 0; lead < rows; lead++) {
+        if (!lead_wanted(lead_mask, lead)) continue;
+        if (counts[lead] < 0) {
+            fprintf(stderr, "Erreur: allocation des échantillons impossible.\n");
+            return counts[lead];
         }
+        if (first < 0) first = lead;
+        if (counts[lead] != counts[first]) {
+            fprintf(stderr, "Erreur: lead %d: %d échantillons au lieu de %d (%s).\n",
+                    lead, counts[lead], counts[first], filename);
+            return -4;
+        }
+    }
+
+    if (first < 0 || counts[first] <= 0) {
+        fprintf(stderr, "Erreur: aucun lead/échantillon lu (%s).\n", filename);
+        return -2;
+    }
 
-        while (*p && *p != ',') p++;
-        if (*p == ',') p++;
+    rec->leads = rows;
+    rec->samples = counts[first];
+    return 0;
+}
+
+/* Décodage différé d'une ligne CSV gardée dans la projection (ecg_record_lead). */
+static int decode_csv_row(ECG_Record *rec, int lead) {
+    const int n = parse_row(rec, lead, rec->raw_begin[lead], rec->raw_end[lead]);
+    if (n < 0) return n;
+    if (n != rec->samples) {
+        fprintf(stderr, "Erreur: lead %d: %d échantillons au lieu de %d.\n", lead, n, rec->samples);
+        return -4;
+    }
+    return 0;
+}
 
-        int s = 0;
-        while (*p && s < MAX_SAMPLES) {
-            skip_spaces(&p);
-            if (!*p) break;
+/*
+ * Chemin mmap : bornes des lignes repérées d'abord (memchr), puis une ligne = une dérivation
+ * parsée par thread directement dans son tableau, sans copie getline ni couche stdio.
+ * Retourne 1 si le fichier ne peut pas être mappé (tube, fichier vide...) : l'appelant passe par stdio.
+ */
+static int read_csv_mmap(const char *filename, ECG_Record *rec, unsigned lead_mask) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) {
+        close(fd);
+        return 1;
+    }
 
-            errno = 0;
-            char *end = NULL;
-            double v = strtod(p, &end);
+    const size_t size = (size_t)sb.st_size;
+    const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 1;
+    madvise((void *)map, size, MADV_SEQUENTIAL | MADV_WILLNEED);
 
-            if (end == p) {
-                while (*p && *p != ',') p++;
-                if (*p == ',') p++;
-                continue;
-            }
-            if (errno == ERANGE) {
-                // overflow/underflow, on garde v mais tu peux décider de return error
-            }
+    const char *end = map + size;
 
-            ecg_data[lead][s++] = v;
-            p = end;
+    // Ligne d'en-tête (indices des colonnes) ignorée
+    const char *p = memchr(map, '\n', size);
+    p = p ? p + 1 : end;
 
-            while (*p && *p != ',') p++;
-            if (*p == ',') p++;
+    const char *row_begin[LEADS], *row_end[LEADS];
+    int rows = 0;
+    while (rows < LEADS && p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        row_begin[rows] = p;
+        row_end[rows] = nl ? nl : end;
+        rows++;
+        p = nl ? nl + 1 : end;
+    }
+
+    // Lignes non demandées : bornes gardées, aucune conversion (décodées par ecg_record_lead au besoin)
+    int counts[LEADS];
+    unsigned pending = 0;
+    for (int lead = 0; lead < rows; lead++) {
+        if (lead_wanted(lead_mask, lead)) continue;
+        pending |= 1u << lead;
+        rec->raw_begin[lead] = row_begin[lead];
+        rec->raw_end[lead] = row_end[lead];
+        rec->data[lead] = NULL;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1) if (size >= PARALLEL_MIN_BYTES)
+    for (int lead = 0; lead < rows; lead++) {
+        if (!(pending & (1u << lead))) counts[lead] = parse_row(rec, lead, row_begin[lead], row_end[lead]);
+    }
+
+    const int rc = check_rows(rec, counts, rows, lead_mask, filename);
+    if (rc != 0 || pending == 0) {
+        munmap((void *)map, size);
+        // Échec : plus rien en attente, les vues retombent sur les buffers propres
+        for (int lead = 0; lead < rows; lead++) {
+            if (pending & (1u << lead)) rec->data[lead] = rec->buffer[lead];
         }
+        return rc;
+    }
 
-        if (loaded_samples == -1) loaded_samples = s;
+    // Projection gardée jusqu'à la lecture suivante (ecg_record_unmap)
+    rec->map = (void *)map;
+    rec->map_size = size;
+    rec->pending = pending;
+    rec->raw_dtype = -1;
+    rec->decode = decode_csv_row;
+    return 0;
+}
 
-        lead++;
+/* Chemin stdio : lecture ligne à ligne (entrées non mappables). */
+static int read_csv_stdio(const char *filename, ECG_Record *rec, unsigned lead_mask) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+
+    // Buffer stdio propre à l'enregistrement, alloué une fois puis réutilisé
+    if (!rec->filebuf) rec->filebuf = malloc(FILEBUF_SIZE);
+    if (rec->filebuf) setvbuf(f, rec->filebuf, _IOFBF, FILEBUF_SIZE);
+
+    int c;
+    while ((c = fgetc(f)) != '\n' && c != EOF) { /* skip */ }
+
+    int counts[LEADS];
+    int rows = 0;
+    while (rows < LEADS) {
+        ssize_t n = getline(&rec->line, &rec->line_cap, f);
+        if (n == -1) break;
+
+        // Ligne non demandée : lue mais pas convertie, perdue (un tube ne se relit pas)
+        if (lead_wanted(lead_mask, rows)) counts[rows] = parse_row(rec, rows, rec->line, rec->line + n);
+        else rec->data[rows] = NULL;
+        rows++;
     }
 
-    free(line);
     fclose(f);
+    const int rc = check_rows(rec, counts, rows, lead_mask, filename);
+    if (rc != 0) for (int lead = 0; lead < rows; lead++) rec->data[lead] = rec->buffer[lead];
+    return rc;
+}
 
-    if (lead == 0 || loaded_samples <= 0) {
-        fprintf(stderr, "Erreur: aucun lead/échantillon lu.\n");
-        return -2;
+int read_csv_record_leads(const char *filename, ECG_Record *rec, unsigned lead_mask) {
+    if (!filename || !rec) return -1;
+
+    ecg_record_unmap(rec);
+    rec->sampling_rate_hz = 0;
+
+    int rc = read_csv_mmap(filename, rec, lead_mask);
+    if (rc == 1) rc = read_csv_stdio(filename, rec, lead_mask);
+    return rc;
+}
+
+int read_csv_record(const char *filename, ECG_Record *rec) {
+    return read_csv_record_leads(filename, rec, ECG_LEADS_ALL);
+}
+
+const double *ecg_record_lead(ECG_Record *rec, int lead) {
+    if (!rec || lead < 0 || lead >= rec->leads) return NULL;
+    if (rec->pending & (1u << lead)) {
+        if (!rec->decode || rec->decode(rec, lead) != 0) return NULL;
+        rec->pending &= ~(1u << lead);
     }
+    return rec->data[lead];
+}
 
-    sample_count = loaded_samples;
-    printf("CSV chargé avec %d leads et %d échantillons.\n", lead, sample_count);
-    return 0;
+int write_csv_record(const char *filename, const ECG_Record *rec) {
+    if (!filename || !rec || rec->leads <= 0 || rec->samples <= 0) return -1;
+
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+    // Gros buffer stdio : quelques write() pour tout le fichier
+    char *buf = malloc(FILEBUF_SIZE);
+    if (buf) setvbuf(f, buf, _IOFBF, FILEBUF_SIZE);
+
+    // Même disposition que les exports lus : en-tête d'indices, puis une ligne "leadN" par dérivation.
+    // %.17g : relu à l'identique par parse_double()
+    int rc = 0;
+    fputc(',', f);
+    for (int i = 0; i < rec->samples; i++) fprintf(f, i ? ",%d" : "%d", i);
+    for (int lead = 0; lead < rec->leads; lead++) {
+        fprintf(f, "\nlead%d", lead + 1);
+        const double *x = rec->data[lead];
+        for (int i = 0; i < rec->samples; i++) fprintf(f, ",%.17g", x[i]);
+    }
+    fputc('\n', f);
+
+    if (ferror(f)) rc = -2;
+    if (fclose(f) != 0) rc = -2;
+    free(buf);
+    if (rc != 0) fprintf(stderr, "Erreur: écriture de %s impossible.\n", filename);
+    return rc;
 }
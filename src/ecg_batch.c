@@ -0,0 +1,244 @@
+/**
+ * @file    ecg_batch.c
+ * @brief   Mode batch : pool de workers, un ECG_Context + un ECG_Record par worker.
+ *
+ * Découpage :
+ * 1. Construction de la liste des fichiers (dossier ou fichier liste).
+ * 2. Région parallèle : chaque worker alloue une fois son contexte et ses buffers,
+ *    puis prend les fichiers un par un (ordonnancement dynamique, fichiers de tailles variables).
+ * 3. Sortie dans un seul fichier JSON Lines (lignes écrites sous verrou) ou un fichier par enregistrement.
+ */
+#include "ecg_batch.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "csv_reader.h"
+#include "ecg_binary.h"
+#include "json_writer.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* ===============================================================================
+ * Liste des fichiers
+ * =============================================================================== */
+
+typedef struct {
+    char **paths;
+    int count;
+    int capacity;
+} Path_List;
+
+static int path_list_add(Path_List *list, const char *dir, const char *name) {
+    if (list->count == list->capacity) {
+        int cap = list->capacity ? list->capacity * 2 : 64;
+        char **p = realloc(list->paths, sizeof(char *) * (size_t)cap);
+        if (!p) return -1;
+        list->paths = p;
+        list->capacity = cap;
+    }
+
+    size_t len = (dir ? strlen(dir) + 1 : 0) + strlen(name) + 1;
+    char *path = malloc(len);
+    if (!path) return -1;
+    if (dir) snprintf(path, len, "%s/%s", dir, name);
+    else snprintf(path, len, "%s", name);
+
+    list->paths[list->count++] = path;
+    return 0;
+}
+
+static void path_list_free(Path_List *list) {
+    for (int i = 0; i < list->count; i++) free(list->paths[i]);
+    free(list->paths);
+}
+
+static int has_suffix(const char *s, const char *suffix) {
+    size_t ls = strlen(s), lx = strlen(suffix);
+    return ls >= lx && strcmp(s + ls - lx, suffix) == 0;
+}
+
+static int cmp_paths(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* Dossier : tous les *.csv et *.ecgb, triés pour un ordre de traitement reproductible. */
+static int list_directory(const char *dir, Path_List *list) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror("opendir");
+        return -1;
+    }
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        const int wanted = has_suffix(e->d_name, ".csv") || has_suffix(e->d_name, ECG_BIN_EXTENSION);
+        if (wanted && path_list_add(list, dir, e->d_name) != 0) {
+            closedir(d);
+            return -1;
+        }
+    }
+    closedir(d);
+
+    qsort(list->paths, (size_t)list->count, sizeof(char *), cmp_paths);
+    return 0;
+}
+
+/* Fichier liste : un chemin par ligne, lignes vides et commentaires (#) ignorés. */
+static int list_file(const char *filename, Path_List *list) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    int rc = 0;
+    while ((n = getline(&line, &cap, f)) != -1) {
+        while (n > 0 && (line[n-1] == '\n' || line[n-1] == '\r')) line[--n] = '\0';
+        if (n == 0 || line[0] == '#') continue;
+        if (path_list_add(list, NULL, line) != 0) {
+            rc = -1;
+            break;
+        }
+    }
+
+    free(line);
+    fclose(f);
+    return rc;
+}
+
+/* ===============================================================================
+ * Sortie
+ * =============================================================================== */
+
+/* <outdir>/<nom du fichier sans .csv/.ecgb>.json */
+static void output_path(char *dst, size_t size, const char *outdir, const char *input) {
+    const char *base = strrchr(input, '/');
+    base = base ? base + 1 : input;
+
+    size_t len = strlen(base);
+    if (has_suffix(base, ".csv")) len -= 4;
+    else if (has_suffix(base, ECG_BIN_EXTENSION)) len -= strlen(ECG_BIN_EXTENSION);
+    snprintf(dst, size, "%s/%.*s.json", outdir, (int)len, base);
+}
+
+/* Nombre de workers par défaut : un par cœur disponible. */
+static int default_jobs(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+int ecg_batch_run(const char *input, const char *output, const ECG_Batch_Options *opt) {
+    if (!input || !output || !opt) return -1;
+    if (opt->lead_index < 0 || opt->lead_index >= LEADS) return -1;
+
+    struct stat sb;
+    if (stat(input, &sb) != 0) {
+        perror("stat");
+        return -1;
+    }
+
+    Path_List list = { NULL, 0, 0 };
+    if ((S_ISDIR(sb.st_mode) ? list_directory(input, &list) : list_file(input, &list)) != 0) {
+        path_list_free(&list);
+        return -1;
+    }
+
+    // Sortie unique JSON Lines, ou dossier d'un fichier par enregistrement
+    const int jsonl = has_suffix(output, ".jsonl");
+    FILE *out = NULL;
+    if (jsonl) {
+        out = fopen(output, "w");
+        if (!out) {
+            perror("fopen");
+            path_list_free(&list);
+            return -1;
+        }
+    } else if (mkdir(output, 0755) != 0 && errno != EEXIST) {
+        perror("mkdir");
+        path_list_free(&list);
+        return -1;
+    }
+
+    int failures = 0;
+    const int jobs = (opt->jobs > 0) ? opt->jobs : default_jobs();
+
+    #pragma omp parallel num_threads(jobs)
+    {
+        // État propre au worker, réutilisé pour tous ses fichiers
+        ECG_Record rec;
+        ECG_Peaks peaks;
+        ECG_Intervals intervals;
+        ECG_Context *ctx = NULL;
+        size_t ctx_capacity = 0;
+        int ctx_fs = 0;
+        int worker_ok = ecg_peaks_init(&peaks, 0) == 0 && ecg_intervals_init(&intervals, 0) == 0;
+        ecg_record_init(&rec);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int i = 0; i < list.count; i++) {
+            const char *path = list.paths[i];
+            int ok = worker_ok && opt->lead_index >= 0 && opt->lead_index < LEADS
+                     && ecg_record_load_leads(path, &rec, 1u << opt->lead_index) == 0 && opt->lead_index < rec.leads;
+            const int fs = (ok && rec.sampling_rate_hz > 0) ? rec.sampling_rate_hz : opt->params.sampling_rate_hz;
+
+            // Contexte recréé uniquement si l'enregistrement dépasse sa capacité ou change de fréquence
+            if (ok && ((size_t)rec.samples > ctx_capacity || fs != ctx_fs)) {
+                ECG_Params params = opt->params;
+                params.max_samples = (size_t)rec.samples;
+                params.sampling_rate_hz = fs;
+                ecg_destroy(ctx);
+                ctx = ecg_create(&params);
+                ctx_capacity = ctx ? params.max_samples : 0;
+                ctx_fs = ctx ? fs : 0;
+                ok = ctx != NULL;
+            }
+
+            if (ok) {
+                ok = ecg_analyze(ctx, rec.data[opt->lead_index], (size_t)rec.samples, opt->lead_index,
+                                 &peaks, &intervals) == ECG_OK;
+            }
+
+            if (ok) {
+                if (jsonl) {
+                    ok = write_json_line(out, path, &peaks, &intervals) == 0;
+                } else {
+                    char dst[4096];
+                    output_path(dst, sizeof(dst), output, path);
+                    ok = write_json(dst, &peaks, &intervals) == 0;
+                }
+            }
+
+            if (!ok) {
+                fprintf(stderr, "Erreur: échec de l'analyse de %s.\n", path);
+                #pragma omp atomic
+                failures++;
+            }
+        }
+
+        ecg_destroy(ctx);
+        ecg_record_free(&rec);
+        ecg_peaks_free(&peaks);
+        ecg_intervals_free(&intervals);
+    }
+
+    if (out && fclose(out) != 0) failures++;
+    path_list_free(&list);
+    return failures;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file    ecg_binary.c
+ * @brief   Format binaire ECG : écriture (conversion) et chargement par projection mémoire.
+ *
+ */
+#include "ecg_binary.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* L'en-tête occupe exactement un bloc aligné. */
+typedef char ecg_bin_header_size_check[(sizeof(ECG_Bin_Header) == ECG_BIN_ALIGN) ? 1 : -1];
+
+/* ================================
+ * Helpers (internes)
+ * ================================ */
+
+static size_t dtype_size(uint32_t dtype) {
+    switch (dtype) {
+        case ECG_DTYPE_I16: return sizeof(int16_t);
+        case ECG_DTYPE_F32: return sizeof(float);
+        case ECG_DTYPE_F64: return sizeof(double);
+        default:            return 0;
+    }
+}
+
+static uint64_t align_up(uint64_t n) {
+    return (n + ECG_BIN_ALIGN - 1) & ~(uint64_t)(ECG_BIN_ALIGN - 1);
+}
+
+/* Échelle int16 : la plus grande amplitude de l'enregistrement correspond à INT16_MAX. */
+static double i16_scale(const ECG_Record *rec) {
+    double max_abs = 0.0;
+    for (int lead = 0; lead < rec->leads; lead++)
+        for (int i = 0; i < rec->samples; i++)
+            if (fabs(rec->data[lead][i]) > max_abs) max_abs = fabs(rec->data[lead][i]);
+    return (max_abs > 0.0) ? max_abs / INT16_MAX : 1.0;
+}
+
+/* Écrit un bloc de dérivation converti dans dtype, complété par des zéros jusqu'à lead_stride. */
+static int write_lead(FILE *f, const double *x, int n, uint32_t dtype, double scale, uint64_t stride) {
+    unsigned char block[4096];
+    const size_t elem = dtype_size(dtype);
+    const int per_block = (int)(sizeof(block) / elem);
+
+    for (int off = 0; off < n; off += per_block) {
+        const int m = (n - off < per_block) ? n - off : per_block;
+        for (int i = 0; i < m; i++) {
+            const double v = x[off + i];
+            if (dtype == ECG_DTYPE_I16) {
+                long q = lrint(v / scale);
+                if (q > INT16_MAX) q = INT16_MAX;
+                if (q < INT16_MIN) q = INT16_MIN;
+                const int16_t s = (int16_t)q;
+                memcpy(block + (size_t)i * elem, &s, elem);
+            } else if (dtype == ECG_DTYPE_F32) {
+                const float s = (float)v;
+                memcpy(block + (size_t)i * elem, &s, elem);
+            } else {
+                memcpy(block + (size_t)i * elem, &v, elem);
+            }
+        }
+        if (fwrite(block, elem, (size_t)m, f) != (size_t)m) return -1;
+    }
+
+    static const unsigned char zeros[ECG_BIN_ALIGN];
+    const size_t pad = (size_t)(stride - (uint64_t)n * elem);
+    return (fwrite(zeros, 1, pad, f) == pad) ? 0 : -1;
+}
+
+/* Contrôle de cohérence de l'en-tête par rapport à la taille du fichier. */
+static int header_valid(const ECG_Bin_Header *h, size_t file_size) {
+    const size_t elem = dtype_size(h->dtype);
+    if (memcmp(h->magic, ECG_BIN_MAGIC, sizeof(h->magic)) != 0) return 0;
+    if (h->version != ECG_BIN_VERSION || elem == 0) return 0;
+    if (h->leads == 0 || h->leads > LEADS) return 0;
+    if (h->samples == 0 || h->samples > INT_MAX || h->sampling_rate_hz == 0) return 0;
+    if (h->lead_stride % ECG_BIN_ALIGN || h->data_offset % ECG_BIN_ALIGN) return 0;
+    if (h->lead_stride < h->samples * elem || h->data_offset < sizeof(*h)) return 0;
+    if (h->lead_stride > file_size || h->data_offset > file_size) return 0;
+    if (h->data_offset + h->leads * h->lead_stride > file_size) return 0;
+    return !(h->dtype == ECG_DTYPE_I16 && !(h->scale > 0.0));
+}
+
+/* ================================
+ * API
+ * ================================ */
+
+int ecg_binary_write(const char *filename, const ECG_Record *rec, ECG_Dtype dtype, int sampling_rate_hz) {
+    if (!filename || !rec || rec->leads <= 0 || rec->samples <= 0) return -1;
+    if (dtype_size((uint32_t)dtype) == 0 || sampling_rate_hz <= 0) return -1;
+
+    ECG_Bin_Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ECG_BIN_MAGIC, sizeof(h.magic));
+    h.version = ECG_BIN_VERSION;
+    h.dtype = (uint32_t)dtype;
+    h.leads = (uint32_t)rec->leads;
+    h.sampling_rate_hz = (uint32_t)sampling_rate_hz;
+    h.samples = (uint64_t)rec->samples;
+    h.scale = (dtype == ECG_DTYPE_I16) ? i16_scale(rec) : 1.0;
+    h.lead_stride = align_up(h.samples * dtype_size(h.dtype));
+    h.data_offset = align_up(sizeof(h));
+
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+
+    int rc = (fwrite(&h, sizeof(h), 1, f) == 1) ? 0 : -1;
+    for (int lead = 0; lead < rec->leads && rc == 0; lead++)
+        rc = write_lead(f, rec->data[lead], rec->samples, h.dtype, h.scale, h.lead_stride);
+
+    if (fclose(f) != 0) rc = -1;
+    if (rc != 0) fprintf(stderr, "Erreur: écriture de %s impossible.\n", filename);
+    return rc;
+}
+
+/* Conversion d'un bloc int16 / float32 en double dans le buffer propre de la dérivation. */
+static int convert_lead(ECG_Record *rec, int lead, const void *src, size_t n, int dtype, double scale) {
+    if (ecg_record_reserve(rec, lead, n) != 0) {
+        fprintf(stderr, "Erreur: allocation des échantillons impossible.\n");
+        return -3;
+    }
+    double *dst = rec->data[lead];
+    if (dtype == ECG_DTYPE_I16) {
+        const int16_t *s = src;
+        for (size_t i = 0; i < n; i++) dst[i] = s[i] * scale;
+    } else {
+        const float *s = src;
+        for (size_t i = 0; i < n; i++) dst[i] = s[i];
+    }
+    return 0;
+}
+
+/* Décodage différé d'un bloc gardé dans la projection (ecg_record_lead). */
+static int decode_bin_lead(ECG_Record *rec, int lead) {
+    return convert_lead(rec, lead, rec->raw_begin[lead], (size_t)rec->samples, rec->raw_dtype, rec->raw_scale);
+}
+
+static int binary_load(const char *filename, ECG_Record *rec, unsigned lead_mask) {
+    if (!filename || !rec) return -1;
+    ecg_record_unmap(rec);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(ECG_Bin_Header)) {
+        close(fd);
+        fprintf(stderr, "Erreur: fichier binaire tronqué (%s).\n", filename);
+        return -2;
+    }
+
+    const size_t size = (size_t)sb.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    ECG_Bin_Header h;
+    memcpy(&h, map, sizeof(h));
+    if (!header_valid(&h, size)) {
+        munmap(map, size);
+        fprintf(stderr, "Erreur: en-tête binaire invalide (%s).\n", filename);
+        return -2;
+    }
+
+    const int n = (int)h.samples;
+    const unsigned char *base = (const unsigned char *)map + h.data_offset;
+
+    if (h.dtype == ECG_DTYPE_F64) {
+        // HPC : aucune copie, l'analyse lit les pages du fichier (blocs alignés sur 64 octets)
+        rec->map = map;
+        rec->map_size = size;
+        for (unsigned lead = 0; lead < h.leads; lead++)
+            rec->data[lead] = (double *)(void *)(base + lead * h.lead_stride);
+    } else {
+        // Formats compacts : conversion en double dans les buffers propres des dérivations demandées,
+        // les autres restent dans la projection jusqu'à leur premier accès
+        unsigned pending = 0;
+        for (unsigned lead = 0; lead < h.leads; lead++) {
+            const void *src = base + lead * h.lead_stride;
+            if (lead_mask != ECG_LEADS_ALL && !((lead_mask >> lead) & 1u)) {
+                pending |= 1u << lead;
+                rec->raw_begin[lead] = src;
+                rec->raw_end[lead] = (const char *)src + (size_t)n * dtype_size(h.dtype);
+                rec->data[lead] = NULL;
+                continue;
+            }
+            if (convert_lead(rec, (int)lead, src, (size_t)n, (int)h.dtype, h.scale) != 0) {
+                munmap(map, size);
+                return -3;
+            }
+        }
+        if (pending) {
+            rec->map = map;
+            rec->map_size = size;
+            rec->pending = pending;
+            rec->raw_dtype = (int)h.dtype;
+            rec->raw_scale = h.scale;
+            rec->decode = decode_bin_lead;
+        } else {
+            munmap(map, size);
+        }
+    }
+
+    rec->leads = (int)h.leads;
+    rec->samples = n;
+    rec->sampling_rate_hz = (int)h.sampling_rate_hz;
+    return 0;
+}
+
+int ecg_binary_load(const char *filename, ECG_Record *rec) {
+    return binary_load(filename, rec, ECG_LEADS_ALL);
+}
+
+int ecg_record_load_leads(const char *filename, ECG_Record *rec, unsigned lead_mask) {
+    if (!filename || !rec) return -1;
+
+    // Signature lue uniquement sur un fichier régulier : un tube perdrait ses premiers octets
+    char magic[sizeof(((ECG_Bin_Header *)0)->magic)];
+    int binary = 0;
+    struct stat sb;
+    FILE *f = (stat(filename, &sb) == 0 && S_ISREG(sb.st_mode)) ? fopen(filename, "rb") : NULL;
+    if (f) {
+        binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic)
+                 && memcmp(magic, ECG_BIN_MAGIC, sizeof(magic)) == 0;
+        fclose(f);
+    }
+
+    return binary ? binary_load(filename, rec, lead_mask) : read_csv_record_leads(filename, rec, lead_mask);
+}
+
+int ecg_record_load(const char *filename, ECG_Record *rec) {
+    return ecg_record_load_leads(filename, rec, ECG_LEADS_ALL);
+}
@@ -0,0 +1,278 @@
+/**
+ * @file    ecg_delineation.c
+ * @brief   Délinéation P, Q, S, T : extrema du signal passe-haut dans des fenêtres bornées autour de chaque R.
+ *
+ */
+#include "ecg_delineation.h"
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+/*
+ * Fenêtres de recherche autour du pic R (durées physiologiques adulte).
+ * Le complexe QRS dure 70 à 110 ms : Q et S sont à moins de 80 ms de R.
+ * Le sommet de T arrive avant ~60 % du RR (QT raccourci à fréquence élevée, Bazett), P dans le tiers
+ * du RR qui précède R (PR < 200 ms + demi-durée de P). Les plafonds en ms bornent le coût à fréquence lente.
+ */
+#define Q_WINDOW_MS     80
+#define S_WINDOW_MS     80
+#define T_GAP_MS        40      // T cherchée à partir de S + 40 ms (retour du segment ST)
+#define T_RR_FRACTION   0.6
+#define T_MAX_MS        450
+#define P_GAP_MS        20      // P cherchée jusqu'à Q - 20 ms
+#define P_RR_FRACTION   0.35
+#define P_MAX_MS        350
+
+// RR supposé pour un battement isolé (aucun voisin)
+#define DEFAULT_RR_MS   1000
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+/* Fenêtres converties en échantillons une fois par appel. */
+typedef struct {
+    ptrdiff_t q, s, t_gap, t_max, p_gap, p_max, rr_default;
+} Windows;
+
+/* Fenêtres d'un battement, tronquées au signal : [lo, hi] couvre P..T, [qrs_lo, qrs_hi] les recherches de Q et S. */
+typedef struct {
+    ptrdiff_t r, lo, hi;
+    ptrdiff_t qrs_lo, qrs_hi;
+} Beat_Span;
+
+static ptrdiff_t ms_to_samples(int ms, int fs) {
+    return (ptrdiff_t)(((long)ms * fs) / 1000);
+}
+
+static void windows_init(Windows *w, int fs) {
+    w->q = ms_to_samples(Q_WINDOW_MS, fs);
+    w->s = ms_to_samples(S_WINDOW_MS, fs);
+    w->t_gap = ms_to_samples(T_GAP_MS, fs);
+    w->t_max = ms_to_samples(T_MAX_MS, fs);
+    w->p_gap = ms_to_samples(P_GAP_MS, fs);
+    w->p_max = ms_to_samples(P_MAX_MS, fs);
+    w->rr_default = ms_to_samples(DEFAULT_RR_MS, fs);
+}
+
+/* Plus grande fenêtre P..T d'un battement. */
+static size_t max_span(int fs) {
+    return (size_t)(ms_to_samples(P_MAX_MS, fs) + ms_to_samples(T_MAX_MS, fs)) + 1;
+}
+
+/* Bornes du battement k : fractions du RR précédent (P) et suivant (T), plafonnées. */
+static void beat_span(const ECG_Peaks *peaks, int k, const Windows *w, size_t n_samples, Beat_Span *b) {
+    const ptrdiff_t r = peaks->R[k];
+    ptrdiff_t rr_before = (k > 0) ? r - peaks->R[k - 1] : -1;
+    ptrdiff_t rr_after = (k + 1 < peaks->R_count) ? peaks->R[k + 1] - r : -1;
+    if (rr_before < 0) rr_before = (rr_after >= 0) ? rr_after : w->rr_default;
+    if (rr_after < 0) rr_after = rr_before;
+
+    ptrdiff_t p_span = (ptrdiff_t)(P_RR_FRACTION * (double)rr_before);
+    ptrdiff_t t_span = (ptrdiff_t)(T_RR_FRACTION * (double)rr_after);
+    if (p_span > w->p_max) p_span = w->p_max;
+    if (t_span > w->t_max) t_span = w->t_max;
+
+    b->r = r;
+    b->lo = (r > p_span) ? r - p_span : 0;
+    b->hi = (r + t_span < (ptrdiff_t)n_samples) ? r + t_span : (ptrdiff_t)n_samples - 1;
+    b->qrs_lo = (r - w->q > b->lo) ? r - w->q : b->lo;
+    b->qrs_hi = (r + w->s < b->hi) ? r + w->s : b->hi;
+}
+
+/*
+ * Minimum sur [lo, hi] (bornes incluses, non vide), l'échantillon i est band[i - base]. Première occurrence.
+ * HPC : sélections sans branche (cmov), le signal bruité rendrait la comparaison imprévisible.
+ */
+static ptrdiff_t arg_min(const double *band, ptrdiff_t base, ptrdiff_t lo, ptrdiff_t hi) {
+    ptrdiff_t best = lo;
+    double best_val = band[lo - base];
+    for (ptrdiff_t i = lo + 1; i <= hi; i++) {
+        const double v = band[i - base];
+        const int better = v < best_val;
+        best = better ? i : best;
+        best_val = better ? v : best_val;
+    }
+    return best;
+}
+
+/*
+ * Maximum au-dessus de la droite qui joint les deux bords de la fenêtre (ligne de base locale) :
+ * la dérive lente ne déplace pas le sommet et l'onde garde toute son amplitude.
+ */
+static ptrdiff_t arg_max_detrended(const double *raw, ptrdiff_t base, ptrdiff_t lo, ptrdiff_t hi) {
+    if (hi <= lo) return lo;
+    const double first = raw[lo - base];
+    const double slope = (raw[hi - base] - first) / (double)(hi - lo);
+
+    ptrdiff_t best = lo;
+    double best_val = 0.0;
+    for (ptrdiff_t i = lo + 1; i <= hi; i++) {
+        const double v = raw[i - base] - first - slope * (double)(i - lo);
+        const int better = v > best_val;
+        best = better ? i : best;
+        best_val = better ? v : best_val;
+    }
+    return best;
+}
+
+/*
+ * Q et S d'abord (minima du passe-haut, band couvre [qrs_lo, qrs_hi]), puis T et P dont les fenêtres
+ * partent de S et Q. T et P sont des ondes lentes (1 à 5 Hz) que le passe-haut de 130 ms atténue fortement :
+ * leur sommet est cherché sur le signal brut (raw couvre [lo, hi]), ligne de base locale retirée.
+ * Une onde par battement, à l'indice k du R, ECG_WAVE_NONE si sa fenêtre est vide : P/Q/S/T restent parallèles à R.
+ * HPC : accès séquentiels sur ~1 RR par battement, au plus un passage par échantillon et par onde.
+ */
+static void delineate_beat(const double *band, const double *raw, const Beat_Span *b, const Windows *w,
+                           int k, ECG_Peaks *peaks) {
+    const ptrdiff_t r = b->r;
+    const int has_q = b->qrs_lo <= r - 1;
+    const int has_s = r + 1 <= b->qrs_hi;
+    const ptrdiff_t q = has_q ? arg_min(band, b->qrs_lo, b->qrs_lo, r - 1) : r;
+    const ptrdiff_t s = has_s ? arg_min(band, b->qrs_lo, r + 1, b->qrs_hi) : r;
+    peaks->Q[k] = has_q ? (int)q : ECG_WAVE_NONE;
+    peaks->S[k] = has_s ? (int)s : ECG_WAVE_NONE;
+
+    // Sans Q ou S, les fenêtres de P et T partent de R
+    const ptrdiff_t t_lo = s + w->t_gap;
+    peaks->T[k] = (t_lo <= b->hi) ? (int)arg_max_detrended(raw, b->lo, t_lo, b->hi) : ECG_WAVE_NONE;
+
+    const ptrdiff_t p_hi = q - w->p_gap;
+    peaks->P[k] = (b->lo <= p_hi) ? (int)arg_max_detrended(raw, b->lo, b->lo, p_hi) : ECG_WAVE_NONE;
+}
+
+// Un résultat par R : les appels sur le signal entier fixent les compteurs, les plages de battements non
+static void set_wave_counts(ECG_Peaks *peaks) {
+    peaks->P_count = peaks->Q_count = peaks->S_count = peaks->T_count = peaks->R_count;
+}
+
+static int beat_range_valid(const ECG_Peaks *peaks, int first_beat, int end_beat) {
+    return 0 <= first_beat && first_beat <= end_beat && end_beat <= peaks->R_count;
+}
+
+/* Fenêtre [lo, hi] du signal brut en double : directe pour un signal double, copiée dans copy sinon. */
+static const double *raw_window_f64(const double *signal, ptrdiff_t lo, ptrdiff_t hi, double *copy) {
+    (void)hi;
+    (void)copy;
+    return signal + lo;
+}
+
+static const double *raw_window_f32(const float *signal, ptrdiff_t lo, ptrdiff_t hi, double *copy) {
+    for (ptrdiff_t i = lo; i <= hi; i++) copy[i - lo] = (double)signal[i];
+    return copy;
+}
+
+static const double *raw_window_i16(const int16_t *signal, ptrdiff_t lo, ptrdiff_t hi, double *copy) {
+    for (ptrdiff_t i = lo; i <= hi; i++) copy[i - lo] = (double)signal[i];
+    return copy;
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+size_t ecg_delineation_scratch_size(int sampling_rate_hz) {
+    if (sampling_rate_hz <= 0) return 0;
+    return 2 * max_span(sampling_rate_hz); // bande de Q/S + copie double du brut (variantes typées)
+}
+
+ECG_Status ecg_delineate_beats(const double *signal, const double *high_pass, size_t high_pass_begin,
+                              size_t n_samples, int sampling_rate_hz, size_t low_pass_window,
+                              int first_beat, int end_beat, double *scratch, ECG_Peaks *peaks) {
+    if (!signal || !high_pass || !scratch || !peaks) return ECG_ERR_NULL;
+    if (sampling_rate_hz <= 0 || !beat_range_valid(peaks, first_beat, end_beat)) return ECG_ERR_PARAM;
+    const ptrdiff_t half = (ptrdiff_t)(low_pass_window / 2);
+    const ptrdiff_t last = (ptrdiff_t)n_samples - 1;
+    const ptrdiff_t hp_begin = (ptrdiff_t)high_pass_begin;
+
+    Windows w;
+    windows_init(&w, sampling_rate_hz);
+
+    for (int k = first_beat; k < end_beat; k++) {
+        Beat_Span b;
+        beat_span(peaks, k, &w, n_samples, &b);
+
+        // Moyenne glissante de la chaîne retrouvée sans refiltrer : MA[j] = x[j] - hp[j], centrée par j = i + win/2
+        for (ptrdiff_t i = b.qrs_lo; i <= b.qrs_hi; i++) {
+            const ptrdiff_t j = (i + half < last) ? i + half : last;
+            scratch[i - b.qrs_lo] = signal[i] - (signal[j] - high_pass[j - hp_begin]);
+        }
+        delineate_beat(scratch, signal + b.lo, &b, &w, k, peaks);
+    }
+    return ECG_OK;
+}
+
+ECG_Status ecg_delineate(const double *signal, const double *high_pass, size_t n_samples, int sampling_rate_hz,
+                         size_t low_pass_window, double *scratch, ECG_Peaks *peaks) {
+    const ECG_Status status = ecg_delineate_beats(signal, high_pass, 0, n_samples, sampling_rate_hz, low_pass_window,
+                                                  0, peaks ? peaks->R_count : 0, scratch, peaks);
+    if (status == ECG_OK) set_wave_counts(peaks);
+    return status;
+}
+
+/*
+ * Variantes sur le signal brut, une par type d'échantillon : moyenne glissante de ecg_highpass_ma recalculée
+ * pour j = i + win/2 sur la fenêtre QRS (montée comprise en début de signal), la somme étant amorcée sur
+ * les low_pass_window - 1 échantillons précédents ; bande[i] = x[i] - MA[j] dans la première moitié
+ * de scratch, copie double du brut (si nécessaire) dans la seconde. name##_range ne traite que les
+ * battements [first_beat, end_beat) ; seule la variante double est exposée par plage (ecg_delineate_raw_beats).
+ */
+#define DEFINE_DELINEATE_RAW(name, suffix, SAMPLE_T)                                                 \
+static inline ECG_Status name##_range(const SAMPLE_T *signal, size_t n_samples,                    \
+                                      int sampling_rate_hz, size_t low_pass_window, int first_beat,           \
+                                      int end_beat, double *scratch, ECG_Peaks *peaks) {            \
+    if (!signal || !scratch || !peaks) return ECG_ERR_NULL;                                         \
+    if (sampling_rate_hz <= 0 || !beat_range_valid(peaks, first_beat, end_beat))                    \
+        return ECG_ERR_PARAM;                                                                       \
+    const ptrdiff_t win = low_pass_window ? (ptrdiff_t)low_pass_window : 1;                         \
+    const ptrdiff_t half = (ptrdiff_t)(low_pass_window / 2);                                        \
+    const ptrdiff_t last = (ptrdiff_t)n_samples - 1;                                                \
+    double *copy = scratch + max_span(sampling_rate_hz);                                            \
+                                                                                                    \
+    Windows w;                                                                                      \
+    windows_init(&w, sampling_rate_hz);                                                             \
+                                                                                                    \
+    for (int k = first_beat; k < end_beat; k++) {                                                   \
+        Beat_Span b;                                                                                \
+        beat_span(peaks, k, &w, n_samples, &b);                                                     \
+                                                                                                    \
+        /* MA[j], j = min(i + win/2, dernier échantillon) croissant : chaque x ajouté une fois */   \
+        const ptrdiff_t j_lo = (b.qrs_lo + half < last) ? b.qrs_lo + half : last;                   \
+        ptrdiff_t next = (j_lo - win + 1 > 0) ? j_lo - win + 1 : 0;                                 \
+        ptrdiff_t count = 0;                                                                        \
+        double sum = 0.0;                                                                           \
+        for (ptrdiff_t i = b.qrs_lo; i <= b.qrs_hi; i++) {                                          \
+            const ptrdiff_t j = (i + half < last) ? i + half : last;                                \
+            for (; next <= j; next++) {                                                             \
+                sum += signal[next];                                                                \
+                if (++count > win) {                                                                \
+                    sum -= signal[next - win];                                                      \
+                    --count;                                                                        \
+                }                                                                                   \
+            }                                                                                       \
+            scratch[i - b.qrs_lo] = (double)signal[i] - sum / (double)count;                        \
+        }                                                                                           \
+        delineate_beat(scratch, raw_window_##suffix(signal, b.lo, b.hi, copy), &b, &w, k, peaks);   \
+    }                                                                                               \
+    return ECG_OK;                                                                                  \
+}                                                                                                   \
+                                                                                                    \
+ECG_Status name(const SAMPLE_T *signal, size_t n_samples, int sampling_rate_hz,                    \
+                size_t low_pass_window, double *scratch, ECG_Peaks *peaks) {                        \
+    const ECG_Status status = name##_range(signal, n_samples, sampling_rate_hz, low_pass_window, 0, \
+                                           peaks ? peaks->R_count : 0, scratch, peaks);             \
+    if (status == ECG_OK) set_wave_counts(peaks);                                                   \
+    return status;                                                                                  \
+}
+
+DEFINE_DELINEATE_RAW(ecg_delineate_raw, f64, double)
+DEFINE_DELINEATE_RAW(ecg_delineate_raw_f32, f32, float)
+DEFINE_DELINEATE_RAW(ecg_delineate_raw_i16, i16, int16_t)
+
+ECG_Status ecg_delineate_raw_beats(const double *signal, size_t n_samples, int sampling_rate_hz,
+                                   size_t low_pass_window, int first_beat, int end_beat, double *scratch,
+                                   ECG_Peaks *peaks) {
+    return ecg_delineate_raw_range(signal, n_samples, sampling_rate_hz, low_pass_window, first_beat, end_beat,
+                                   scratch, peaks);
+}
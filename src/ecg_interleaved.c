@@ -0,0 +1,466 @@
+/**
+ * @file    ecg_interleaved.c
+ * @brief   Moteur multi-dérivations entrelacé : les filtres et le détecteur de toutes les dérivations en une passe.
+ *
+ * Entrée entrelacée par échantillon (x[t * n_leads + l]) : une ligne par instant, les dérivations voisines dans
+ * le même vecteur. Chaque voie SIMD porte une dérivation (8 en AVX-512, 4 en AVX2) : une seule lecture séquentielle
+ * du signal au lieu d'une par dérivation, et les sommes glissantes de 8 dérivations avancent en une instruction.
+ *
+ * Par voie, mêmes opérations dans le même ordre que le noyau fusionné de ecg_processing.c :
+ * pics R identiques bit à bit à ecg_analyze() avec ECG_Params.fused (ou --isa scalar).
+ * Ce fichier est compilé sans contraction FMA (CMakeLists.txt) : a * b + c doit rester deux arrondis.
+ */
+#include "ecg_processing.h"
+#include "ecg_kernels.h"
+#include "ecg_pipeline.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ECG_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+#define IL_ALIGN 64
+
+// Même limite que ecg_analyze_all_leads (vote par masque de bits)
+#define IL_MAX_LEADS 32
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+typedef struct {
+    const double *x;            // signal entrelacé, n * leads
+    const double *band;         // passe-bande entrelacé (ECG_Params.filter), NULL = passe-haut x - MA(x)
+    double *mwi;                // MWI entrelacée, n * leads
+    double *sq_ring;            // (mask + 1) lignes du signal carré (fenêtre MWI)
+    size_t mask;
+    size_t n;
+    size_t leads;
+    size_t lp_win;
+    size_t mwi_win;
+    int refractory;
+    double max_mwi[IL_MAX_LEADS];
+} IL_Job;
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+/*
+ * Affinage du pic R sur le signal brut de la dérivation lead (colonne de stride leads) :
+ * même fenêtre et même règle (première occurrence du max) que find_max de ecg_processing.c.
+ */
+static int refine_strided(const IL_Job *job, size_t lead, int center) {
+    const int half_window = job->refractory / 2;
+    const int start = (center - half_window > 0) ? center - half_window : 0;
+    const int end = (center + half_window < (int)job->n) ? center + half_window : (int)job->n - 1;
+
+    const double *col = job->x + lead;
+    int best = start;
+    double best_val = col[(size_t)start * job->leads];
+    for (int i = start + 1; i <= end; i++) {
+        const double v = col[(size_t)i * job->leads];
+        if (v > best_val) {
+            best_val = v;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/*
+ * Groupes de W dérivations : le dernier recouvre le précédent s'il le faut (12 = 8 + 4 -> débuts 0 et 4) plutôt
+ * que des chargements masqués. Les voies recouvertes calculent deux fois la même chose ;
+ * seul le groupe qui possède une dérivation émet ses pics (bits de owned).
+ */
+static int lane_groups(size_t leads, size_t w, size_t start[], unsigned owned[]) {
+    const int groups = (int)((leads + w - 1) / w);
+    for (int g = 0; g < groups; g++) {
+        const size_t first = (size_t)g * w;
+        start[g] = (first + w <= leads) ? first : leads - w;
+        owned[g] = ((1u << w) - 1u) & ~((1u << (first - start[g])) - 1u);
+    }
+    return groups;
+}
+
+/*
+ * Moteur généré pour chaque largeur de vecteur. Opérations attendues (définies avant l'instanciation) :
+ * VEC / MASK, V_SET1, V_LOAD, V_STORE, V_ADD, V_SUB, V_MUL, V_DIV, V_MAX(a, b) = a > b ? a : b,
+ * V_GT / V_GE / V_LT -> MASK, M_AND, M_OR, M_ANDNOT(a, b) = a & ~b, V_BLEND(m, a, b) = m ? b : a, M_BITS.
+ *
+ * 1. front_end : passe-haut -> dérivée -> carré -> MWI pour toutes les dérivations, ligne par ligne, et max
+ *    de la MWI par voie (passe-bande : job->band, filtré avant par ecg_biquad_cascade_leads). Montée des fenêtres commune à toutes les voies : les tests portent sur t, pas sur
+ *    les données (aucune divergence entre voies).
+ * 2. detect : détecteur à seuil adaptatif vectorisé (signal_peak, noise_peak, seuil et dernier R par voie).
+ *    Les maxima locaux sont testés pour toutes les voies d'un coup ; les mises à jour du seuil sont des
+ *    sélections par masque, sans branche. Seuls les pics acceptés (un par battement) passent en scalaire.
+ */
+#define DEFINE_INTERLEAVED_ENGINE(suffix, ATTR, W)                                                     \
+ATTR static void front_end_##suffix(IL_Job *job) {                                                     \
+    size_t start[IL_MAX_LEADS];                                                                       \
+    unsigned owned[IL_MAX_LEADS];                                                                     \
+    const int groups = lane_groups(job->leads, (W), start, owned);                                    \
+    const size_t L = job->leads, lp_win = job->lp_win, mwi_win = job->mwi_win, mask = job->mask;      \
+                                                                                                      \
+    VEC hp_sum[IL_MAX_LEADS], prev_hp[IL_MAX_LEADS], mwi_sum[IL_MAX_LEADS], max_mwi[IL_MAX_LEADS];   \
+    for (int g = 0; g < groups; g++)                                                                  \
+        hp_sum[g] = prev_hp[g] = mwi_sum[g] = max_mwi[g] = V_SET1(0.0);                               \
+                                                                                                      \
+    for (size_t i = 0; i < job->n; i++) {                                                             \
+        const double *row = job->x + i * L;                                                           \
+        const double *band_row = job->band ? job->band + i * L : NULL;                                \
+        double *sq_row = job->sq_ring + (i & mask) * L;                                               \
+        const double *sq_old = job->sq_ring + ((i - mwi_win) & mask) * L;                              \
+        const VEC hp_w = V_SET1((double)((i < lp_win) ? i + 1 : lp_win));                             \
+        const VEC mwi_w = V_SET1((double)((i < mwi_win) ? i + 1 : mwi_win));                          \
+                                                                                                      \
+        for (int g = 0; g < groups; g++) {                                                            \
+            const size_t s = start[g];                                                                \
+            /* 1. Passe-haut, ou passe-bande déjà filtré pour toutes les dérivations */               \
+            VEC hp;                                                                                   \
+            if (band_row) {                                                                           \
+                hp = V_LOAD(band_row + s);                                                            \
+            } else {                                                                                  \
+                const VEC x = V_LOAD(row + s);                                                        \
+                hp_sum[g] = V_ADD(hp_sum[g], x);                                                      \
+                if (i >= lp_win) hp_sum[g] = V_SUB(hp_sum[g], V_LOAD(row - lp_win * L + s));          \
+                hp = V_SUB(x, V_DIV(hp_sum[g], hp_w));                                                \
+            }                                                                                         \
+                                                                                                      \
+            /* 2. Dérivée et 3. carré */                                                              \
+            const VEC d = (i == 0) ? V_SET1(0.0) : V_SUB(hp, prev_hp[g]);                             \
+            prev_hp[g] = hp;                                                                          \
+            const VEC sq = V_MUL(d, d);                                                               \
+            V_STORE(sq_row + s, sq);                                                                  \
+                                                                                                      \
+            /* 4. MWI */                                                                              \
+            mwi_sum[g] = V_ADD(mwi_sum[g], sq);                                                       \
+            if (i >= mwi_win) mwi_sum[g] = V_SUB(mwi_sum[g], V_LOAD(sq_old + s));                     \
+            const VEC m = V_DIV(mwi_sum[g], mwi_w);                                                   \
+            V_STORE(job->mwi + i * L + s, m);                                                         \
+            max_mwi[g] = V_MAX(m, max_mwi[g]);                                                        \
+        }                                                                                             \
+    }                                                                                                 \
+                                                                                                      \
+    for (int g = 0; g < groups; g++) {                                                                \
+        double lanes[W];                                                                              \
+        V_STORE(lanes, max_mwi[g]);                                                                   \
+        for (size_t k = 0; k < (W); k++) job->max_mwi[start[g] + k] = lanes[k];                       \
+    }                                                                                                 \
+}                                                                                                     \
+                                                                                                      \
+ATTR static void detect_##suffix(const IL_Job *job, ECG_Peaks peaks[]) {                               \
+    size_t start[IL_MAX_LEADS];                                                                       \
+    unsigned owned[IL_MAX_LEADS];                                                                     \
+    const int groups = lane_groups(job->leads, (W), start, owned);                                    \
+    const size_t L = job->leads;                                                                      \
+                                                                                                      \
+    /* detector_init de ecg_processing.c, voie par voie */                                            \
+    VEC signal_peak[IL_MAX_LEADS], noise_peak[IL_MAX_LEADS], threshold[IL_MAX_LEADS], last_r[IL_MAX_LEADS]; \
+    for (int g = 0; g < groups; g++) {                                                                \
+        double sp[W], np[W], th[W];                                                                   \
+        for (size_t k = 0; k < (W); k++) {                                                            \
+            const double max = job->max_mwi[start[g] + k];                                            \
+            sp[k] = THRESHOLD_INITIAL_FACTOR * max;                                                   \
+            np[k] = THRESHOLD_INITIAL_FACTOR * max * 0.5;                                             \
+            th[k] = np[k] + 0.25 * (sp[k] - np[k]);                                                   \
+        }                                                                                             \
+        signal_peak[g] = V_LOAD(sp);                                                                  \
+        noise_peak[g] = V_LOAD(np);                                                                   \
+        threshold[g] = V_LOAD(th);                                                                    \
+        last_r[g] = V_SET1((double)-job->refractory);                                                 \
+    }                                                                                                 \
+                                                                                                      \
+    const VEC refractory = V_SET1((double)job->refractory);                                           \
+    const VEC keep_signal = V_SET1(1.0 - SIGNAL_PEAK_DECAY_FACTOR), new_signal = V_SET1(SIGNAL_PEAK_DECAY_FACTOR); \
+    const VEC keep_noise = V_SET1(1.0 - NOISE_PEAK_DECAY_FACTOR), new_noise = V_SET1(NOISE_PEAK_DECAY_FACTOR); \
+    const VEC quarter = V_SET1(0.25);                                                                 \
+                                                                                                      \
+    for (size_t i = 1; i + 1 < job->n; i++) {                                                         \
+        const double *row = job->mwi + i * L;                                                         \
+        const VEC t = V_SET1((double)i);                                                              \
+        for (int g = 0; g < groups; g++) {                                                            \
+            const size_t s = start[g];                                                                \
+            const VEC cur = V_LOAD(row + s);                                                          \
+            /* Pic local : mwi[i] > mwi[i-1] et mwi[i] >= mwi[i+1] */                                 \
+            const MASK cand = M_AND(V_GT(cur, V_LOAD(row - L + s)), V_GE(cur, V_LOAD(row + L + s)));  \
+            if (!M_BITS(cand)) continue;                                                              \
+                                                                                                      \
+            /* Période réfractaire ou sous le seuil : bruit ; sinon nouveau pic R */                  \
+            const MASK rejected = M_OR(V_LT(V_SUB(t, last_r[g]), refractory), V_LT(cur, threshold[g])); \
+            const MASK noisy = M_AND(cand, rejected);                                                 \
+            const MASK accepted = M_ANDNOT(cand, rejected);                                           \
+            noise_peak[g] = V_BLEND(noisy, noise_peak[g],                                             \
+                                    V_ADD(V_MUL(keep_noise, noise_peak[g]), V_MUL(new_noise, cur)));  \
+            signal_peak[g] = V_BLEND(accepted, signal_peak[g],                                        \
+                                     V_ADD(V_MUL(keep_signal, signal_peak[g]), V_MUL(new_signal, cur))); \
+            threshold[g] = V_BLEND(cand, threshold[g],                                                \
+                                   V_ADD(noise_peak[g], V_MUL(quarter, V_SUB(signal_peak[g], noise_peak[g])))); \
+            last_r[g] = V_BLEND(accepted, last_r[g], t);                                              \
+                                                                                                      \
+            for (unsigned bits = M_BITS(accepted) & owned[g]; bits; bits &= bits - 1) {               \
+                const size_t lead = s + (size_t)__builtin_ctz(bits);                                   \
+                ECG_Peaks *p = &peaks[lead];                                                          \
+                if (p->R_count < p->capacity) p->R[p->R_count++] = refine_strided(job, lead, (int)i); \
+            }                                                                                         \
+        }                                                                                             \
+    }                                                                                                 \
+}
+
+/* ================================
+ * Scalaire (une dérivation par "vecteur")
+ * ================================ */
+
+#define VEC                 double
+#define MASK                int
+#define V_SET1(v)           (v)
+#define V_LOAD(p)           (*(p))
+#define V_STORE(p, v)       (*(p) = (v))
+#define V_ADD(a, b)         ((a) + (b))
+#define V_SUB(a, b)         ((a) - (b))
+#define V_MUL(a, b)         ((a) * (b))
+#define V_DIV(a, b)         ((a) / (b))
+#define V_MAX(a, b)         (((a) > (b)) ? (a) : (b))
+#define V_GT(a, b)          ((a) > (b))
+#define V_GE(a, b)          ((a) >= (b))
+#define V_LT(a, b)          ((a) < (b))
+#define M_AND(a, b)         ((a) & (b))
+#define M_OR(a, b)          ((a) | (b))
+#define M_ANDNOT(a, b)      ((a) & !(b))
+#define V_BLEND(m, a, b)    ((m) ? (b) : (a))
+#define M_BITS(m)           ((unsigned)(m))
+
+DEFINE_INTERLEAVED_ENGINE(scalar, , 1)
+
+#undef VEC
+#undef MASK
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_DIV
+#undef V_MAX
+#undef V_GT
+#undef V_GE
+#undef V_LT
+#undef M_AND
+#undef M_OR
+#undef M_ANDNOT
+#undef V_BLEND
+#undef M_BITS
+
+#ifdef ECG_HAVE_X86_KERNELS
+
+/* ================================
+ * AVX2 (4 dérivations par vecteur)
+ * ================================ */
+
+#define VEC                 __m256d
+#define MASK                __m256d
+#define V_SET1(v)           _mm256_set1_pd(v)
+#define V_LOAD(p)           _mm256_loadu_pd(p)
+#define V_STORE(p, v)       _mm256_storeu_pd((p), (v))
+#define V_ADD(a, b)         _mm256_add_pd((a), (b))
+#define V_SUB(a, b)         _mm256_sub_pd((a), (b))
+#define V_MUL(a, b)         _mm256_mul_pd((a), (b))
+#define V_DIV(a, b)         _mm256_div_pd((a), (b))
+#define V_MAX(a, b)         _mm256_max_pd((a), (b))
+#define V_GT(a, b)          _mm256_cmp_pd((a), (b), _CMP_GT_OQ)
+#define V_GE(a, b)          _mm256_cmp_pd((a), (b), _CMP_GE_OQ)
+#define V_LT(a, b)          _mm256_cmp_pd((a), (b), _CMP_LT_OQ)
+#define M_AND(a, b)         _mm256_and_pd((a), (b))
+#define M_OR(a, b)          _mm256_or_pd((a), (b))
+#define M_ANDNOT(a, b)      _mm256_andnot_pd((b), (a))
+#define V_BLEND(m, a, b)    _mm256_blendv_pd((a), (b), (m))
+#define M_BITS(m)           ((unsigned)_mm256_movemask_pd(m))
+
+DEFINE_INTERLEAVED_ENGINE(avx2, __attribute__((target("avx2"))), 4)
+
+#undef VEC
+#undef MASK
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_DIV
+#undef V_MAX
+#undef V_GT
+#undef V_GE
+#undef V_LT
+#undef M_AND
+#undef M_OR
+#undef M_ANDNOT
+#undef V_BLEND
+#undef M_BITS
+
+/* ================================
+ * AVX-512 (8 dérivations par vecteur)
+ * ================================ */
+
+#define VEC                 __m512d
+#define MASK                __mmask8
+#define V_SET1(v)           _mm512_set1_pd(v)
+#define V_LOAD(p)           _mm512_loadu_pd(p)
+#define V_STORE(p, v)       _mm512_storeu_pd((p), (v))
+#define V_ADD(a, b)         _mm512_add_pd((a), (b))
+#define V_SUB(a, b)         _mm512_sub_pd((a), (b))
+#define V_MUL(a, b)         _mm512_mul_pd((a), (b))
+#define V_DIV(a, b)         _mm512_div_pd((a), (b))
+#define V_MAX(a, b)         _mm512_max_pd((a), (b))
+#define V_GT(a, b)          _mm512_cmp_pd_mask((a), (b), _CMP_GT_OQ)
+#define V_GE(a, b)          _mm512_cmp_pd_mask((a), (b), _CMP_GE_OQ)
+#define V_LT(a, b)          _mm512_cmp_pd_mask((a), (b), _CMP_LT_OQ)
+#define M_AND(a, b)         ((__mmask8)((a) & (b)))
+#define M_OR(a, b)          ((__mmask8)((a) | (b)))
+#define M_ANDNOT(a, b)      ((__mmask8)((a) & ~(b)))
+#define V_BLEND(m, a, b)    _mm512_mask_blend_pd((m), (a), (b))
+#define M_BITS(m)           ((unsigned)(m))
+
+DEFINE_INTERLEAVED_ENGINE(avx512, __attribute__((target("avx512f"))), 8)
+
+#undef VEC
+#undef MASK
+#undef V_SET1
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_DIV
+#undef V_MAX
+#undef V_GT
+#undef V_GE
+#undef V_LT
+#undef M_AND
+#undef M_OR
+#undef M_ANDNOT
+#undef V_BLEND
+#undef M_BITS
+
+#endif /* ECG_HAVE_X86_KERNELS */
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+ECG_Status ecg_interleave_leads(const double *const signals[], size_t n_samples, int n_leads, double *interleaved) {
+    if (!signals || !interleaved) return ECG_ERR_NULL;
+    if (n_leads <= 0) return ECG_ERR_PARAM;
+    for (int l = 0; l < n_leads; l++)
+        if (!signals[l]) return ECG_ERR_NULL;
+
+    // Transposition par blocs : chaque dérivation est lue par tranches contiguës, les lignes écrites restent en cache
+    const size_t block = 256;
+    for (size_t t0 = 0; t0 < n_samples; t0 += block) {
+        const size_t t1 = (n_samples - t0 < block) ? n_samples : t0 + block;
+        for (int l = 0; l < n_leads; l++) {
+            const double *src = signals[l];
+            for (size_t t = t0; t < t1; t++) interleaved[t * (size_t)n_leads + (size_t)l] = src[t];
+        }
+    }
+    return ECG_OK;
+}
+
+ECG_Status ecg_analyze_interleaved(const ECG_Params *params,
+                                   const double *interleaved,
+                                   size_t n_samples,
+                                   int n_leads,
+                                   ECG_Peaks peaks[],
+                                   ECG_Intervals intervals[],
+                                   ECG_Peaks *consensus) {
+    if (!params || !interleaved || !peaks) return ECG_ERR_NULL;
+    if (n_samples == 0 || n_leads <= 0 || n_leads > params->leads || n_leads > IL_MAX_LEADS) return ECG_ERR_PARAM;
+    if (params->sampling_rate_hz <= 0 || params->precision != ECG_PRECISION_F64) return ECG_ERR_PARAM;
+    if (params->decimation > 1) return ECG_ERR_PARAM;
+    const ECG_Kernels *kernels = ecg_kernels_get(params->isa);
+    if (!kernels) return ECG_ERR_PARAM;
+
+    // Fenêtres de ecg_create
+    const int fs = params->sampling_rate_hz;
+    IL_Job job;
+    memset(&job, 0, sizeof(job));
+    job.x = interleaved;
+    job.n = n_samples;
+    job.leads = (size_t)n_leads;
+    job.lp_win = (size_t)MS_TO_SAMPLES(LOW_PASS_WINDOW_MS, fs);
+    job.mwi_win = (size_t)MS_TO_SAMPLES(MWI_WINDOW_MS, fs);
+    if (job.lp_win == 0) job.lp_win = 1;
+    if (job.mwi_win == 0) job.mwi_win = 1;
+    job.refractory = REFRACTORY_SAMPLES(fs);
+    size_t ring = 1;
+    while (ring < job.mwi_win + 1) ring <<= 1;
+    job.mask = ring - 1;
+
+    if (n_samples > SIZE_MAX / sizeof(double) / job.leads) return ECG_ERR_PARAM;
+    void *mwi = NULL, *sq_ring = NULL;
+    if (posix_memalign(&mwi, IL_ALIGN, sizeof(double) * n_samples * job.leads) != 0) mwi = NULL;
+    if (posix_memalign(&sq_ring, IL_ALIGN, sizeof(double) * ring * job.leads) != 0) sq_ring = NULL;
+    ECG_Status status = (mwi && sq_ring) ? ECG_OK : ECG_ERR_ALLOC;
+    job.mwi = mwi;
+    job.sq_ring = sq_ring;
+
+    // Passe-bande : récurrence IIR séquentielle dans le temps, vectorisée sur les dérivations de chaque ligne.
+    // Mêmes sections et même démarrage en régime établi que ecg_analyze : pics identiques par dérivation
+    void *band = NULL;
+    if (status == ECG_OK && params->filter != ECG_FILTER_MA) {
+        ECG_Biquad sections[ECG_BIQUAD_MAX_SECTIONS];
+        ECG_Biquad_State state[ECG_BIQUAD_MAX_SECTIONS * IL_MAX_LEADS];
+        const int n_sections = pipeline_band_sections(params, sections);
+        if (n_sections <= 0 || params->filter > ECG_FILTER_BANDPASS_ZERO_PHASE) status = ECG_ERR_PARAM;
+        else if (posix_memalign(&band, IL_ALIGN, sizeof(double) * n_samples * job.leads) != 0) status = ECG_ERR_ALLOC;
+
+        if (status == ECG_OK && params->filter == ECG_FILTER_BANDPASS_ZERO_PHASE) {
+            ecg_biquad_zero_phase_leads(sections, n_sections, state, interleaved, band, n_samples, job.leads);
+        } else if (status == ECG_OK) {
+            for (size_t l = 0; l < job.leads; l++) {
+                ECG_Biquad_State lead_state[ECG_BIQUAD_MAX_SECTIONS];
+                ecg_biquad_steady_state(sections, n_sections, interleaved[l], lead_state);
+                for (int k = 0; k < n_sections; k++) state[(size_t)k * job.leads + l] = lead_state[k];
+            }
+            ecg_biquad_cascade_leads(sections, n_sections, state, interleaved, band, n_samples, job.leads);
+        }
+        job.band = band;
+    }
+
+    // Au plus un pic par période réfractaire, comme ecg_analyze
+    const int max_peaks = (int)(n_samples / (size_t)(job.refractory > 0 ? job.refractory : 1)) + 2;
+    for (int l = 0; l < n_leads && status == ECG_OK; l++) {
+        peaks[l].R_count = peaks[l].P_count = peaks[l].Q_count = peaks[l].S_count = peaks[l].T_count = 0;
+        if (ecg_peaks_reserve(&peaks[l], max_peaks)) status = ECG_ERR_ALLOC;
+    }
+
+    if (status == ECG_OK) {
+        // Vecteur le plus large qui tient dans le nombre de dérivations
+#ifdef ECG_HAVE_X86_KERNELS
+        if (kernels->isa == ECG_ISA_AVX512 && n_leads >= 8) {
+            front_end_avx512(&job);
+            detect_avx512(&job, peaks);
+        } else if ((kernels->isa == ECG_ISA_AVX512 || kernels->isa == ECG_ISA_AVX2) && n_leads >= 4) {
+            front_end_avx2(&job);
+            detect_avx2(&job, peaks);
+        } else
+#endif
+        {
+            front_end_scalar(&job);
+            detect_scalar(&job, peaks);
+        }
+    }
+    free(mwi);
+    free(sq_ring);
+    free(band);
+
+    for (int l = 0; l < n_leads && status == ECG_OK && intervals; l++)
+        status = ecg_compute_intervals(&peaks[l], fs, &intervals[l]);
+    if (status == ECG_OK && consensus) status = ecg_fuse_leads(peaks, n_leads, fs, consensus);
+    return status;
+}
@@ -0,0 +1,20 @@
+/**
+ * @file    ecg_kernels.h
+ * @brief   Déclarations internes des tables de noyaux SIMD (une par jeu d'instructions).
+ * @details Chaque table est compilée uniquement sur l'architecture correspondante ; la sélection
+ *          à l'exécution se fait dans ecg_kernels_get() (ecg_utils.c).
+ *
+ */
+
+#ifndef ECG_KERNELS_H
+#define ECG_KERNELS_H
+
+#include "ecg_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ECG_HAVE_X86_KERNELS 1
+extern const ECG_Kernels ecg_kernels_avx2;
+extern const ECG_Kernels ecg_kernels_avx512;
+#endif
+
+#endif /* ECG_KERNELS_H */
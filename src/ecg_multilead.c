@@ -0,0 +1,153 @@
+/**
+ * @file    ecg_multilead.c
+ * @brief   Analyse parallèle de toutes les dérivations et fusion des pics R entre dérivations.
+ *
+ * Les dérivations sont indépendantes : chaque worker OpenMP possède son propre ECG_Context
+ * (aucun partage de buffers, pas de faux partage) et traite une dérivation à la fois.
+ * Sans OpenMP, les pragmas sont ignorés et l'analyse reste séquentielle.
+ */
+#include "ecg_processing.h"
+
+#include <stdlib.h>
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+/*
+ * Tolérance de fusion des pics R entre dérivations.
+ * Le pic R n'est pas parfaitement simultané sur toutes les dérivations (axe électrique, affinage
+ * sur le signal brut) : 50 ms couvre ce décalage tout en restant bien sous la période réfractaire.
+ */
+#define CONSENSUS_TOLERANCE_MS 50
+
+/* ===============================================================================
+ * Fusion inter dérivations
+ * =============================================================================== */
+
+typedef struct {
+    int index;  // indice du pic R
+    int lead;   // dérivation d'origine
+} Lead_Peak;
+
+static int cmp_lead_peak(const void *a, const void *b) {
+    const Lead_Peak *pa = a, *pb = b;
+    if (pa->index != pb->index) return (pa->index < pb->index) ? -1 : 1;
+    return (pa->lead < pb->lead) ? -1 : (pa->lead > pb->lead);
+}
+
+/**
+ * Vote à la majorité : un battement est retenu si au moins quorum dérivations distinctes ont un pic R
+ * dans une fenêtre de tolerance échantillons. La position retenue est la médiane du groupe.
+ * Parcours trié, O(P log P) pour P pics au total, résultat déterministe.
+ */
+static ECG_Status fuse_peaks(const ECG_Peaks peaks[], int n_leads, int tolerance, ECG_Peaks *consensus) {
+    int total = 0;
+    for (int l = 0; l < n_leads; l++) total += peaks[l].R_count;
+
+    consensus->R_count = 0;
+    if (total == 0) return ECG_OK;
+
+    Lead_Peak *all = malloc(sizeof(Lead_Peak) * (size_t)total);
+    if (!all) return ECG_ERR_ALLOC;
+
+    int k = 0;
+    for (int l = 0; l < n_leads; l++) {
+        for (int i = 0; i < peaks[l].R_count; i++) {
+            all[k].index = peaks[l].R[i];
+            all[k].lead = l;
+            k++;
+        }
+    }
+    qsort(all, (size_t)total, sizeof(Lead_Peak), cmp_lead_peak);
+
+    if (ecg_peaks_reserve(consensus, total / (n_leads / 2 + 1) + 1)) {
+        free(all);
+        return ECG_ERR_ALLOC;
+    }
+
+    const int quorum = n_leads / 2 + 1;
+    int start = 0;
+    while (start < total) {
+        // Groupe [start, end) : tous les pics à moins de tolerance du premier
+        int end = start;
+        unsigned int voters = 0;
+        while (end < total && all[end].index - all[start].index <= tolerance) {
+            voters |= 1u << all[end].lead;
+            end++;
+        }
+
+        int votes = 0;
+        for (unsigned int v = voters; v; v &= v - 1) votes++;
+
+        if (votes >= quorum) {
+            if (ecg_peaks_reserve(consensus, consensus->R_count + 1)) {
+                free(all);
+                return ECG_ERR_ALLOC;
+            }
+            consensus->R[consensus->R_count++] = all[start + (end - start - 1) / 2].index;
+            start = end;
+        } else {
+            // Le premier pic n'appartient à aucun battement majoritaire
+            start++;
+        }
+    }
+
+    free(all);
+    return ECG_OK;
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+ECG_Status ecg_analyze_all_leads(const ECG_Params *params,
+                                 const double *const signals[],
+                                 size_t n_samples,
+                                 int n_leads,
+                                 ECG_Peaks peaks[],
+                                 ECG_Intervals intervals[],
+                                 ECG_Peaks *consensus) {
+    if (!params || !signals || !peaks) return ECG_ERR_NULL;
+    if (n_samples == 0 || n_leads <= 0 || n_leads > params->leads) return ECG_ERR_PARAM;
+    // Le vote utilise un masque de bits par dérivation
+    if (n_leads > (int)(sizeof(unsigned int) * 8)) return ECG_ERR_PARAM;
+    for (int l = 0; l < n_leads; l++)
+        if (!signals[l]) return ECG_ERR_NULL;
+
+    ECG_Status *status = malloc(sizeof(ECG_Status) * (size_t)n_leads);
+    if (!status) return ECG_ERR_ALLOC;
+    for (int l = 0; l < n_leads; l++) status[l] = ECG_ERR_FAIL;
+
+    // Un contexte par worker, réutilisé pour toutes les dérivations qu'il traite
+    #pragma omp parallel
+    {
+        ECG_Context *ctx = ecg_create(params);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int l = 0; l < n_leads; l++) {
+            status[l] = ctx ? ecg_analyze(ctx, signals[l], n_samples, l, &peaks[l], intervals ? &intervals[l] : NULL)
+                            : ECG_ERR_ALLOC;
+        }
+
+        ecg_destroy(ctx);
+    }
+
+    ECG_Status result = ECG_OK;
+    for (int l = 0; l < n_leads && result == ECG_OK; l++) result = status[l];
+    free(status);
+    if (result != ECG_OK) return result;
+
+    if (consensus) {
+        const int tolerance = (CONSENSUS_TOLERANCE_MS * params->sampling_rate_hz) / 1000;
+        result = fuse_peaks(peaks, n_leads, tolerance, consensus);
+    }
+
+    return result;
+}
+
+ECG_Status ecg_fuse_leads(const ECG_Peaks peaks[], int n_leads, int sampling_rate_hz, ECG_Peaks *consensus) {
+    if (!peaks || !consensus) return ECG_ERR_NULL;
+    if (n_leads <= 0 || n_leads > (int)(sizeof(unsigned int) * 8) || sampling_rate_hz <= 0) return ECG_ERR_PARAM;
+    return fuse_peaks(peaks, n_leads, (CONSENSUS_TOLERANCE_MS * sampling_rate_hz) / 1000, consensus);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file    ecg_pipeline.h
+ * @brief   Constantes internes du pipeline Pan-Tompkins (fenêtres des filtres, détecteur à seuil adaptatif).
+ * @details Partagées par l'analyse par dérivation (ecg_processing.c) et le moteur entrelacé
+ *          (ecg_interleaved.c) : les deux chemins doivent rester identiques bit à bit.
+ *
+ */
+
+#ifndef ECG_PIPELINE_H
+#define ECG_PIPELINE_H
+
+#include "ecg_processing.h"
+
+/*
+ * Période réfractaire minimale entre deux pics R.
+ * Le coeur ne peut pas battre à plus de 220 bpm, soit environ 270 ms entre deux battements.
+ * J'utilise donc 270 ms comme garde-fou pour éviter de détecter des pics R trop proches les uns des autres.
+ */
+#define REFRACTORY_PERIOD_MS 270
+// Nombre d'échantillons qui correspond à la priode réfractaire
+#define REFRACTORY_SAMPLES(heart_rate_hz) ((REFRACTORY_PERIOD_MS * (heart_rate_hz)) / 1000)
+
+/*
+ * Fenêtre du filtre passe-bas pour atténuer les hautes fréquences (bruit).
+ * https://en.wikipedia.org/wiki/QRS_complex#:~:text=In%20adults,%20the%20QRS%20complex,wave%20follows%20the%20T%20wave.
+ * La largeur du complexe QRS est généralement inférieure entre 70 et 110ms.
+ * J'utilise donc 130 ms pour avoir tout le QRS et éviter de trop lisser les données.
+ */
+#define LOW_PASS_WINDOW_MS 130
+
+/*
+ * Seuil initial pour la détection des pics R.
+ * Initilisation du seuil à 0.25 fois à l'amplitude max du signal (25% du max).
+ */
+#define THRESHOLD_INITIAL_FACTOR 0.25
+
+/*
+ * Mise à jour du seul adaptif après chaque pic R détecté.
+ * J'utilise un facteur d'oubli expponentiel :
+ * https://en.wikipedia.org/wiki/Moving_average
+ * Valeurs définies par Pan-Tompkins :
+ * signal_peak = 0.875 * signal_peak + 0.125 * new_peak
+ * noise_peak = 0.875 * noise_peak + 0.125 * rejected_peak
+ * Avantage : O(1) pour la màj du seuil, pas besoin de stocker les pics précédents.
+ *
+ */
+#define SIGNAL_PEAK_DECAY_FACTOR 0.125
+#define NOISE_PEAK_DECAY_FACTOR 0.125
+
+/*
+ * Fenêtre d'intégration en ms pour la MWI (Moving Window Integration).
+ * Correspond à la durée typique du complexe QRS, soit environ 130 ms.
+ * Pan-Thomkins précconise ~150ms.
+ */
+#define MWI_WINDOW_MS 130
+
+// Nombre d'échantillons d'une durée en ms (arrondi inférieur, comme les fenêtres calculées dans ecg_create)
+#define MS_TO_SAMPLES(ms, fs) (((long)(ms) * (fs)) / 1000)
+
+/*
+ * Passe-bande de l'étape 1 (ECG_FILTER_BANDPASS*) : 5-15 Hz, bande d'énergie du QRS retenue par Pan-Tompkins.
+ * Sous 5 Hz : dérive de la ligne de base, ondes P et T ; au-dessus de 15 Hz : bruit musculaire, secteur.
+ * Ordre 2 (deux biquads) : pente de 40 dB/décade de chaque côté, retard de groupe modéré pour le causal.
+ */
+#define BAND_LOW_HZ 5.0
+#define BAND_HIGH_HZ 15.0
+#define BAND_ORDER 2
+
+// Sections du passe-bande des paramètres (0 = valeur par défaut), -1 si la bande est invalide pour fs
+static inline int pipeline_band_sections(const ECG_Params *params, ECG_Biquad *sections) {
+    const double low = (params->band_low_hz > 0.0) ? params->band_low_hz : BAND_LOW_HZ;
+    const double high = (params->band_high_hz > 0.0) ? params->band_high_hz : BAND_HIGH_HZ;
+    const int order = (params->band_order > 0) ? params->band_order : BAND_ORDER;
+    return ecg_butterworth_bandpass((double)params->sampling_rate_hz, low, high, order, sections);
+}
+
+#endif /* ECG_PIPELINE_H */
@@ -0,0 +1,106 @@
+/**
+ * @file    ecg_pool.c
+ * @brief   Pool de contextes d'analyse partagé entre threads (ecg_pool_acquire / ecg_pool_release).
+ *
+ * Les contextes libres sont gardés dans une pile protégée par un verrou tournant (__atomic) :
+ * la section critique se limite à un empilement ou un dépilement, ecg_create() / ecg_reset() /
+ * ecg_destroy() sont appelés hors du verrou.
+ */
+#include "ecg_processing.h"
+
+#include <stdlib.h>
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+// Taille d'une ligne de cache
+#define POOL_ALIGN 64
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+struct ECG_Pool {
+    // Verrou seul sur sa ligne de cache (pool aligné sur 64 octets) : les threads qui le font tourner
+    // n'invalident pas le reste
+    unsigned char lock;
+    unsigned char pad[POOL_ALIGN - 1];
+    ECG_Params params;
+    int max_idle;
+    int idle_count;
+    ECG_Context **idle;         // pile des contextes libres (max_idle entrées)
+};
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+static void pool_lock(ECG_Pool *pool) {
+    while (__atomic_test_and_set(&pool->lock, __ATOMIC_ACQUIRE)) {
+        // Attente en lecture seule : la ligne reste partagée tant que le verrou est pris
+        while (__atomic_load_n(&pool->lock, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static void pool_unlock(ECG_Pool *pool) {
+    __atomic_clear(&pool->lock, __ATOMIC_RELEASE);
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+ECG_Pool *ecg_pool_create(const ECG_Params *params, int max_idle) {
+    if (!params || max_idle <= 0) return NULL;
+
+    void *mem = NULL;
+    if (posix_memalign(&mem, POOL_ALIGN, sizeof(ECG_Pool)) != 0) return NULL;
+    ECG_Pool *pool = mem;
+    pool->idle = malloc(sizeof(ECG_Context *) * (size_t)max_idle);
+    if (!pool->idle) {
+        free(pool);
+        return NULL;
+    }
+
+    __atomic_clear(&pool->lock, __ATOMIC_RELAXED);
+    pool->params = *params;
+    pool->max_idle = max_idle;
+    pool->idle_count = 0;
+    return pool;
+}
+
+ECG_Context *ecg_pool_acquire(ECG_Pool *pool) {
+    if (!pool) return NULL;
+
+    ECG_Context *ctx = NULL;
+    pool_lock(pool);
+    if (pool->idle_count > 0) ctx = pool->idle[--pool->idle_count];
+    pool_unlock(pool);
+
+    // Pile vide : nouveau contexte, créé hors du verrou
+    return ctx ? ctx : ecg_create(&pool->params);
+}
+
+void ecg_pool_release(ECG_Pool *pool, ECG_Context *ctx) {
+    if (!pool || !ctx) return;
+    ecg_reset(ctx);
+
+    int kept = 0;
+    pool_lock(pool);
+    if (pool->idle_count < pool->max_idle) {
+        pool->idle[pool->idle_count++] = ctx;
+        kept = 1;
+    }
+    pool_unlock(pool);
+
+    if (!kept) ecg_destroy(ctx);
+}
+
+void ecg_pool_destroy(ECG_Pool *pool) {
+    if (!pool) return;
+    for (int i = 0; i < pool->idle_count; i++) ecg_destroy(pool->idle[i]);
+    free(pool->idle);
+    free(pool);
+}
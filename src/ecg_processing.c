@@ -12,67 +12,127 @@
  * 5. Période réfractaire pour éviter les faux positifs.
  */
 #include "ecg_processing.h"
-
-#include <stdio.h>
+#include "ecg_delineation.h"
+#include "ecg_pipeline.h"
 
 #include "ecg_utils.h"
 
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef ECG_ENABLE_STATS
+#include <time.h>
+#endif
 
 /* ===============================================================================
  * Constantes
  * =============================================================================== */
 
+// Fenêtres, seuil initial et facteurs d'oubli du détecteur : ecg_pipeline.h (partagés avec ecg_interleaved.c)
+
 /*
- * Période réfractaire minimale entre deux pics R.
- * Le coeur ne peut pas battre à plus de 220 bpm, soit environ 270 ms entre deux battements.
- * J'utilise donc 270 ms comme garde-fou pour éviter de détecter des pics R trop proches les uns des autres.
+ * Phase d'apprentissage du mode streaming (Pan-Tompkins : ~2 s).
+ * En streaming on ne connaît pas le max global de la MWI : on l'estime sur les 2 premières secondes
+ * avant de lancer la détection, puis le seuil adaptatif prend le relais.
  */
-#define REFRACTORY_PERIOD_MS 270
-// Nombre d'échantillons qui correspond à la priode réfractaire
-#define REFRACTORY_SAMPLES(heart_rate_hz) ((REFRACTORY_PERIOD_MS * (heart_rate_hz)) / 1000)
+#define LEARNING_PERIOD_MS 2000
 
-/*
- * Fenêtre du filtre passe-bas pour atténuer les hautes fréquences (bruit).
- * https://en.wikipedia.org/wiki/QRS_complex#:~:text=In%20adults,%20the%20QRS%20complex,wave%20follows%20the%20T%20wave.
- * La largeur du complexe QRS est généralement inférieure entre 70 et 110ms.
- * J'utilise donc 130 ms pour avoir tout le QRS et éviter de trop lisser les données.
+/**
+ * Bornes des intervalles RR retenus : en dehors, pic manqué ou faux positif.
  */
-#define LOW_PASS_WINDOW_MS 130
+#define RR_MIN_S 0.2
+#define RR_MAX_S 2.0
 
-/*
- * Seuil initial pour la détection des pics R.
- * Initilisation du seuil à 0.25 fois à l'amplitude max du signal (25% du max).
+/**
+ * Seuil de pNN50 : différence entre deux RR successifs strictement supérieure à 50 ms.
+ * Les RR sont des multiples de la période d'échantillonnage : une différence d'exactement 50 ms
+ * (25 échantillons à 500 Hz) ne doit pas compter selon l'arrondi, d'où la marge de 1 ns.
  */
-#define THRESHOLD_INITIAL_FACTOR 0.25
+#define NN50_THRESHOLD_S (0.05 + 1e-9)
 
 /*
- * Mise à jour du seul adaptif après chaque pic R détecté.
- * J'utilise un facteur d'oubli expponentiel :
- * https://en.wikipedia.org/wiki/Moving_average
- * Valeurs définies par Pan-Tompkins :
- * signal_peak = 0.875 * signal_peak + 0.125 * new_peak
- * noise_peak = 0.875 * noise_peak + 0.125 * rejected_peak
- * Avantage : O(1) pour la màj du seuil, pas besoin de stocker les pics précédents.
- *
+ * Fréquence minimale du signal décimé (ECG_Params.decimation).
+ * À 50 Hz, Nyquist (25 Hz) reste au-dessus de la bande du QRS (5-15 Hz) : détection inchangée.
  */
-#define SIGNAL_PEAK_DECAY_FACTOR 0.125
-#define NOISE_PEAK_DECAY_FACTOR 0.125
+#define DECIMATION_MIN_RATE_HZ 50
 
 /*
- * Fenêtre d'intégration en ms pour la MWI (Moving Window Integration).
- * Correspond à la durée typique du complexe QRS, soit environ 130 ms.
- * Pan-Thomkins précconise ~150ms.
+ * Recouvrement de tête des segments de l'analyse parallèle (ecg_analyze_parallel).
+ * Le détecteur d'un segment tourne sur ce recouvrement avant ses propres pics : signal_peak / noise_peak
+ * oublient 12.5 % à chaque candidat et rejoignent l'état du détecteur continu. Le passe-bande laisse peu de
+ * maxima de bruit (convergence plus lente) : 20 s laissent encore diverger quelques décisions sur signal
+ * bruité, avec 60 s les pics sont ceux de ecg_analyze jusqu'à 64 segments sur 1 h (MA et passe-bande).
  */
-#define MWI_WINDOW_MS 130
+#define PARALLEL_WARMUP_MS 60000
 
 /* ===============================================================================
  * Structures internes
  * =============================================================================== */
 
+/*
+ * État du détecteur à seuil adaptatif + période réfractaire.
+ * Partagé entre l'analyse globale et le streaming : mêmes calculs, donc mêmes résultats.
+ */
+typedef struct {
+    double signal_peak;         // moyenne exponentielle des vrais pics
+    double noise_peak;          // moyenne exponentielle des candidats rejetés
+    double threshold;           // noise_peak + 0.25 * (signal_peak - noise_peak)
+    ptrdiff_t last_r_index;     // indice (dans mwi) du dernier pic R accepté
+    int refractory_samples;     // période réfractaire en échantillons
+} ECG_Detector;
+
+// Issue d'un pas du détecteur : seul DETECT_ACCEPT produit un pic, les autres alimentent les compteurs
+typedef enum {
+    DETECT_NONE = 0,            // pas un maximum local de la MWI
+    DETECT_REFRACTORY,          // maximum local dans la période réfractaire
+    DETECT_NOISE,               // maximum local sous le seuil
+    DETECT_ACCEPT               // nouveau pic R
+} Detect_Result;
+
+/*
+ * État du mode streaming (ecg_push).
+ * Les anneaux sont de taille puissance de deux (indexation par masque) et alloués une seule fois
+ * dans ecg_create : la mémoire reste constante quelle que soit la durée du flux.
+ */
+typedef struct {
+    size_t ring_mask;           // taille des anneaux - 1
+    double *raw_ring;           // signal brut (fenêtre passe-haut + affinage du pic R)
+    double *sq_ring;            // signal carré (fenêtre MWI)
+    double *mwi_ring;           // signal intégré (détection + apprentissage)
+
+    size_t n_seen;              // nombre total d'échantillons reçus
+
+    // Sommes glissantes reprises d'un appel à l'autre
+    double hp_sum;
+    size_t hp_w;
+    double prev_hp;
+    double mwi_sum;
+    size_t mwi_w;
+    ECG_Biquad_State band_state[ECG_BIQUAD_MAX_SECTIONS]; // passe-bande causal (ECG_FILTER_BANDPASS)
+
+    // Détection
+    double learn_max;           // max de la MWI pendant la phase d'apprentissage (tenu au vol)
+    int learned;                // 1 quand la phase d'apprentissage est terminée
+    size_t cursor;              // prochain indice candidat à tester
+    ECG_Detector det;
+    ptrdiff_t pending_center;   // pic accepté en attente d'affinage (-1 si aucun)
+    ptrdiff_t last_emitted_r;   // dernier pic R émis (pour le RR), -1 si aucun
+} ECG_Stream;
+
+/* Noyau fusionné passe-haut -> dérivée -> carré -> MWI, retourne le max de la MWI. */
+typedef double (*Fused_Front_End)(ECG_Context *ctx, const double *signal, size_t n_samples, double *mwi);
+static Fused_Front_End fused_front_end_select(int fs);
+
 /*
  * Pré allocation des buffers pour éviter les alloc dynamiques pendant l'analyse.
- * Mémoire totale : 4 × MAX_SAMPLES × 8 bytes = 320 KB -> tient dans le cahce L2/L3.
+ * Contexte et buffers sont découpés dans une seule arène alignée (Arena_Layout, tailles fixées dans ecg_create) :
+ *  - chaîne multi-passes (ou passe-bande) : high_pass, derived, squared et mwi, 4 × capacity × 8 octets ;
+ *  - noyau fusionné : mwi seul (capacity × 8 octets) ; précision réduite : mwi_f32 (capacity × 4 octets) ;
+ *  - décimation : signal décimé (capacity / decimation × 8 octets), la chaîne tourne dans le contexte coarse ;
+ *  - toujours : anneaux du streaming et du noyau fusionné, plus la zone de délinéation si demandée.
  */
 struct ECG_Context {
     // Copie locale des paramètres pour éviter les accès à la mémoire globale
@@ -86,8 +146,172 @@ struct ECG_Context {
     double *squared_buffer;
     // Signal après fenêtre glissante (intégration)
     double *mwi_buffer;
+
+    // Noyaux de filtrage choisis une fois pour toutes (scalaire / AVX2 / AVX-512)
+    const ECG_Kernels *kernels;
+
+    // Nombre d'échantillons que peuvent contenir les buffers ci-dessus
+    size_t capacity;
+    // 1 si le dernier ecg_analyze a dépassé capacity (analyse par fenêtres, ecg_analysis_windowed)
+    int windowed;
+
+    // Fenêtres pré calculées à partir de la fréquence d'échantillonnage
+    size_t low_pass_window;
+    size_t mwi_window;
+    int refractory_samples;
+    size_t learning_samples;
+
+    // Passe-bande de l'étape 1 (ECG_Params.filter), 0 section = passe-haut x - MA(x)
+    ECG_Biquad band[ECG_BIQUAD_MAX_SECTIONS];
+    int band_sections;
+
+    // Anneau du signal carré pour le noyau fusionné (fenêtre MWI uniquement)
+    double *fused_ring;
+    size_t fused_mask;
+    // Noyau fusionné spécialisé pour la fréquence (fenêtres constantes à 360 / 500 Hz), choisi à ecg_create
+    Fused_Front_End fused_front_end;
+
+    // Précision réduite (float32 / int16) : MWI et anneau du noyau fusionné en float32
+    float *mwi_f32;
+    float *fused_ring_f32;
+
+    // Passe-haut d'un battement pour la délinéation quand high_pass_buffer n'existe pas (fusionné, réduit, fenêtres)
+    double *delineation_scratch;
+
+    // Détection décimée (ECG_Params.decimation) : contexte à fs / decimation et signal décimé, NULL sinon
+    ECG_Context *coarse;
+    double *coarse_signal;
+
+    // État du mode streaming
+    ECG_Stream stream;
+
+    // Variabilité cardiaque, mise à jour à chaque RR (ecg_get_hrv)
+    ECG_Hrv_State hrv;
+
+#ifdef ECG_ENABLE_STATS
+    // Instrumentation (historique des seuils en anneau, remis dans l'ordre par ecg_get_stats)
+    ECG_Stats stats;
+    int stats_history_head;
+#endif
 };
 
+/* ===============================================================================
+ * Instrumentation (ECG_ENABLE_STATS)
+ * =============================================================================== */
+
+/*
+ * Sans ECG_ENABLE_STATS, toutes les macros sont vides : aucun appel d'horloge ni compteur
+ * dans les boucles, le code généré est celui d'origine.
+ * Avec, une lecture de CLOCK_MONOTONIC par étape (pas par échantillon) et un test par candidat.
+ */
+#ifdef ECG_ENABLE_STATS
+
+static uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void stats_detect(ECG_Context *ctx, Detect_Result r, const ECG_Detector *d) {
+    if (r == DETECT_NONE) return;
+    ECG_Stats *s = &ctx->stats;
+
+    if (s->local_maxima++ == 0) s->threshold_min = s->threshold_max = d->threshold;
+    if (d->threshold < s->threshold_min) s->threshold_min = d->threshold;
+    if (d->threshold > s->threshold_max) s->threshold_max = d->threshold;
+    s->threshold_last = d->threshold;
+    s->signal_peak = d->signal_peak;
+    s->noise_peak = d->noise_peak;
+
+    if (r == DETECT_REFRACTORY) {
+        s->rejected_refractory++;
+    } else if (r == DETECT_NOISE) {
+        s->rejected_threshold++;
+    } else {
+        s->accepted++;
+        s->threshold_history[ctx->stats_history_head] = d->threshold;
+        ctx->stats_history_head = (ctx->stats_history_head + 1) % ECG_STATS_THRESHOLD_HISTORY;
+        if (s->threshold_history_count < ECG_STATS_THRESHOLD_HISTORY) s->threshold_history_count++;
+    }
+}
+
+#define STATS_CLOCK(t)              uint64_t t = stats_now()
+#define STATS_LAP(ctx, field, t)    do { const uint64_t now_ = stats_now(); (ctx)->stats.field += now_ - (t); (t) = now_; } while (0)
+#define STATS_CALL(ctx, n)          do { (ctx)->stats.calls++; (ctx)->stats.samples += (n); } while (0)
+#define STATS_DETECT(ctx, r, d)     stats_detect((ctx), (r), (d))
+
+#else
+
+#define STATS_CLOCK(t)
+#define STATS_LAP(ctx, field, t)    ((void)0)
+#define STATS_CALL(ctx, n)          ((void)0)
+#define STATS_DETECT(ctx, r, d)     ((void)0)
+
+#endif
+
+ECG_Status ecg_reset_stats(ECG_Context *ctx) {
+    if (!ctx) return ECG_ERR_NULL;
+#ifdef ECG_ENABLE_STATS
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    ctx->stats.enabled = 1;
+    ctx->stats_history_head = 0;
+#endif
+    return ECG_OK;
+}
+
+ECG_Status ecg_get_stats(const ECG_Context *ctx, ECG_Stats *stats) {
+    if (!ctx || !stats) return ECG_ERR_NULL;
+#ifdef ECG_ENABLE_STATS
+    *stats = ctx->stats;
+    // Anneau plein : le plus ancien seuil est à la tête d'écriture
+    const int count = ctx->stats.threshold_history_count;
+    const int first = (count < ECG_STATS_THRESHOLD_HISTORY) ? 0 : ctx->stats_history_head;
+    for (int k = 0; k < count; k++)
+        stats->threshold_history[k] = ctx->stats.threshold_history[(first + k) % ECG_STATS_THRESHOLD_HISTORY];
+    return ECG_OK;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return ECG_ERR_FAIL;
+#endif
+}
+
+/* ===============================================================================
+ * Arène du contexte
+ * =============================================================================== */
+
+/*
+ * Le contexte et tous ses buffers sont découpés dans une seule allocation alignée sur 64 octets :
+ * une ligne de cache par début de buffer (chargements vectoriels alignés), aucune ligne partagée avec
+ * le contexte d'un autre thread (pas de faux partage) et un seul malloc / free par contexte.
+ */
+#define ARENA_ALIGN 64
+
+static size_t arena_round(size_t bytes) {
+    return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Taille de chaque buffer (0 = absent), dans l'ordre du découpage
+typedef struct {
+    size_t high_pass, derived, squared, mwi, mwi_f32, fused_ring_f32;
+    size_t raw_ring, sq_ring, mwi_ring, fused_ring, delineation, coarse_signal;
+} Arena_Layout;
+
+static size_t arena_size(const Arena_Layout *l) {
+    return arena_round(sizeof(ECG_Context))
+         + arena_round(l->high_pass) + arena_round(l->derived) + arena_round(l->squared)
+         + arena_round(l->mwi) + arena_round(l->mwi_f32) + arena_round(l->fused_ring_f32)
+         + arena_round(l->raw_ring) + arena_round(l->sq_ring) + arena_round(l->mwi_ring)
+         + arena_round(l->fused_ring) + arena_round(l->delineation) + arena_round(l->coarse_signal);
+}
+
+// Buffer suivant de l'arène, NULL si sa taille est nulle
+static void *arena_take(char **cursor, size_t bytes) {
+    if (bytes == 0) return NULL;
+    void *p = *cursor;
+    *cursor += arena_round(bytes);
+    return p;
+}
+
 /**
  * @brief Crée et init un contexte d'analyse ECG.
  *
@@ -98,46 +322,149 @@ struct ECG_Context {
  * @return Pointeur vers le contexte en cas de succès, NULL sinon.
  */
 ECG_Context *ecg_create(const ECG_Params *params) {
-    if (!params) return NULL;
+    if (!params || params->sampling_rate_hz <= 0) return NULL;
+    if (params->precision < ECG_PRECISION_F64 || params->precision > ECG_PRECISION_I16) return NULL;
+    if (params->filter < ECG_FILTER_MA || params->filter > ECG_FILTER_BANDPASS_ZERO_PHASE) return NULL;
+
+    // Passe-bande conçu une fois ici : chaîne double uniquement (les chemins réduits fusionnent le passe-haut)
+    ECG_Biquad band[ECG_BIQUAD_MAX_SECTIONS];
+    int band_sections = 0;
+    if (params->filter != ECG_FILTER_MA) {
+        if (params->precision != ECG_PRECISION_F64) return NULL;
+        band_sections = pipeline_band_sections(params, band);
+        if (band_sections <= 0) return NULL;
+    }
+
+    // Dispatch à la création : aucun test de CPU pendant l'analyse
+    const ECG_Kernels *kernels = ecg_kernels_get(params->isa);
+    if (!kernels) return NULL;
 
-    ECG_Context *ctx = malloc(sizeof(ECG_Context));
-    if (!ctx) return NULL;
+    // Calcul des fenêtres une seule fois
+    const int fs = params->sampling_rate_hz;
+
+    // Détection décimée : fréquence entière et suffisante pour le QRS, chaîne double uniquement
+    if (params->decimation < 0) return NULL;
+    const int decimation = (params->decimation > 1) ? params->decimation : 0;
+    if (decimation && (params->precision != ECG_PRECISION_F64 || fs % decimation != 0
+                       || fs / decimation < DECIMATION_MIN_RATE_HZ)) return NULL;
+    const size_t low_pass_window = (size_t)MS_TO_SAMPLES(LOW_PASS_WINDOW_MS, fs);
+    const size_t mwi_window = (size_t)MS_TO_SAMPLES(MWI_WINDOW_MS, fs);
+    const int refractory_samples = REFRACTORY_SAMPLES(fs);
+    const size_t learning_samples = (size_t)MS_TO_SAMPLES(LEARNING_PERIOD_MS, fs);
+
+    // Taille des anneaux du streaming : apprentissage + fenêtre d'affinage + fenêtres des filtres,
+    // arrondie à la puissance de deux supérieure
+    size_t ring_needed = learning_samples + (size_t)refractory_samples + low_pass_window + mwi_window + 4;
+    size_t ring_size = 1;
+    while (ring_size < ring_needed) ring_size <<= 1;
+
+    size_t fused_size = 1;
+    while (fused_size < mwi_window + 1) fused_size <<= 1;
+
+    // Buffers dimensionnés par la capacité demandée.
+    // En mode fusionné, seuls mwi[] et de petites fenêtres sont nécessaires,
+    // en précision réduite seul un mwi[] float32 (4 octets par échantillon au lieu de 4 x 8)
+    const size_t capacity = params->max_samples ? params->max_samples : MAX_SAMPLES;
+    if (capacity > SIZE_MAX / (8 * sizeof(double))) return NULL;
+    const int reduced = params->precision != ECG_PRECISION_F64;
+    // Détection décimée : les buffers pleine résolution sont remplacés par le signal décimé,
+    // la chaîne tourne dans le contexte coarse (capacité ceil(capacity / decimation))
+    const size_t coarse_capacity = decimation ? (capacity + (size_t)decimation - 1) / (size_t)decimation : 0;
+    const int need_stages = (!params->fused || band_sections > 0) && !reduced && !decimation;
+
+    Arena_Layout l;
+    l.high_pass = need_stages ? sizeof(double) * capacity : 0;
+    l.derived = l.high_pass;
+    l.squared = l.high_pass;
+    l.mwi = (reduced || decimation) ? 0 : sizeof(double) * capacity;
+    l.mwi_f32 = reduced ? sizeof(float) * capacity : 0;
+    l.fused_ring_f32 = reduced ? sizeof(float) * fused_size : 0;
+    l.raw_ring = sizeof(double) * ring_size;
+    l.sq_ring = l.raw_ring;
+    l.mwi_ring = l.raw_ring;
+    l.fused_ring = sizeof(double) * fused_size;
+    l.delineation = params->delineate ? sizeof(double) * ecg_delineation_scratch_size(fs) : 0;
+    l.coarse_signal = sizeof(double) * coarse_capacity;
+
+    // Une seule allocation : soit tout réussit, soit rien n'est à libérer
+    void *arena = NULL;
+    if (posix_memalign(&arena, ARENA_ALIGN, arena_size(&l)) != 0) return NULL;
+
+    ECG_Context *ctx = arena;
+    memset(ctx, 0, sizeof(*ctx));
+    char *cursor = (char *)arena + arena_round(sizeof(ECG_Context));
 
     // Copie des paramètre pour éviter ptr externe qui pourrait être modifié.
     ctx->params = *params;
+    ctx->kernels = kernels;
+    ctx->capacity = capacity;
+    ctx->low_pass_window = low_pass_window;
+    ctx->mwi_window = mwi_window;
+    ctx->refractory_samples = refractory_samples;
+    ctx->learning_samples = learning_samples;
+    ctx->fused_front_end = fused_front_end_select(fs);
+    memcpy(ctx->band, band, sizeof(ECG_Biquad) * (size_t)band_sections);
+    ctx->band_sections = band_sections;
+    ctx->stream.ring_mask = ring_size - 1;
+    ctx->fused_mask = fused_size - 1;
 
-    // Alloc des buffers
-    ctx->high_pass_buffer = malloc(sizeof(double) * MAX_SAMPLES);
-    ctx->derived_buffer = malloc(sizeof(double) * MAX_SAMPLES);
-    ctx->squared_buffer = malloc(sizeof(double) * MAX_SAMPLES);
-    ctx->mwi_buffer = malloc(sizeof(double) * MAX_SAMPLES);
+    ctx->high_pass_buffer = arena_take(&cursor, l.high_pass);
+    ctx->derived_buffer = arena_take(&cursor, l.derived);
+    ctx->squared_buffer = arena_take(&cursor, l.squared);
+    ctx->mwi_buffer = arena_take(&cursor, l.mwi);
+    ctx->mwi_f32 = arena_take(&cursor, l.mwi_f32);
+    ctx->fused_ring_f32 = arena_take(&cursor, l.fused_ring_f32);
+    ctx->stream.raw_ring = arena_take(&cursor, l.raw_ring);
+    ctx->stream.sq_ring = arena_take(&cursor, l.sq_ring);
+    ctx->stream.mwi_ring = arena_take(&cursor, l.mwi_ring);
+    ctx->fused_ring = arena_take(&cursor, l.fused_ring);
+    ctx->delineation_scratch = arena_take(&cursor, l.delineation);
+    ctx->coarse_signal = arena_take(&cursor, l.coarse_signal);
 
-    // Suffit d'un échec de malloc pour tout annuler
-    if (!ctx->high_pass_buffer || !ctx->derived_buffer || !ctx->squared_buffer || !ctx->mwi_buffer) {
-        free(ctx->high_pass_buffer);
-        free(ctx->derived_buffer);
-        free(ctx->squared_buffer);
-        free(ctx->mwi_buffer);
-        free(ctx);
-        return NULL;
+    // Mêmes paramètres à fs / decimation (fenêtres, seuils et passe-bande recalculés pour cette fréquence),
+    // sans délinéation : elle est faite sur le signal pleine résolution
+    if (decimation) {
+        ECG_Params coarse = *params;
+        coarse.sampling_rate_hz = fs / decimation;
+        coarse.max_samples = coarse_capacity;
+        coarse.decimation = 0;
+        coarse.delineate = 0;
+        ctx->coarse = ecg_create(&coarse);
+        if (!ctx->coarse) {
+            free(arena);
+            return NULL;
+        }
     }
 
+    ecg_reset(ctx);
     return ctx;
 }
 
 /**
  * @brief Libère un contexte d'analyse ECG et ses buffers internes.
- * @param ctx Le contexte à libérer. Les buffers internes sont également libérés.
+ * @param ctx Le contexte à libérer. Les buffers sont dans la même arène que le contexte,
+ *            seul le contexte de la détection décimée a sa propre arène.
  */
 void ecg_destroy(ECG_Context *ctx) {
-    if (!ctx) return;
-    free(ctx->high_pass_buffer);
-    free(ctx->derived_buffer);
-    free(ctx->squared_buffer);
-    free(ctx->mwi_buffer);
+    if (ctx) ecg_destroy(ctx->coarse);
     free(ctx);
 }
 
+ECG_Status ecg_reset(ECG_Context *ctx) {
+    if (!ctx) return ECG_ERR_NULL;
+    ecg_stream_reset(ctx);
+    ecg_reset_stats(ctx);
+    return ECG_OK;
+}
+
+size_t ecg_mwi_window(const ECG_Context *ctx) {
+    return ctx ? ctx->mwi_window : 0;
+}
+
+int ecg_analysis_windowed(const ECG_Context *ctx) {
+    return ctx ? ctx->windowed : 0;
+}
+
 /* ===============================================================================
  * Fonctions utilitaires internes
  * =============================================================================== */
@@ -146,35 +473,282 @@ void ecg_destroy(ECG_Context *ctx) {
  * Utilitaire pour affiner la position du pic R sur le signal NON filtré (car il y a un décalage).
  * La recherche se fait dans [center - half_window, center + half_window].
  *
+ * HPC : les pics acceptés sont espacés d'au moins une période réfractaire et la fenêtre fait une période
+ * réfractaire : les fenêtres ne se recouvrent pas, le coût total est O(n) (~0.5 ns/échantillon).
+ * Le balayage est confié au noyau argmax (vectorisé, sans branche dépendante des données).
+ *
+ * @param k Noyaux de calcul du contexte.
  * @param signal Le signal ECG à analyser.
  * @param n_samples Le nombre d'échantillons dans le signal.
  * @param center L'indice central autour duquel chercher le maximum.
  * @param half_window La moitié de la fenêtre de recherche (en échantillons).
- * @return L'indice de l'échantillon avec la valeur maximale dans la fenêtre.
+ * @return L'indice de l'échantillon avec la valeur maximale dans la fenêtre (première occurrence).
  */
-static int find_max(const double *signal, size_t n_samples, int center, int half_window) {
+static int find_max(const ECG_Kernels *k, const double *signal, size_t n_samples, int center, int half_window) {
     // On reste dans le tableau
     int start = (center - half_window > 0) ? center - half_window : 0;
-    int end = (center + half_window < n_samples) ? center + half_window : (int)n_samples - 1;
+    int end = ((size_t)(center + half_window) < n_samples) ? center + half_window : (int)n_samples - 1;
+
+    return start + (int)k->argmax(signal + start, (size_t)(end - start + 1));
+}
+
+/**
+ * Initialise le détecteur à partir de l'amplitude max de la MWI.
+ *
+ * @param d Détecteur à initialiser.
+ * @param max_mwi Amplitude max du signal intégré (globale ou phase d'apprentissage).
+ * @param refractory_samples Période réfractaire en échantillons.
+ */
+static void detector_init(ECG_Detector *d, double max_mwi, int refractory_samples) {
+    d->signal_peak = THRESHOLD_INITIAL_FACTOR * max_mwi;
+    d->noise_peak = THRESHOLD_INITIAL_FACTOR * max_mwi * 0.5;
+    d->threshold = d->noise_peak + 0.25 * (d->signal_peak - d->noise_peak);
+    d->refractory_samples = refractory_samples;
+    // Init à -inf pour ne pas bloquer les premiers pics
+    d->last_r_index = -refractory_samples;
+}
+
+/**
+ * Teste l'échantillon i de la MWI et met à jour le seuil adaptatif.
+ * HPC : O(1), pas de tableau d'historique à maintenir, pas de recalcul.
+ *
+ * @param d État du détecteur.
+ * @param i Indice de l'échantillon testé.
+ * @param prev mwi[i-1].
+ * @param cur mwi[i].
+ * @param next mwi[i+1].
+ * @return DETECT_ACCEPT si i est un nouveau pic R, sinon la raison du rejet.
+ */
+static Detect_Result detector_step(ECG_Detector *d, ptrdiff_t i, double prev, double cur, double next) {
+    // Pic local si (mwi[i] > mwi[i-1] et mwi[i] >= mwi[i+1])
+    // Cette façon de faire permet de retourner que le 1er point d'un "plateau"
+    if (!(cur > prev && cur >= next)) return DETECT_NONE;
+
+    // Période réfractaire ou seuil non atteint : on considère comme du bruit
+    const int refractory = i - d->last_r_index < d->refractory_samples;
+    if (refractory || cur < d->threshold) {
+        d->noise_peak = (1.0 - NOISE_PEAK_DECAY_FACTOR) * d->noise_peak + NOISE_PEAK_DECAY_FACTOR * cur;
+        d->threshold = d->noise_peak + 0.25 * (d->signal_peak - d->noise_peak);
+        return refractory ? DETECT_REFRACTORY : DETECT_NOISE;
+    }
+
+    // Màj signal_peak avec le nouveau pic R détecté
+    d->signal_peak = (1.0 - SIGNAL_PEAK_DECAY_FACTOR) * d->signal_peak + SIGNAL_PEAK_DECAY_FACTOR * cur;
+    d->threshold = d->noise_peak + 0.25 * (d->signal_peak - d->noise_peak);
+
+    // Indice dans mwi[] pour la période réfractaire
+    d->last_r_index = i;
+    return DETECT_ACCEPT;
+}
+
+/**
+ * Noyau fusionné passe-haut -> dérivée -> carré -> MWI, échantillon par échantillon.
+ *
+ * Les intermédiaires restent en registres, seule la fenêtre MWI du signal carré est gardée dans un petit
+ * anneau (fused_ring, ~0.5 KB -> L1). La fenêtre du passe-haut relit directement signal[i - win], encore
+ * en cache. Seul mwi[] est écrit : 1 lecture + 1 écriture par échantillon au lieu de 4 buffers complets
+ * écrits puis relus, et le max de la MWI est calculé au vol (plus de passe dédiée).
+ * Mêmes opérations dans le même ordre que ecg_utils : résultat identique bit à bit.
+ *
+ * Généré une fois par fréquence : LP_WIN / MWI_WIN sont des constantes pour les fréquences courantes
+ * (360 Hz des archives MIT-BIH, 500 Hz), les fenêtres du contexte sinon.
+ * HPC : la montée des fenêtres est séparée du régime établi ; une fois les fenêtres pleines, plus de
+ * compteurs ni de branches, et avec des fenêtres constantes les décalages signal[i - win] et les diviseurs
+ * sont des immédiats (boucle déroulable par le compilateur).
+ *
+ * @return Max de la MWI (pour l'initialisation du seuil).
+ */
+#define DEFINE_FUSED_FRONT_END(suffix, LP_WIN, MWI_WIN)                                               \
+static double fused_front_end_##suffix(ECG_Context *ctx, const double *signal, size_t n_samples, double *mwi) { \
+    const size_t lp_win = (LP_WIN);                                                                   \
+    const size_t mwi_win = (MWI_WIN);                                                                 \
+    const size_t mask = ctx->fused_mask;                                                              \
+    double *sq_ring = ctx->fused_ring;                                                                \
+                                                                                                      \
+    double hp_sum = 0.0, mwi_sum = 0.0, prev_hp = 0.0, max_mwi = 0.0;                                 \
+    size_t hp_w = 0, mwi_w = 0;                                                                       \
+                                                                                                      \
+    /* Montée des fenêtres : logique de ecg_highpass_ma / ecg_mwi */                                  \
+    const size_t warm = (lp_win > mwi_win) ? lp_win : mwi_win;                                        \
+    const size_t n_warm = (n_samples < warm) ? n_samples : warm;                                      \
+    size_t i = 0;                                                                                     \
+    for (; i < n_warm; i++) {                                                                         \
+        const double x = signal[i];                                                                   \
+                                                                                                      \
+        /* 1. Passe-haut */                                                                           \
+        hp_sum += x;                                                                                  \
+        ++hp_w;                                                                                       \
+        if (hp_w > lp_win) {                                                                          \
+            hp_sum -= signal[i - lp_win];                                                             \
+            --hp_w;                                                                                   \
+        }                                                                                             \
+        const double hp = x - hp_sum / (double)hp_w;                                                  \
+                                                                                                      \
+        /* 2. Dérivée et 3. carré */                                                                  \
+        const double d = (i == 0) ? 0.0 : hp - prev_hp;                                               \
+        prev_hp = hp;                                                                                 \
+        const double sq = d * d;                                                                      \
+        sq_ring[i & mask] = sq;                                                                       \
+                                                                                                      \
+        /* 4. MWI */                                                                                  \
+        mwi_sum += sq;                                                                                \
+        ++mwi_w;                                                                                      \
+        if (mwi_w > mwi_win) {                                                                        \
+            mwi_sum -= sq_ring[(i - mwi_win) & mask];                                                 \
+            --mwi_w;                                                                                  \
+        }                                                                                             \
+        const double m = mwi_sum / (double)mwi_w;                                                     \
+        mwi[i] = m;                                                                                   \
+        if (m > max_mwi) max_mwi = m;                                                                 \
+    }                                                                                                 \
+                                                                                                      \
+    /* Régime établi : fenêtres pleines (hp_w == lp_win, mwi_w == mwi_win), mêmes opérations */       \
+    for (; i < n_samples; i++) {                                                                      \
+        const double x = signal[i];                                                                   \
+        hp_sum += x;                                                                                  \
+        hp_sum -= signal[i - lp_win];                                                                 \
+        const double hp = x - hp_sum / (double)lp_win;                                                \
+                                                                                                      \
+        const double d = hp - prev_hp;                                                                \
+        prev_hp = hp;                                                                                 \
+        const double sq = d * d;                                                                      \
+        sq_ring[i & mask] = sq;                                                                       \
+                                                                                                      \
+        mwi_sum += sq;                                                                                \
+        mwi_sum -= sq_ring[(i - mwi_win) & mask];                                                     \
+        const double m = mwi_sum / (double)mwi_win;                                                   \
+        mwi[i] = m;                                                                                   \
+        if (m > max_mwi) max_mwi = m;                                                                 \
+    }                                                                                                 \
+                                                                                                      \
+    return max_mwi;                                                                                   \
+}
+
+DEFINE_FUSED_FRONT_END(generic, ctx->low_pass_window ? ctx->low_pass_window : 1,
+                                ctx->mwi_window ? ctx->mwi_window : 1)
+DEFINE_FUSED_FRONT_END(360, MS_TO_SAMPLES(LOW_PASS_WINDOW_MS, 360), MS_TO_SAMPLES(MWI_WINDOW_MS, 360))
+DEFINE_FUSED_FRONT_END(500, MS_TO_SAMPLES(LOW_PASS_WINDOW_MS, 500), MS_TO_SAMPLES(MWI_WINDOW_MS, 500))
+
+static Fused_Front_End fused_front_end_select(int fs) {
+    switch (fs) {
+        case 360: return fused_front_end_360;
+        case 500: return fused_front_end_500;
+        default:  return fused_front_end_generic;
+    }
+}
+
+/**
+ * Étapes 1 à 4 du pipeline (passe-haut ou passe-bande, dérivée, carré, MWI) : ctx->mwi_buffer reçoit la MWI.
+ * Noyau fusionné en une passe, ou une passe par filtre avec les intermédiaires dans les buffers du contexte.
+ *
+ * @return Amplitude max de la MWI (initialisation du seuil adaptatif).
+ */
+static double front_end(ECG_Context *ctx, const double *signal, size_t n_samples) {
+    STATS_CLOCK(t);
+
+    // Passe-haut
+    double *hp = ctx->high_pass_buffer;
+    // Dérivation
+    double *deriv = ctx->derived_buffer;
+    // Carré
+    double *squared = ctx->squared_buffer;
+    // Intégration
+    double *mwi = ctx->mwi_buffer;
 
-    int best_id = start;
-    double best_val = signal[start];
+    // Fenêtres pré calculées dans ecg_create
+    const size_t low_pass_window = ctx->low_pass_window;
+    const size_t mwi_window = ctx->mwi_window;
 
-    // accès séquentiel
-    for (int i = start + 1; i <= end; i++) {
-        if (signal[i] > best_val) {
-            best_val = signal[i];
-            best_id = i;
+    double max_mwi = 0.0;
+    if (ctx->params.fused && ctx->band_sections == 0) {
+        // 1 à 4 en une seule passe, le max de la MWI est calculé au vol
+        max_mwi = ctx->fused_front_end(ctx, signal, n_samples, mwi);
+        STATS_LAP(ctx, ns_fused, t);
+    } else {
+        // 1. Filtre passe-haut
+        // Objectif : supprimer dérive lente de la ligne basse (< 1Hz)
+        // Méthode : soustraction moyenne glissante (passe-haute =  x - MA(x))
+        // HPC : O(n), zéro alloc
+        // Variante passe-bande (ECG_Params.filter) : cascade de biquads 5-15 Hz, démarrée en régime établi
+        // sur signal[0] (pas de transitoire d'échelon) ; aller-retour pour la phase nulle.
+        // HPC : O(n x sections), par blocs qui restent en L1 d'une section à l'autre
+        if (ctx->params.filter == ECG_FILTER_BANDPASS_ZERO_PHASE) {
+            ecg_biquad_zero_phase(ctx->band, ctx->band_sections, signal, hp, n_samples);
+        } else if (ctx->band_sections > 0) {
+            ECG_Biquad_State band_state[ECG_BIQUAD_MAX_SECTIONS];
+            ecg_biquad_steady_state(ctx->band, ctx->band_sections, signal[0], band_state);
+            ecg_biquad_cascade(ctx->band, ctx->band_sections, band_state, signal, hp, n_samples);
+        } else {
+            ctx->kernels->highpass_ma(signal, hp, n_samples, low_pass_window);
         }
+        STATS_LAP(ctx, ns_highpass, t);
+
+        // 2. Dérivation discrète
+        // Objectif : accentuer les transitions rapides (QRS a des pentes très raides par rapport aux ondes P et T)
+        // Méthode : y[i] = x[i] - x[i-1], différence premier ordre pour simplicité et rapidité.
+        // HPC : O(n), accès séquentiel, zéro alloc
+        ctx->kernels->derivative_1(hp, deriv, n_samples);
+        STATS_LAP(ctx, ns_derivative, t);
+
+        // 3. Mise au carré
+        // Objectif : réctification, tout devient positif, accentuation non-linéaire des pics.
+        // Méthode : y[i] = x[i]^2
+        // HPC : O(n), multiplication simple par élément
+        ctx->kernels->square(deriv, squared, n_samples);
+        STATS_LAP(ctx, ns_square, t);
+
+        // 4. Intégration sur une fenêtre glissante (Moving Window Integration)
+        // Objectif : lisser l'énergie du signal, faire ressortir les régions où le QRS est présent.
+        // Méthode : moyenne glissante sur une fenêtre de taille mwi_window
+        // HPC : O(n), somme glissante ; le max pour l'initialisation du seuil est tenu en registre
+        // pendant l'écriture (plus de passe dédiée sur mwi[])
+        max_mwi = ctx->kernels->mwi_max(squared, mwi, n_samples, mwi_window);
+        STATS_LAP(ctx, ns_mwi, t);
     }
 
-    return best_id;
+    return max_mwi;
 }
 
+static ECG_Status analyze_windowed(ECG_Context *ctx, const double *signal, size_t n_samples,
+                                   ECG_Peaks *peaks, ECG_Intervals *intervals);
+static ECG_Status analyze_decimated(ECG_Context *ctx, const double *signal, size_t n_samples, int lead_idx,
+                                    ECG_Peaks *peaks, ECG_Intervals *intervals);
+
 /* ===============================================================================
  * Fonction d'analyse principale
  * =============================================================================== */
 
+/**
+ * Intervalles RR (secondes) des pics R, hors valeurs aberrantes ; ajoutés à @p hrv s'il est fourni.
+ * @p intervals peut être NULL (indicateurs HRV seuls).
+ */
+static ECG_Status compute_intervals(const ECG_Peaks *peaks, int sampling_rate_hz, ECG_Intervals *intervals,
+                                    ECG_Hrv_State *hrv) {
+    if (intervals) {
+        intervals->count = 0;
+        if (ecg_intervals_reserve(intervals, peaks->R_count)) return ECG_ERR_ALLOC;
+    }
+
+    // Pré calcul
+    const double interval_fs = 1.0 / (double)sampling_rate_hz;
+
+    for (int i = 0; i + 1 < peaks->R_count; i++) {
+        int delta = peaks->R[i+1] - peaks->R[i];
+
+        // Filtre des val aberrantes : on ignore les intervalles trop courts (< 200 ms) ou trop longs (> 2s)
+        double rr = delta * interval_fs;
+        if (rr >= RR_MIN_S && rr <= RR_MAX_S) {
+            if (intervals) {
+                intervals->RR[intervals->count] = rr;
+                intervals->count++;
+            }
+            if (hrv) ecg_hrv_update(hrv, rr);
+        }
+    }
+
+    return ECG_OK;
+}
+
 /**
  * @brief Analyse un signal ECG et extrait les pics R et les intervalles RR.
  *
@@ -186,7 +760,8 @@ static int find_max(const double *signal, size_t n_samples, int center, int half
  * 4. Intégration sur une fenêtre glissante pour lisser l'énergie du signal.
  * 5. Détectopm des pics R avec un seuil adaptif + période réfractaire.
  * 6. Affinage de la position des pics R sur le signal original.
- * 7. Calcul des intervalles RR à partir des indices des pics R détectés.
+ * 7. Délinéation des ondes P, Q, S, T autour de chaque R (si ECG_Params.delineate).
+ * 8. Calcul des intervalles RR à partir des indices des pics R détectés.
  *
  * @param ctx Contexte d'analyse (non NULL).
  * @param signal Pointeur vers les échantillons ECG (non NULL).
@@ -205,51 +780,37 @@ ECG_Status ecg_analyze(ECG_Context *ctx,
 
     // Vérifications de base
     if (!ctx || !signal || !peaks) return ECG_ERR_NULL;
-    if (n_samples == 0 || n_samples > MAX_SAMPLES) return ECG_ERR_PARAM;
+    if (n_samples == 0) return ECG_ERR_PARAM;
     if (lead_idx < 0 || lead_idx >= ctx->params.leads) return ECG_ERR_PARAM;
+    if (ctx->params.precision != ECG_PRECISION_F64) return ECG_ERR_PARAM;
+
+    // Signal plus long que les buffers : analyse par fenêtres via les anneaux du streaming
+    // (le passe-bande à phase nulle a besoin du signal entier)
+    ctx->windowed = n_samples > ctx->capacity;
+    if (ctx->windowed) {
+        if (ctx->params.filter == ECG_FILTER_BANDPASS_ZERO_PHASE) return ECG_ERR_PARAM;
+        return analyze_windowed(ctx, signal, n_samples, peaks, intervals);
+    }
+
+    // Détection sur le signal décimé, affinage des R à pleine résolution
+    if (ctx->coarse) return analyze_decimated(ctx, signal, n_samples, lead_idx, peaks, intervals);
+
+    STATS_CALL(ctx, n_samples);
 
     // fréquence en Hz
     const int fs = ctx->params.sampling_rate_hz;
-    // Passe-haut
+    // Passe-haut (gardé pour la délinéation par la chaîne multi-passes)
     double *hp = ctx->high_pass_buffer;
-    // Dérivation
-    double *deriv = ctx->derived_buffer;
-    // Carré
-    double *squared = ctx->squared_buffer;
     // Intégration
     double *mwi = ctx->mwi_buffer;
 
-    //Calcul des fenêtres
-    const size_t low_pass_window = (size_t)((LOW_PASS_WINDOW_MS * fs) / 1000);
-    const size_t mwi_window = (size_t)((MWI_WINDOW_MS * fs) / 1000);
-    const int refractory_samples = REFRACTORY_SAMPLES(fs);
+    // Fenêtres pré calculées dans ecg_create
+    const size_t low_pass_window = ctx->low_pass_window;
+    const int refractory_samples = ctx->refractory_samples;
 
-    printf("[ECG] fs=%d Hz, low_pass_window=%zu samples, mwi_window=%zu samples, refractory_samples=%d samples\n",
-           fs, low_pass_window, mwi_window, refractory_samples);
-
-    // 1. Filtre passe-haut
-    // Objectif : supprimer dérive lente de la ligne basse (< 1Hz)
-    // Méthode : soustraction moyenne glissante (passe-haute =  x - MA(x))
-    // HPC : O(n), zéro alloc
-    ecg_highpass_ma(signal, hp, n_samples, low_pass_window);
-
-    // 2. Dérivation discrète
-    // Objectif : accentuer les transitions rapides (QRS a des pentes très raides par rapport aux ondes P et T)
-    // Méthode : y[i] = x[i] - x[i-1], différence premier ordre pour simplicité et rapidité.
-    // HPC : O(n), accès séquentiel, zéro alloc
-    ecg_derivative_1(hp, deriv, n_samples);
-
-    // 3. Mise au carré
-    // Objectif : réctification, tout devient positif, accentuation non-linéaire des pics.
-    // Méthode : y[i] = x[i]^2
-    // HPC : O(n), multiplication simple par élément
-    ecg_square(deriv, squared, n_samples);
-
-    // 4. Intégration sur une fenêtre glissante (Moving Window Integration)
-    // Objectif : lisser l'énergie du signal, faire ressortir les régions où le QRS est présent.
-    // Méthode : moyenne glissante sur une fenêtre de taille mwi_window
-    // HPC : O(n), somme glissante
-    ecg_mwi(squared, mwi, n_samples, mwi_window);
+    // 1 à 4. Filtres et intégration dans mwi[], max de la MWI pour l'initialisation du seuil
+    const double max_mwi = front_end(ctx, signal, n_samples);
+    STATS_CLOCK(t);
 
     // 5. Détection des pics R avec seuil adaptatif + période réfractaire
     // Objectif : chercher les pic  R locaux qui dépassent un seuil dynamique.
@@ -258,19 +819,15 @@ ECG_Status ecg_analyze(ECG_Context *ctx,
     // - noise_peak : moyenne des candidats rejetés.
     // - threshold = noise_peak + 0.25 * (signal_peak - noise_peak)
     // HPC : O(1), pas de tableau d'historique à maintenir, pas de recalcul
-    double max_mwi = 0.0;
-    for (size_t i = 0; i < n_samples; i++)
-        if (mwi[i] > max_mwi) max_mwi = mwi[i];
-
-    double signal_peak = THRESHOLD_INITIAL_FACTOR * max_mwi;
-    double noise_peak = THRESHOLD_INITIAL_FACTOR * max_mwi * 0.5;
-    double threshold = noise_peak + 0.25 * (signal_peak - noise_peak);
+    ECG_Detector det;
+    detector_init(&det, max_mwi, refractory_samples);
 
     // Compteur de pics R détectés
     peaks->R_count = 0;
 
-    // Indice dernier pic R détecté, init à -inf pour ne pas bloquer les premiers pics
-    int last_r_index = -refractory_samples;
+    // Au plus un pic par période réfractaire : une seule réservation, pas de realloc dans la boucle
+    if (ecg_peaks_reserve(peaks, (int)(n_samples / (size_t)(refractory_samples > 0 ? refractory_samples : 1)) + 2))
+        return ECG_ERR_ALLOC;
 
     // 6. Demi-fenêtre pour affinage local
     // On cherche le vrai max dans une fenetre de +-refinement_window autour du pic détecté sur le signal intégré
@@ -279,87 +836,768 @@ ECG_Status ecg_analyze(ECG_Context *ctx,
     // Boucle de détection
     // Pic local
     // HPC : O(n), accès séquentiel, on ne cible que le sommet
-    for (size_t i = 1; i + 1 < n_samples && peaks->R_count < MAX_BEATS; i++)
+    for (size_t i = 1; i + 1 < n_samples && peaks->R_count < peaks->capacity; i++)
     {
-        // Pic local si (mwi[i] > mwi[i-1] et mwi[i] >= mwi[i+1])
-        // Cette façon de faire permet de retourner que le 1er point d'un "plateau"
-        int is_local_max = (mwi[i] > mwi[i-1]) && (mwi[i] >= mwi[i+1]);
-        if (!is_local_max) continue;
-
-        // Période refractaore
-        if ((int)i - last_r_index < refractory_samples) {
-            // Trop proche du dernier pic R détecté, on ignore pour éviter les faux positifs
-            // O(1), pas de buffer
-            noise_peak = (1.0 - NOISE_PEAK_DECAY_FACTOR) * noise_peak + NOISE_PEAK_DECAY_FACTOR * mwi[i];
-            threshold = noise_peak + 0.25 * (signal_peak - noise_peak);
-            continue;
-        }
-
-        // Test du seuil
-        if (mwi[i] < threshold) {
-            // Pas assez grand pour être un pic R, on considère comme du bruit
-            noise_peak = (1.0 - NOISE_PEAK_DECAY_FACTOR) * noise_peak + NOISE_PEAK_DECAY_FACTOR * mwi[i];
-            threshold = noise_peak + 0.25 * (signal_peak - noise_peak);
-            continue;
-        }
+        const Detect_Result r = detector_step(&det, (ptrdiff_t)i, mwi[i-1], mwi[i], mwi[i+1]);
+        STATS_DETECT(ctx, r, &det);
+        if (r != DETECT_ACCEPT) continue;
 
         // Pic R détecté
         // Pic dans mwi[] est décalé temporellement à cause du Moving Window Integration,
         // On affine en cherchant le vrai max local
-        int r_index = find_max(signal, n_samples, (int)i, refinement_window);
-        // TODO probablement changer ça
-        //int r_index = (int)i - 13;
-        //if (r_index < 0) r_index = 0;
-
-        // Màj speak_noise avec le nouveau pic R détecté
-        signal_peak = (1.0 - SIGNAL_PEAK_DECAY_FACTOR) * signal_peak + SIGNAL_PEAK_DECAY_FACTOR * mwi[i];
-        threshold = noise_peak + 0.25 * (signal_peak - noise_peak);
+        int r_index = find_max(ctx->kernels, signal, n_samples, (int)i, refinement_window);
 
         // Save du pic local
         peaks->R[peaks->R_count] = r_index;
         peaks->R_count++;
-
-        // Indice dans mwi[] pour la période réfractaire
-        last_r_index = (int)i;
     }
+    STATS_LAP(ctx, ns_detect, t);
 
-    printf("[ECG] Pics R détectés: %d\n", peaks->R_count);
+    // 7. Délinéation P/Q/S/T (optionnelle)
+    // Objectif : extrema du passe-haut dans des fenêtres bornées autour de chaque R
+    // HPC : O(battements x fenêtre), réutilise hp[] de l'étape 1 ; le noyau fusionné ne l'a pas gardé,
+    // il est recalculé sur la seule fenêtre de chaque battement. Le passe-bande efface les ondes P et T :
+    // la délinéation repart aussi du signal brut dans ce cas
+    if (ctx->params.delineate) {
+        const ECG_Status status = (ctx->params.fused || ctx->band_sections > 0)
+            ? ecg_delineate_raw(signal, n_samples, fs, low_pass_window, ctx->delineation_scratch, peaks)
+            : ecg_delineate(signal, hp, n_samples, fs, low_pass_window, ctx->delineation_scratch, peaks);
+        if (status != ECG_OK) return status;
+        STATS_LAP(ctx, ns_delineate, t);
+    }
 
-    // 7. Calcul des intervalles RR
+    // 8. Calcul des intervalles RR
     // Objectif : calculer la durée entre chaque pic R détecté, en secondes
     // Méthode : RR[i] = (R[i+1] - R[i]) / fs
-    // HPC : O(nbr pics), accès séquentiel, une seule passe
-    if (intervals) {
-        intervals->count = 0;
+    // HPC : O(nbr pics), accès séquentiel, une seule passe ; les indicateurs HRV sont tenus dans la même boucle
+    ecg_hrv_reset(&ctx->hrv);
+    const ECG_Status status = compute_intervals(peaks, fs, intervals, &ctx->hrv);
+    if (status != ECG_OK) return status;
+    STATS_LAP(ctx, ns_intervals, t);
+
+    return ECG_OK;
+}
+
+/**
+ * @brief Calcule les intervalles RR (en secondes) à partir des pics R.
+ *
+ * Objectif : calculer la durée entre chaque pic R détecté, en secondes
+ * Méthode : RR[i] = (R[i+1] - R[i]) / fs
+ * HPC : O(nbr pics), accès séquentiel, une seule passe
+ */
+ECG_Status ecg_compute_intervals(const ECG_Peaks *peaks, int sampling_rate_hz, ECG_Intervals *intervals) {
+    if (!peaks || !intervals) return ECG_ERR_NULL;
+    if (sampling_rate_hz <= 0) return ECG_ERR_PARAM;
+    return compute_intervals(peaks, sampling_rate_hz, intervals, NULL);
+}
+
+/* ===============================================================================
+ * Variabilité cardiaque (HRV)
+ * =============================================================================== */
+
+void ecg_hrv_reset(ECG_Hrv_State *state) {
+    if (state) memset(state, 0, sizeof(*state));
+}
 
-        // Pré calcul
-        const double interval_fs = 1.0 / (double)fs;
+/*
+ * Objectif : indicateurs HRV à jour à chaque battement, sans relire l'historique
+ * Méthode : Welford pour moyenne / variance (écart à la moyenne courante, stable numériquement),
+ * somme des carrés et compteur NN50 des différences successives, anneau des derniers RR
+ * HPC : O(1) par RR, une poignée de flops, aucune allocation
+ */
+void ecg_hrv_update(ECG_Hrv_State *state, double rr_s) {
+    if (!state) return;
+
+    state->count++;
+    const double delta = rr_s - state->mean;
+    state->mean += delta / (double)state->count;
+    state->m2 += delta * (rr_s - state->mean);
+
+    if (state->count > 1) {
+        const double d = rr_s - state->prev_rr;
+        state->sum_sq_diff += d * d;
+        state->nn50 += fabs(d) > NN50_THRESHOLD_S;
+    }
+    state->prev_rr = rr_s;
+
+    state->history[state->history_head] = rr_s;
+    state->history_head = (state->history_head + 1) % MAX_RR_HISTORY;
+}
+
+ECG_Status ecg_hrv_get(const ECG_Hrv_State *state, ECG_Hrv *hrv) {
+    if (!state || !hrv) return ECG_ERR_NULL;
+    memset(hrv, 0, sizeof(*hrv));
+
+    const int n = state->count;
+    hrv->count = n;
+    if (n == 0) return ECG_OK;
+
+    hrv->last_rr_s = state->prev_rr;
+    hrv->mean_rr_s = state->mean;
+    hrv->mean_hr_bpm = (state->mean > 0.0) ? 60.0 / state->mean : 0.0;
+    if (n > 1) {
+        hrv->sdnn_s = sqrt(state->m2 / (double)(n - 1));
+        hrv->rmssd_s = sqrt(state->sum_sq_diff / (double)(n - 1));
+        hrv->pnn50 = 100.0 * (double)state->nn50 / (double)(n - 1);
+    }
+
+    // Fréquence glissante : somme de l'anneau recalculée (MAX_RR_HISTORY termes), pas de dérive d'arrondi
+    const int k = (n < MAX_RR_HISTORY) ? n : MAX_RR_HISTORY;
+    double sum = 0.0;
+    for (int i = 0; i < k; i++) sum += state->history[i];
+    hrv->rolling_hr_bpm = (sum > 0.0) ? 60.0 * (double)k / sum : 0.0;
+    return ECG_OK;
+}
+
+ECG_Status ecg_get_hrv(const ECG_Context *ctx, ECG_Hrv *hrv) {
+    if (!ctx || !hrv) return ECG_ERR_NULL;
+    return ecg_hrv_get(&ctx->hrv, hrv);
+}
+
+/* ===============================================================================
+ * Précision réduite (float32 / int16)
+ * =============================================================================== */
+
+/*
+ * Chaîne complète générée pour chaque type d'échantillon (SAMPLE_T) :
+ * noyau fusionné passe-haut/dérivée/carré/MWI en float32, puis détection et affinage.
+ *
+ * HPC : le signal est lu en 4 (float32) ou 2 (int16) octets par échantillon et seul mwi[] float32
+ * est écrit, soit 2 à 4 fois moins de trafic mémoire que la chaîne double à 4 buffers.
+ * Les sommes glissantes restent dans des registres de type SUM_T (double pour float32, int32 exact pour int16) :
+ * pas de dérive d'arrondi sur les longs signaux, contrairement à une somme float32 ajout/retrait.
+ */
+#define DEFINE_REDUCED_ANALYZE(suffix, SAMPLE_T, SUM_T)                                              \
+static int find_max_##suffix(const SAMPLE_T *signal, size_t n_samples, int center, int half_window) { \
+    int start = (center - half_window > 0) ? center - half_window : 0;                                \
+    int end = (center + half_window < (int)n_samples) ? center + half_window : (int)n_samples - 1;    \
+    int best_id = start;                                                                              \
+    SAMPLE_T best_val = signal[start];                                                                \
+    for (int i = start + 1; i <= end; i++) {                                                          \
+        if (signal[i] > best_val) {                                                                   \
+            best_val = signal[i];                                                                     \
+            best_id = i;                                                                              \
+        }                                                                                             \
+    }                                                                                                 \
+    return best_id;                                                                                   \
+}                                                                                                     \
+                                                                                                      \
+static float front_end_##suffix(ECG_Context *ctx, const SAMPLE_T *signal, size_t n_samples, float *mwi) { \
+    const size_t lp_win = ctx->low_pass_window ? ctx->low_pass_window : 1;                            \
+    const size_t mwi_win = ctx->mwi_window ? ctx->mwi_window : 1;                                      \
+    const size_t mask = ctx->fused_mask;                                                              \
+    float *sq_ring = ctx->fused_ring_f32;                                                             \
+                                                                                                      \
+    SUM_T hp_sum = 0;                                                                                 \
+    double mwi_sum = 0.0;                                                                             \
+    float prev_hp = 0.0f, max_mwi = 0.0f;                                                             \
+    size_t hp_w = 0, mwi_w = 0;                                                                       \
+                                                                                                      \
+    for (size_t i = 0; i < n_samples; i++) {                                                          \
+        const SAMPLE_T x = signal[i];                                                                 \
+        hp_sum += x;                                                                                  \
+        if (++hp_w > lp_win) {                                                                        \
+            hp_sum -= signal[i - lp_win];                                                             \
+            --hp_w;                                                                                   \
+        }                                                                                             \
+        const float hp = (float)x - (float)hp_sum / (float)hp_w;                                      \
+                                                                                                      \
+        const float d = (i == 0) ? 0.0f : hp - prev_hp;                                               \
+        prev_hp = hp;                                                                                 \
+        const float sq = d * d;                                                                       \
+        sq_ring[i & mask] = sq;                                                                       \
+                                                                                                      \
+        mwi_sum += sq;                                                                                \
+        if (++mwi_w > mwi_win) {                                                                      \
+            mwi_sum -= sq_ring[(i - mwi_win) & mask];                                                 \
+            --mwi_w;                                                                                  \
+        }                                                                                             \
+        const float m = (float)(mwi_sum / (double)mwi_w);                                             \
+        mwi[i] = m;                                                                                   \
+        if (m > max_mwi) max_mwi = m;                                                                 \
+    }                                                                                                 \
+    return max_mwi;                                                                                   \
+}                                                                                                     \
+                                                                                                      \
+ECG_Status ecg_analyze_##suffix(ECG_Context *ctx, const SAMPLE_T *signal, size_t n_samples, int lead_idx, \
+                                ECG_Peaks *peaks, ECG_Intervals *intervals) {                         \
+    if (!ctx || !signal || !peaks) return ECG_ERR_NULL;                                               \
+    if (n_samples == 0 || n_samples > ctx->capacity) return ECG_ERR_PARAM;                            \
+    if (lead_idx < 0 || lead_idx >= ctx->params.leads) return ECG_ERR_PARAM;                          \
+    if (ctx->params.precision != PRECISION_OF_##suffix) return ECG_ERR_PARAM;                         \
+                                                                                                      \
+    STATS_CALL(ctx, n_samples);                                                                       \
+    STATS_CLOCK(t);                                                                                   \
+    float *mwi = ctx->mwi_f32;                                                                        \
+    const float max_mwi = front_end_##suffix(ctx, signal, n_samples, mwi);                            \
+    STATS_LAP(ctx, ns_fused, t);                                                                      \
+                                                                                                      \
+    /* Même détecteur que la chaîne double */                                                         \
+    const int refractory_samples = ctx->refractory_samples;                                           \
+    ECG_Detector det;                                                                                 \
+    detector_init(&det, max_mwi, refractory_samples);                                                 \
+                                                                                                      \
+    peaks->R_count = 0;                                                                               \
+    if (ecg_peaks_reserve(peaks, (int)(n_samples / (size_t)(refractory_samples > 0 ? refractory_samples : 1)) + 2)) \
+        return ECG_ERR_ALLOC;                                                                         \
+                                                                                                      \
+    const int refinement_window = refractory_samples / 2;                                             \
+    for (size_t i = 1; i + 1 < n_samples && peaks->R_count < peaks->capacity; i++) {                  \
+        const Detect_Result r = detector_step(&det, (ptrdiff_t)i, mwi[i-1], mwi[i], mwi[i+1]);       \
+        STATS_DETECT(ctx, r, &det);                                                                   \
+        if (r != DETECT_ACCEPT) continue;                                                             \
+        peaks->R[peaks->R_count++] = find_max_##suffix(signal, n_samples, (int)i, refinement_window); \
+    }                                                                                                 \
+    STATS_LAP(ctx, ns_detect, t);                                                                     \
+                                                                                                      \
+    if (ctx->params.delineate) {                                                                      \
+        const ECG_Status st = ecg_delineate_raw_##suffix(signal, n_samples, ctx->params.sampling_rate_hz, \
+                                                         ctx->low_pass_window, ctx->delineation_scratch, peaks); \
+        if (st != ECG_OK) return st;                                                                  \
+        STATS_LAP(ctx, ns_delineate, t);                                                              \
+    }                                                                                                 \
+    ecg_hrv_reset(&ctx->hrv);                                                                         \
+    const ECG_Status status = compute_intervals(peaks, ctx->params.sampling_rate_hz, intervals, &ctx->hrv); \
+    STATS_LAP(ctx, ns_intervals, t);                                                                  \
+    return status;                                                                                    \
+}
+
+#define PRECISION_OF_f32 ECG_PRECISION_F32
+#define PRECISION_OF_i16 ECG_PRECISION_I16
+
+DEFINE_REDUCED_ANALYZE(f32, float, double)
+DEFINE_REDUCED_ANALYZE(i16, int16_t, int32_t)
+
+/* ===============================================================================
+ * Mode streaming
+ * =============================================================================== */
+
+ECG_Status ecg_stream_reset(ECG_Context *ctx) {
+    if (!ctx) return ECG_ERR_NULL;
+
+    ECG_Stream *st = &ctx->stream;
+    st->n_seen = 0;
+    st->hp_sum = 0.0;
+    st->hp_w = 0;
+    st->prev_hp = 0.0;
+    st->mwi_sum = 0.0;
+    st->mwi_w = 0;
+    memset(st->band_state, 0, sizeof(st->band_state));
+    st->learn_max = 0.0;
+    st->learned = 0;
+    st->cursor = 1;
+    st->pending_center = -1;
+    st->last_emitted_r = -1;
+    detector_init(&st->det, 0.0, ctx->refractory_samples);
+    ecg_hrv_reset(&ctx->hrv);
+
+    return ECG_OK;
+}
+
+/**
+ * Équivalent de find_max() sur l'anneau du signal brut.
+ * La fenêtre ne dépasse jamais la taille de l'anneau (garanti par le dimensionnement dans ecg_create) :
+ * au plus deux segments contigus (avant / après le repli), chacun balayé par le noyau argmax.
+ */
+static size_t ring_find_max(const ECG_Kernels *k, const ECG_Stream *st, size_t center, size_t half_window) {
+    size_t start = (center > half_window) ? center - half_window : 0;
+    size_t end = (center + half_window < st->n_seen) ? center + half_window : st->n_seen - 1;
+
+    const size_t len = end - start + 1;
+    const size_t pos = start & st->ring_mask;
+    const size_t first = (len < st->ring_mask + 1 - pos) ? len : st->ring_mask + 1 - pos;
+
+    size_t best_id = start + k->argmax(st->raw_ring + pos, first);
+    if (first < len) {
+        // Strictement supérieur : à égalité, la première occurrence (premier segment) est gardée
+        const size_t wrap = k->argmax(st->raw_ring, len - first);
+        if (st->raw_ring[wrap] > st->raw_ring[best_id & st->ring_mask]) best_id = start + first + wrap;
+    }
+
+    return best_id;
+}
+
+/**
+ * Affine le pic en attente et l'ajoute aux sorties (+ intervalle RR avec le pic précédent).
+ * Les sorties sont agrandies si nécessaire (amorti O(1)).
+ */
+static ECG_Status stream_emit_pending(ECG_Context *ctx, ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    ECG_Stream *st = &ctx->stream;
+    const size_t half_window = (size_t)(ctx->refractory_samples / 2);
 
-        for (int i = 0; i + 1 < peaks->R_count && intervals->count < MAX_BEATS; i++) {
-            int delta = peaks->R[i+1] - peaks->R[i];
+    const ptrdiff_t r_index = (ptrdiff_t)ring_find_max(ctx->kernels, st, (size_t)st->pending_center, half_window);
+    st->pending_center = -1;
 
-            // Filtre des val aberrantes : on ignore les intervalles trop courts (< 200 ms) ou trop longs (> 2s)
-            double rr = delta * interval_fs;
-            if (rr >= 0.2 && rr <= 2.0) {
+    if (ecg_peaks_reserve(peaks, peaks->R_count + 1)) return ECG_ERR_ALLOC;
+    peaks->R[peaks->R_count] = (int)r_index;
+    peaks->R_count++;
+
+    // Même filtre des valeurs aberrantes que l'analyse globale (200 ms .. 2 s), HRV mis à jour au vol
+    if (st->last_emitted_r >= 0) {
+        const double rr = (double)(r_index - st->last_emitted_r) * (1.0 / (double)ctx->params.sampling_rate_hz);
+        if (rr >= RR_MIN_S && rr <= RR_MAX_S) {
+            ecg_hrv_update(&ctx->hrv, rr);
+            if (intervals) {
+                if (ecg_intervals_reserve(intervals, intervals->count + 1)) return ECG_ERR_ALLOC;
                 intervals->RR[intervals->count] = rr;
                 intervals->count++;
             }
         }
+    }
+    st->last_emitted_r = r_index;
+
+    return ECG_OK;
+}
+
+/**
+ * Fin de la phase d'apprentissage : max de la MWI sur les échantillons déjà reçus,
+ * tenu au vol par ecg_push() (pas de nouveau balayage de l'anneau).
+ */
+static void stream_learn(ECG_Context *ctx) {
+    ECG_Stream *st = &ctx->stream;
 
-        printf("[ECG] Intervalles RR valides: %d\n", intervals->count);
+    detector_init(&st->det, st->learn_max, ctx->refractory_samples);
+    st->learned = 1;
+}
 
-        // Fréquence cardiaque moyenne en BPM
-        if (intervals->count > 0) {
-            double rr_sum = 0.0;
-            for (int i = 0; i < intervals->count; i++)
-                rr_sum += intervals->RR[i];
+/**
+ * Fait avancer la détection sur tous les candidats dont le voisin de droite est disponible.
+ * Un pic accepté est émis dès que la demi-fenêtre d'affinage est complète.
+ */
+static ECG_Status stream_detect(ECG_Context *ctx, ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    ECG_Stream *st = &ctx->stream;
+    const size_t mask = st->ring_mask;
+    const size_t half_window = (size_t)(ctx->refractory_samples / 2);
 
-            double rr_mean = rr_sum / intervals->count;
-            double bpm = 60.0 / rr_mean;
-            printf("[ECG] Fréquence cardiaque moyenne: %.1f BPM\n", bpm);
-            printf("[ECG] RR moyen: %.3f s\n", rr_mean);
+    for (;;) {
+        // La période réfractaire (> demi-fenêtre) garantit qu'un pic est émis avant que le suivant soit accepté
+        if (st->pending_center >= 0 && (size_t)st->pending_center + half_window < st->n_seen) {
+            const ECG_Status status = stream_emit_pending(ctx, peaks, intervals);
+            if (status != ECG_OK) return status;
         }
+
+        if (st->cursor + 1 >= st->n_seen) break;
+
+        const size_t i = st->cursor;
+        const Detect_Result r = detector_step(&st->det, (ptrdiff_t)i,
+                                              st->mwi_ring[(i - 1) & mask],
+                                              st->mwi_ring[i & mask],
+                                              st->mwi_ring[(i + 1) & mask]);
+        STATS_DETECT(ctx, r, &st->det);
+        if (r == DETECT_ACCEPT) st->pending_center = (ptrdiff_t)i;
+        st->cursor++;
+    }
+
+    return ECG_OK;
+}
+
+/**
+ * @brief Ajoute un bloc d'échantillons au flux et détecte les pics R confirmés.
+ *
+ * Même pipeline que ecg_analyze(), mais échantillon par échantillon : les sommes glissantes du
+ * passe-haut et de la MWI, la dérivée et l'état du seuil adaptatif sont conservés entre les appels.
+ * Les calculs sont faits dans le même ordre que les fonctions de ecg_utils, les signaux intermédiaires
+ * sont donc identiques bit à bit à ceux de l'analyse globale.
+ *
+ * HPC : O(n) par bloc, mémoire constante (anneaux), zéro alloc.
+ */
+ECG_Status ecg_push(ECG_Context *ctx,
+                    const double *chunk,
+                    size_t n,
+                    ECG_Peaks *peaks,
+                    ECG_Intervals *intervals) {
+    if (!ctx || !peaks || (!chunk && n > 0)) return ECG_ERR_NULL;
+    // Pas de retour arrière possible sur un flux
+    if (ctx->params.filter == ECG_FILTER_BANDPASS_ZERO_PHASE) return ECG_ERR_PARAM;
+
+    STATS_CALL(ctx, n);
+    STATS_CLOCK(t);
+    peaks->R_count = 0;
+    if (intervals) intervals->count = 0;
+
+    ECG_Stream *st = &ctx->stream;
+    const size_t mask = st->ring_mask;
+    const size_t lp_win = ctx->low_pass_window ? ctx->low_pass_window : 1;
+    const size_t mwi_win = ctx->mwi_window ? ctx->mwi_window : 1;
+
+    for (size_t k = 0; k < n; k++) {
+        const size_t idx = st->n_seen;
+        const double x = chunk[k];
+        st->raw_ring[idx & mask] = x;
+
+        // 1. Passe-haut : y = x - MA(x), même somme glissante que ecg_highpass_ma,
+        // ou passe-bande : même cascade que l'analyse globale, démarrée en régime établi sur le 1er échantillon
+        double hp;
+        if (ctx->band_sections > 0) {
+            if (idx == 0) ecg_biquad_steady_state(ctx->band, ctx->band_sections, x, st->band_state);
+            ecg_biquad_cascade(ctx->band, ctx->band_sections, st->band_state, &x, &hp, 1);
+        } else {
+            st->hp_sum += x;
+            st->hp_w++;
+            if (st->hp_w > lp_win) {
+                st->hp_sum -= st->raw_ring[(idx - lp_win) & mask];
+                st->hp_w--;
+            }
+            hp = x - st->hp_sum / (double)st->hp_w;
+        }
+
+        // 2. Dérivée (y[0] = 0) et 3. carré
+        const double d = (idx == 0) ? 0.0 : hp - st->prev_hp;
+        st->prev_hp = hp;
+        const double sq = d * d;
+        st->sq_ring[idx & mask] = sq;
+
+        // 4. MWI, même somme glissante que ecg_mwi
+        st->mwi_sum += sq;
+        st->mwi_w++;
+        if (st->mwi_w > mwi_win) {
+            st->mwi_sum -= st->sq_ring[(idx - mwi_win) & mask];
+            st->mwi_w--;
+        }
+        const double m = st->mwi_sum / (double)st->mwi_w;
+        st->mwi_ring[idx & mask] = m;
+
+        st->n_seen++;
+
+        // 5. Détection, après la phase d'apprentissage
+        if (!st->learned) {
+            if (m > st->learn_max) st->learn_max = m;
+            if (st->n_seen < ctx->learning_samples) continue;
+            stream_learn(ctx);
+        }
+        const ECG_Status status = stream_detect(ctx, peaks, intervals);
+        if (status != ECG_OK) return status;
+    }
+
+    STATS_LAP(ctx, ns_stream, t);
+    return ECG_OK;
+}
+
+/**
+ * @brief Termine le flux : émet le dernier pic en attente (fenêtre d'affinage tronquée).
+ *
+ * Si le flux est plus court que la phase d'apprentissage, l'apprentissage se fait sur ce qui a été reçu,
+ * ce qui donne exactement le même résultat que ecg_analyze() sur le même signal.
+ */
+ECG_Status ecg_flush(ECG_Context *ctx, ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    if (!ctx || !peaks) return ECG_ERR_NULL;
+
+    peaks->R_count = 0;
+    if (intervals) intervals->count = 0;
+
+    ECG_Stream *st = &ctx->stream;
+    if (st->n_seen == 0) return ECG_OK;
+
+    STATS_CALL(ctx, 0);
+    STATS_CLOCK(t);
+    ECG_Status status = ECG_OK;
+    if (!st->learned) {
+        stream_learn(ctx);
+        status = stream_detect(ctx, peaks, intervals);
+    }
+    if (status == ECG_OK && st->pending_center >= 0) status = stream_emit_pending(ctx, peaks, intervals);
+
+    STATS_LAP(ctx, ns_stream, t);
+    return status;
+}
+
+/**
+ * Concatène les résultats d'un bloc du streaming aux résultats cumulés.
+ */
+static ECG_Status append_chunk(ECG_Peaks *peaks, ECG_Intervals *intervals,
+                               const ECG_Peaks *chunk_peaks, const ECG_Intervals *chunk_intervals) {
+    if (ecg_peaks_reserve(peaks, peaks->R_count + chunk_peaks->R_count)) return ECG_ERR_ALLOC;
+    memcpy(peaks->R + peaks->R_count, chunk_peaks->R, sizeof(int) * (size_t)chunk_peaks->R_count);
+    peaks->R_count += chunk_peaks->R_count;
+
+    if (!intervals) return ECG_OK;
+    if (ecg_intervals_reserve(intervals, intervals->count + chunk_intervals->count)) return ECG_ERR_ALLOC;
+    memcpy(intervals->RR + intervals->count, chunk_intervals->RR, sizeof(double) * (size_t)chunk_intervals->count);
+    intervals->count += chunk_intervals->count;
+
+    return ECG_OK;
+}
+
+/**
+ * Analyse d'un signal plus long que les buffers du contexte (ex. Holter 24 h) : le signal est poussé
+ * par blocs de la capacité du contexte dans le chemin streaming, puis les résultats sont concaténés.
+ * Mémoire de travail bornée par les anneaux, indépendante de n_samples.
+ */
+static ECG_Status analyze_windowed(ECG_Context *ctx, const double *signal, size_t n_samples,
+                                   ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    ECG_Peaks chunk_peaks;
+    ECG_Intervals chunk_intervals;
+    ECG_Status status = ECG_OK;
+
+    if (ecg_peaks_init(&chunk_peaks, 0) || ecg_intervals_init(&chunk_intervals, 0)) {
+        ecg_peaks_free(&chunk_peaks);
+        ecg_intervals_free(&chunk_intervals);
+        return ECG_ERR_ALLOC;
+    }
+
+    peaks->R_count = 0;
+    if (intervals) intervals->count = 0;
+    ecg_stream_reset(ctx);
+
+    for (size_t off = 0; off < n_samples && status == ECG_OK; off += ctx->capacity) {
+        const size_t n = (n_samples - off < ctx->capacity) ? n_samples - off : ctx->capacity;
+        status = ecg_push(ctx, signal + off, n, &chunk_peaks, &chunk_intervals);
+        if (status == ECG_OK) status = append_chunk(peaks, intervals, &chunk_peaks, &chunk_intervals);
+    }
+
+    // Fin du signal : on vide le pic en attente
+    if (status == ECG_OK) status = ecg_flush(ctx, &chunk_peaks, &chunk_intervals);
+    if (status == ECG_OK) status = append_chunk(peaks, intervals, &chunk_peaks, &chunk_intervals);
+
+    // Signal complet disponible : délinéation battement par battement sur le brut (mémoire bornée)
+    if (status == ECG_OK && ctx->params.delineate) {
+        STATS_CLOCK(t);
+        status = ecg_delineate_raw(signal, n_samples, ctx->params.sampling_rate_hz, ctx->low_pass_window,
+                                   ctx->delineation_scratch, peaks);
+        STATS_LAP(ctx, ns_delineate, t);
     }
 
+    ecg_peaks_free(&chunk_peaks);
+    ecg_intervals_free(&chunk_intervals);
+    return status;
+}
+
+/**
+ * Détection décimée (ECG_Params.decimation) : toute la chaîne (filtres, MWI, seuil adaptatif, affinage)
+ * tourne dans le contexte coarse sur le signal décimé. Le filtre triangulaire de la décimation est centré :
+ * un R du signal décimé, j, est à moins d'un échantillon décimé du vrai R, repris sur le signal d'origine
+ * par find_max dans [j * decimation - decimation, j * decimation + decimation].
+ *
+ * HPC : filtres et détection sur n / decimation échantillons. La pleine résolution n'est lue qu'une fois
+ * par la décimation (2 opérations par échantillon), puis sur 2 x decimation + 1 échantillons par battement.
+ */
+static ECG_Status analyze_decimated(ECG_Context *ctx, const double *signal, size_t n_samples, int lead_idx,
+                                    ECG_Peaks *peaks, ECG_Intervals *intervals) {
+    STATS_CALL(ctx, n_samples);
+    STATS_CLOCK(t);
+
+    const int factor = ctx->params.decimation;
+    const size_t n_coarse = ecg_decimate(signal, n_samples, (size_t)factor, ctx->coarse_signal);
+    ECG_Status status = ecg_analyze(ctx->coarse, ctx->coarse_signal, n_coarse, lead_idx, peaks, NULL);
+    if (status != ECG_OK) return status;
+
+    for (int i = 0; i < peaks->R_count; i++)
+        peaks->R[i] = find_max(ctx->kernels, signal, n_samples, peaks->R[i] * factor, factor);
+    STATS_LAP(ctx, ns_detect, t);
+
+    // Délinéation et intervalles comme ecg_analyze, sur le signal pleine résolution
+    const int fs = ctx->params.sampling_rate_hz;
+    if (ctx->params.delineate) {
+        status = ecg_delineate_raw(signal, n_samples, fs, ctx->low_pass_window, ctx->delineation_scratch, peaks);
+        if (status != ECG_OK) return status;
+        STATS_LAP(ctx, ns_delineate, t);
+    }
+
+    ecg_hrv_reset(&ctx->hrv);
+    status = compute_intervals(peaks, fs, intervals, &ctx->hrv);
+    if (status != ECG_OK) return status;
+    STATS_LAP(ctx, ns_intervals, t);
+
     return ECG_OK;
-}
\ No newline at end of file
+}
+
+/* ===============================================================================
+ * Analyse parallèle d'un long enregistrement
+ * =============================================================================== */
+
+/*
+ * Segment de l'analyse parallèle : pics R dont le candidat (indice dans la MWI) est dans [begin, end),
+ * calculés sur [ext_begin, ext_end), le segment élargi des recouvrements de tête et de queue.
+ */
+typedef struct {
+    size_t begin, end;
+    size_t ext_begin, ext_end;
+    ECG_Context *ctx;           // contexte du segment, dimensionné sur [ext_begin, ext_end)
+    double max_mwi;             // max de la MWI sur [begin, end)
+    ECG_Peaks peaks;            // pics R du segment (indices du signal complet)
+    ECG_Peaks candidates;       // candidat de la MWI de chaque pic R (indices du signal complet)
+    int first_beat;             // indice du premier pic retenu du segment dans la liste assemblée
+    ECG_Status status;
+} Parallel_Chunk;
+
+/*
+ * Phase 1 : filtres et MWI du segment élargi, dans son propre contexte.
+ * Le max est pris sur la partie propre du segment : le max des segments est celui du signal entier.
+ */
+static void chunk_front_end(const ECG_Params *params, const double *signal, Parallel_Chunk *c) {
+    const size_t n = c->ext_end - c->ext_begin;
+    ECG_Params p = *params;
+    p.max_samples = n;
+    c->ctx = ecg_create(&p);
+    if (!c->ctx || ecg_peaks_init(&c->peaks, 0) || ecg_peaks_init(&c->candidates, 0)) {
+        c->status = ECG_ERR_ALLOC;
+        return;
+    }
+
+    front_end(c->ctx, signal + c->ext_begin, n);
+    const double *mwi = c->ctx->mwi_buffer + (c->begin - c->ext_begin);
+    const double m = mwi[c->ctx->kernels->argmax(mwi, c->end - c->begin)];
+    c->max_mwi = (m > 0.0) ? m : 0.0;
+    c->status = ECG_OK;
+}
+
+/*
+ * Phase 2 : détection avec le seuil initial du signal entier. Le recouvrement de tête ne produit aucun pic,
+ * il sert à réchauffer le détecteur (signal_peak, noise_peak, dernier pic pour la période réfractaire).
+ * Affinage sur le signal complet : aucun effet de bord aux limites du segment.
+ */
+static void chunk_detect(const double *signal, size_t n_samples, double max_mwi, Parallel_Chunk *c) {
+    ECG_Context *ctx = c->ctx;
+    const double *mwi = ctx->mwi_buffer;
+    const size_t n = c->ext_end - c->ext_begin;
+    const int refractory_samples = ctx->refractory_samples;
+    const int refinement_window = refractory_samples / 2;
+
+    const int capacity = (int)((c->end - c->begin) / (size_t)(refractory_samples > 0 ? refractory_samples : 1)) + 2;
+    if (ecg_peaks_reserve(&c->peaks, capacity) || ecg_peaks_reserve(&c->candidates, capacity)) {
+        c->status = ECG_ERR_ALLOC;
+        return;
+    }
+    c->peaks.R_count = 0;
+
+    ECG_Detector det;
+    detector_init(&det, max_mwi, refractory_samples);
+    for (size_t i = 1; i + 1 < n && c->peaks.R_count < c->peaks.capacity; i++) {
+        const size_t g = c->ext_begin + i;
+        if (g >= c->end) break;
+        const Detect_Result r = detector_step(&det, (ptrdiff_t)i, mwi[i-1], mwi[i], mwi[i+1]);
+        if (r != DETECT_ACCEPT || g < c->begin) continue;
+
+        c->candidates.R[c->peaks.R_count] = (int)g;
+        c->peaks.R[c->peaks.R_count] = find_max(ctx->kernels, signal, n_samples, (int)g, refinement_window);
+        c->peaks.R_count++;
+    }
+}
+
+/*
+ * Pics R du segment conservés à l'assemblage : un candidat à moins d'une période réfractaire du dernier
+ * pic retenu, ou un R qui ne progresse pas, est un doublon de la zone de recouvrement (compaction sur place).
+ */
+static void chunk_stitch(Parallel_Chunk *c, int refractory_samples, int *last_candidate, int *last_r, int *count) {
+    int kept = 0;
+    c->first_beat = *count;
+    for (int i = 0; i < c->peaks.R_count; i++) {
+        const int candidate = c->candidates.R[i];
+        const int r = c->peaks.R[i];
+        if (*count > 0 && (candidate - *last_candidate < refractory_samples || r <= *last_r)) continue;
+        c->peaks.R[kept++] = r;
+        *last_candidate = candidate;
+        *last_r = r;
+        (*count)++;
+    }
+    c->peaks.R_count = kept;
+}
+
+/*
+ * Délinéation des pics retenus du segment, sur la liste assemblée : les battements de bord voient leurs voisins
+ * des segments adjacents. Même fonction que ecg_analyze (passe-haut du segment, recouvrements compris, ou brut).
+ */
+static ECG_Status chunk_delineate(const double *signal, size_t n_samples, const Parallel_Chunk *c, ECG_Peaks *peaks) {
+    const ECG_Context *ctx = c->ctx;
+    const int fs = ctx->params.sampling_rate_hz;
+    const int end_beat = c->first_beat + c->peaks.R_count;
+    if (ctx->params.fused || ctx->band_sections > 0)
+        return ecg_delineate_raw_beats(signal, n_samples, fs, ctx->low_pass_window, c->first_beat, end_beat,
+                                       ctx->delineation_scratch, peaks);
+    return ecg_delineate_beats(signal, ctx->high_pass_buffer, c->ext_begin, n_samples, fs, ctx->low_pass_window,
+                               c->first_beat, end_beat, ctx->delineation_scratch, peaks);
+}
+
+/**
+ * @brief Analyse hors ligne d'une dérivation en segments recouvrants, un contexte et un thread par segment.
+ *
+ * Objectif : le temps de traitement d'un très long enregistrement (Holter) suit le nombre de cœurs.
+ * Méthode : n_chunks segments de longueur fixe (découpage ne dépendant que de n_samples et n_chunks :
+ * résultat déterministe, quel que soit le nombre de threads), élargis en tête de PARALLEL_WARMUP_MS et en
+ * queue des fenêtres + période réfractaire (MWI du candidat suivant, retour du passe-bande à phase nulle).
+ * Phase 1 : MWI de chaque segment ; le seuil initial vient du max sur tout le signal, comme ecg_analyze.
+ * Phase 2 : détection réchauffée sur le recouvrement de tête. Assemblage dans l'ordre des segments
+ * (chunk_stitch), puis délinéation de la liste assemblée par plages de battements (une par segment).
+ * HPC : régions parallèles (OpenMP) séparées par une barrière pour le max global, assemblage O(pics).
+ */
+ECG_Status ecg_analyze_parallel(const ECG_Params *params,
+                                const double *signal,
+                                size_t n_samples,
+                                int lead_idx,
+                                int n_chunks,
+                                ECG_Peaks *peaks,
+                                ECG_Intervals *intervals) {
+    if (!params || !signal || !peaks) return ECG_ERR_NULL;
+    if (n_samples == 0 || n_chunks <= 0 || params->sampling_rate_hz <= 0) return ECG_ERR_PARAM;
+    if (lead_idx < 0 || lead_idx >= params->leads) return ECG_ERR_PARAM;
+    if (params->precision != ECG_PRECISION_F64 || params->decimation > 1) return ECG_ERR_PARAM;
+    if (n_samples > INT_MAX) return ECG_ERR_PARAM;
+
+    // Recouvrements et nombre de segments : chaque segment est au moins aussi long que son recouvrement de tête
+    const int fs = params->sampling_rate_hz;
+    const size_t tail = (size_t)(MS_TO_SAMPLES(LOW_PASS_WINDOW_MS, fs) + MS_TO_SAMPLES(MWI_WINDOW_MS, fs)
+                                 + REFRACTORY_SAMPLES(fs)) + 1;
+    size_t lead = (size_t)MS_TO_SAMPLES(PARALLEL_WARMUP_MS, fs);
+    if (lead < tail) lead = tail;
+    if ((size_t)n_chunks > n_samples / lead) n_chunks = (n_samples / lead > 0) ? (int)(n_samples / lead) : 1;
+
+    Parallel_Chunk *chunks = calloc((size_t)n_chunks, sizeof(Parallel_Chunk));
+    if (!chunks) return ECG_ERR_ALLOC;
+    for (int k = 0; k < n_chunks; k++) {
+        Parallel_Chunk *c = &chunks[k];
+        c->begin = n_samples * (size_t)k / (size_t)n_chunks;
+        c->end = n_samples * (size_t)(k + 1) / (size_t)n_chunks;
+        c->ext_begin = (c->begin > lead) ? c->begin - lead : 0;
+        c->ext_end = (n_samples - c->end > tail) ? c->end + tail : n_samples;
+        c->status = ECG_ERR_FAIL;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int k = 0; k < n_chunks; k++) chunk_front_end(params, signal, &chunks[k]);
+
+    ECG_Status status = ECG_OK;
+    double max_mwi = 0.0;
+    for (int k = 0; k < n_chunks && status == ECG_OK; k++) {
+        status = chunks[k].status;
+        if (chunks[k].max_mwi > max_mwi) max_mwi = chunks[k].max_mwi;
+    }
+
+    if (status == ECG_OK) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int k = 0; k < n_chunks; k++) chunk_detect(signal, n_samples, max_mwi, &chunks[k]);
+        for (int k = 0; k < n_chunks && status == ECG_OK; k++) status = chunks[k].status;
+    }
+
+    // Assemblage dans l'ordre des segments, doublons des zones de recouvrement écartés
+    int total = 0;
+    if (status == ECG_OK) {
+        int last_candidate = 0, last_r = 0;
+        for (int k = 0; k < n_chunks; k++)
+            chunk_stitch(&chunks[k], REFRACTORY_SAMPLES(fs), &last_candidate, &last_r, &total);
+    }
+
+    peaks->R_count = peaks->P_count = peaks->Q_count = peaks->S_count = peaks->T_count = 0;
+    if (status == ECG_OK && ecg_peaks_reserve(peaks, total + 1)) status = ECG_ERR_ALLOC;
+    for (int k = 0; k < n_chunks && status == ECG_OK; k++) {
+        memcpy(peaks->R + peaks->R_count, chunks[k].peaks.R, sizeof(int) * (size_t)chunks[k].peaks.R_count);
+        peaks->R_count += chunks[k].peaks.R_count;
+    }
+
+    // Délinéation des pics assemblés, une plage de battements par segment : P, Q, S, T parallèles aux R
+    if (status == ECG_OK && params->delineate) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int k = 0; k < n_chunks; k++) chunks[k].status = chunk_delineate(signal, n_samples, &chunks[k], peaks);
+        for (int k = 0; k < n_chunks && status == ECG_OK; k++) status = chunks[k].status;
+        if (status == ECG_OK) peaks->P_count = peaks->Q_count = peaks->S_count = peaks->T_count = peaks->R_count;
+    }
+
+    for (int k = 0; k < n_chunks; k++) {
+        ecg_destroy(chunks[k].ctx);
+        ecg_peaks_free(&chunks[k].peaks);
+        ecg_peaks_free(&chunks[k].candidates);
+    }
+    free(chunks);
+
+    if (status == ECG_OK) status = compute_intervals(peaks, fs, intervals, NULL);
+    return status;
+}
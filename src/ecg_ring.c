@@ -0,0 +1,253 @@
+/**
+ * @file    ecg_ring.c
+ * @brief   Anneau SPSC sans verrou entre le thread d'acquisition et ecg_push().
+ *
+ * Indices head (producteur) et tail (consommateur) croissants, jamais remis à zéro : la position est
+ * indice & mask et le remplissage head - tail (arithmétique non signée, le débordement est sans effet).
+ * Publication par __atomic_store_n RELEASE, lecture par __atomic_load_n ACQUIRE : les échantillons
+ * copiés avant la publication de head sont visibles du consommateur qui lit ce head.
+ */
+#include "ecg_ring.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+// Taille d'une ligne de cache
+#define RING_LINE 64
+
+// Lot par défaut de ecg_ring_consume (en fenêtres MWI)
+#define DEFAULT_BATCH_WINDOWS 8
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+/*
+ * HPC : chaque côté écrit sur sa propre ligne de cache (pas de faux partage). Le producteur garde une
+ * copie de tail et ne relit l'indice du consommateur que quand l'anneau lui semble plein.
+ */
+typedef struct {
+    size_t head;                // prochain indice écrit
+    size_t tail_cache;          // dernier tail lu par le producteur
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t overruns;
+    int closed;
+} Ring_Producer;
+
+typedef struct {
+    size_t tail;                // prochain indice lu
+    uint64_t consumed;
+    uint64_t batches;
+    size_t high_water;
+} Ring_Consumer;
+
+struct ECG_Ring {
+    // Lecture seule après ecg_ring_create
+    union { struct { double *data; size_t mask; } s; unsigned char line[RING_LINE]; } shared;
+    union { Ring_Producer p; unsigned char line[RING_LINE]; } prod;
+    union { Ring_Consumer c; unsigned char line[RING_LINE]; } cons;
+};
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+// Compteur à écrivain unique, lisible depuis un autre thread (ecg_ring_get_counters)
+#define COUNTER_ADD(field, v) __atomic_store_n(&(field), (field) + (v), __ATOMIC_RELAXED)
+
+/* Lot [tail, tail + n[ passé à ecg_push depuis l'anneau : deux appels s'il passe la fin du buffer. */
+static ECG_Status push_batch(const ECG_Ring *ring, ECG_Context *ctx, size_t tail, size_t n,
+                             ECG_Peaks *peaks, ECG_Intervals *intervals, ECG_Ring_Sink sink, void *user) {
+    const size_t at = tail & ring->shared.s.mask;
+    const size_t room = ring->shared.s.mask + 1 - at;
+    const size_t first = (n < room) ? n : room;
+    const double *segments[2] = { ring->shared.s.data + at, ring->shared.s.data };
+    const size_t lengths[2] = { first, n - first };
+
+    for (int k = 0; k < 2; k++) {
+        if (lengths[k] == 0) continue;
+        ECG_Status status = ecg_push(ctx, segments[k], lengths[k], peaks, intervals);
+        if (status == ECG_OK && (peaks->R_count > 0 || intervals->count > 0)) status = sink(user, peaks, intervals);
+        if (status != ECG_OK) return status;
+    }
+    return ECG_OK;
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+ECG_Ring *ecg_ring_create(size_t capacity) {
+    if (capacity == 0 || capacity > SIZE_MAX / 2 / sizeof(double)) return NULL;
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+
+    void *mem = NULL;
+    if (posix_memalign(&mem, RING_LINE, sizeof(ECG_Ring)) != 0) return NULL;
+    ECG_Ring *ring = mem;
+    memset(ring, 0, sizeof(*ring));
+
+    void *data = NULL;
+    if (posix_memalign(&data, RING_LINE, sizeof(double) * size) != 0) {
+        free(ring);
+        return NULL;
+    }
+    ring->shared.s.data = data;
+    ring->shared.s.mask = size - 1;
+    return ring;
+}
+
+void ecg_ring_destroy(ECG_Ring *ring) {
+    if (!ring) return;
+    free(ring->shared.s.data);
+    free(ring);
+}
+
+size_t ecg_ring_write(ECG_Ring *ring, const double *samples, size_t n) {
+    if (!ring || !samples || n == 0) return 0;
+    Ring_Producer *p = &ring->prod.p;
+    if (p->closed) return 0;
+
+    const size_t capacity = ring->shared.s.mask + 1;
+    const size_t head = p->head;
+    size_t free_slots = capacity - (head - p->tail_cache);
+    if (free_slots < n) {
+        p->tail_cache = __atomic_load_n(&ring->cons.c.tail, __ATOMIC_ACQUIRE);
+        free_slots = capacity - (head - p->tail_cache);
+    }
+    const size_t w = (n < free_slots) ? n : free_slots;
+
+    // Copie en deux segments au plus, puis publication de head
+    const size_t at = head & ring->shared.s.mask;
+    const size_t first = (w < capacity - at) ? w : capacity - at;
+    memcpy(ring->shared.s.data + at, samples, sizeof(double) * first);
+    memcpy(ring->shared.s.data, samples + first, sizeof(double) * (w - first));
+    __atomic_store_n(&p->head, head + w, __ATOMIC_RELEASE);
+
+    COUNTER_ADD(p->written, w);
+    if (w < n) {
+        COUNTER_ADD(p->dropped, n - w);
+        COUNTER_ADD(p->overruns, 1);
+    }
+    return w;
+}
+
+size_t ecg_ring_write_space(ECG_Ring *ring) {
+    if (!ring) return 0;
+    Ring_Producer *p = &ring->prod.p;
+    p->tail_cache = __atomic_load_n(&ring->cons.c.tail, __ATOMIC_ACQUIRE);
+    return ring->shared.s.mask + 1 - (p->head - p->tail_cache);
+}
+
+void ecg_ring_close(ECG_Ring *ring) {
+    if (!ring) return;
+    // Après les publications de head : qui voit closed voit le head final
+    __atomic_store_n(&ring->prod.p.closed, 1, __ATOMIC_RELEASE);
+}
+
+/* Lot maximal aligné sur la fenêtre MWI, borné à la capacité (un anneau plein doit toujours pouvoir être vidé). */
+static void batch_sizes(const ECG_Ring *ring, const ECG_Context *ctx, size_t max_batch, size_t *win, size_t *batch) {
+    const size_t capacity = ring->shared.s.mask + 1;
+    size_t w = ecg_mwi_window(ctx) ? ecg_mwi_window(ctx) : 1;
+    if (w > capacity) w = capacity;
+    size_t b = max_batch ? max_batch : DEFAULT_BATCH_WINDOWS * w;
+    if (b > capacity) b = capacity;
+    b -= b % w;
+    *win = w;
+    *batch = b ? b : w;
+}
+
+ECG_Status ecg_ring_poll(ECG_Ring *ring, ECG_Context *ctx, size_t max_batch, ECG_Peaks *peaks,
+                         ECG_Intervals *intervals, ECG_Ring_Sink sink, void *user, size_t *consumed) {
+    if (consumed) *consumed = 0;
+    if (!ring || !ctx || !peaks || !intervals || !sink || !consumed) return ECG_ERR_NULL;
+
+    // Lots multiples de la fenêtre MWI : chaque ecg_push avance la MWI d'un nombre entier de fenêtres
+    size_t win, batch;
+    batch_sizes(ring, ctx, max_batch, &win, &batch);
+
+    // closed avant head : si le flux est fermé, le head lu ensuite est le dernier
+    Ring_Consumer *c = &ring->cons.c;
+    const int closed = __atomic_load_n(&ring->prod.p.closed, __ATOMIC_ACQUIRE);
+    const size_t head = __atomic_load_n(&ring->prod.p.head, __ATOMIC_ACQUIRE);
+    const size_t available = head - c->tail;
+    if (available > c->high_water) __atomic_store_n(&c->high_water, available, __ATOMIC_RELAXED);
+
+    size_t n = (available < batch) ? available : batch;
+    if (!closed) n -= n % win;
+    if (n == 0) return ECG_OK;
+
+    const ECG_Status status = push_batch(ring, ctx, c->tail, n, peaks, intervals, sink, user);
+    if (status != ECG_OK) return status;
+    // Place rendue au producteur une fois le lot analysé
+    __atomic_store_n(&c->tail, c->tail + n, __ATOMIC_RELEASE);
+    COUNTER_ADD(c->consumed, n);
+    COUNTER_ADD(c->batches, 1);
+    *consumed = n;
+    return ECG_OK;
+}
+
+size_t ecg_ring_available(const ECG_Ring *ring) {
+    if (!ring) return 0;
+    return __atomic_load_n(&ring->prod.p.head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->cons.c.tail, __ATOMIC_RELAXED);
+}
+
+int ecg_ring_finished(const ECG_Ring *ring) {
+    if (!ring) return 1;
+    const int closed = __atomic_load_n(&ring->prod.p.closed, __ATOMIC_ACQUIRE);
+    return closed && ecg_ring_available(ring) == 0;
+}
+
+void ecg_ring_reset(ECG_Ring *ring) {
+    if (!ring) return;
+    double *data = ring->shared.s.data;
+    const size_t mask = ring->shared.s.mask;
+    // Écritures non atomiques : publiées au thread suivant par la synchronisation qui rouvre le flux
+    memset(ring, 0, sizeof(*ring));
+    ring->shared.s.data = data;
+    ring->shared.s.mask = mask;
+}
+
+ECG_Status ecg_ring_consume(ECG_Ring *ring, ECG_Context *ctx, size_t max_batch, ECG_Ring_Sink sink, void *user) {
+    if (!ring || !ctx || !sink) return ECG_ERR_NULL;
+
+    ECG_Peaks peaks;
+    ECG_Intervals intervals;
+    if (ecg_peaks_init(&peaks, 0) != 0 || ecg_intervals_init(&intervals, 0) != 0) {
+        ecg_peaks_free(&peaks);
+        ecg_intervals_free(&intervals);
+        return ECG_ERR_ALLOC;
+    }
+
+    ECG_Status status = ECG_OK;
+    for (;;) {
+        size_t n = 0;
+        status = ecg_ring_poll(ring, ctx, max_batch, &peaks, &intervals, sink, user, &n);
+        if (status != ECG_OK || (n == 0 && ecg_ring_finished(ring))) break;
+        if (n == 0) sched_yield();
+    }
+
+    if (status == ECG_OK) status = ecg_flush(ctx, &peaks, &intervals);
+    if (status == ECG_OK && (peaks.R_count > 0 || intervals.count > 0)) status = sink(user, &peaks, &intervals);
+
+    ecg_peaks_free(&peaks);
+    ecg_intervals_free(&intervals);
+    return status;
+}
+
+ECG_Status ecg_ring_get_counters(const ECG_Ring *ring, ECG_Ring_Counters *counters) {
+    if (!ring || !counters) return ECG_ERR_NULL;
+    counters->written = __atomic_load_n(&ring->prod.p.written, __ATOMIC_RELAXED);
+    counters->dropped = __atomic_load_n(&ring->prod.p.dropped, __ATOMIC_RELAXED);
+    counters->overruns = __atomic_load_n(&ring->prod.p.overruns, __ATOMIC_RELAXED);
+    counters->consumed = __atomic_load_n(&ring->cons.c.consumed, __ATOMIC_RELAXED);
+    counters->batches = __atomic_load_n(&ring->cons.c.batches, __ATOMIC_RELAXED);
+    counters->high_water = __atomic_load_n(&ring->cons.c.high_water, __ATOMIC_RELAXED);
+    return ECG_OK;
+}
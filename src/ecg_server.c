@@ -0,0 +1,515 @@
+/**
+ * @file    ecg_server.c
+ * @brief   Mode serveur : flux patients en streaming, workers à propriétaires et vol de travail.
+ *
+ * Découpage :
+ * 1. Un flux = anneau SPSC + contexte du pool + buffers de résultats, sur ses propres lignes de cache
+ *    (partie producteur : horodatage des paquets ; partie worker : état d'analyse et statistiques).
+ * 2. Chaque worker parcourt les flux dont il est propriétaire et analyse au plus un lot par flux et
+ *    par tour (ecg_ring_poll) : pas de file commune, un flux lent ne monopolise pas son worker.
+ * 3. Un worker sans travail choisit le worker le plus chargé (retard cumulé de ses flux) et lui prend
+ *    son flux le plus en retard par compare-and-swap du propriétaire.
+ *    Le drapeau busy du flux garantit un seul analyseur à la fois, même pendant une migration.
+ */
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "ecg_server.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ===============================================================================
+ * Constantes
+ * =============================================================================== */
+
+// Taille d'une ligne de cache
+#define SERVER_LINE 64
+#define LINE_ROUND(n) (((n) + SERVER_LINE - 1) / SERVER_LINE * SERVER_LINE)
+
+#define DEFAULT_MAX_STREAMS 256
+#define DEFAULT_RING_MS     2000
+#define DEFAULT_BATCH_WINDOWS 8   // comme ecg_ring_consume
+
+// Horodatages de paquets conservés par flux (puissance de deux) : au-delà, la latence est sous-estimée
+#define STAMP_COUNT 64
+
+// Pas de vol si le worker le plus chargé a moins de 2 lots en retard : la migration coûterait plus qu'elle ne rapporte
+#define STEAL_MIN_BATCHES 2
+
+// Worker inactif : quelques tours à sched_yield, puis des pauses de 100 µs (pas de cœur brûlé à vide)
+#define IDLE_SPINS      64
+#define IDLE_SLEEP_NS   100000
+
+/* ===============================================================================
+ * Structures internes
+ * =============================================================================== */
+
+typedef enum {
+    STREAM_FREE = 0,            // emplacement libre (ou flux terminé, statistiques lisibles)
+    STREAM_OPEN,                // flux alimenté par son producteur
+    STREAM_CLOSING              // fermé par le producteur, en cours de vidage
+} Stream_State;
+
+// Côté worker : écrit uniquement par le worker qui tient busy
+typedef struct {
+    ECG_Ring *ring;
+    ECG_Context *ctx;
+    ECG_Ring_Sink sink;
+    void *user;
+    int state;                  // Stream_State (atomique)
+    int owner;                  // worker propriétaire (atomique, échangé par les voleurs)
+    unsigned char busy;         // analyse en cours (test-and-set)
+    uint64_t migrations;        // (atomique, incrémenté par les voleurs)
+
+    ECG_Peaks peaks;            // buffers de travail de ecg_ring_poll
+    ECG_Intervals intervals;
+    uint64_t analyzed;          // échantillons analysés depuis l'ouverture
+    uint64_t stamp_read;        // premier paquet dont tous les échantillons ne sont pas analysés
+    ECG_Server_Stream_Stats stats;
+} Stream_Core;
+
+// Côté producteur : fin (en échantillons cumulés) et instant de chaque paquet écrit
+typedef struct {
+    uint64_t end;
+    uint64_t ns;
+} Feed_Stamp;
+
+typedef struct {
+    uint64_t fed;               // échantillons acceptés depuis l'ouverture
+    uint64_t feeds;             // paquets horodatés (publié RELEASE après l'horodatage)
+    Feed_Stamp stamps[STAMP_COUNT];
+} Stream_Feed;
+
+typedef struct {
+    union { Stream_Core c; unsigned char line[LINE_ROUND(sizeof(Stream_Core))]; } core;
+    union { Stream_Feed f; unsigned char line[LINE_ROUND(sizeof(Stream_Feed))]; } feed;
+} Server_Stream;
+
+typedef struct {
+    ECG_Server *server;
+    int id;
+    uint64_t load;              // retard cumulé de ses flux au dernier tour (atomique)
+    uint64_t steals;
+    pthread_t thread;
+} Worker_Core;
+
+typedef union {
+    Worker_Core w;
+    unsigned char line[LINE_ROUND(sizeof(Worker_Core))];
+} Server_Worker;
+
+struct ECG_Server {
+    ECG_Params params;
+    ECG_Pool *pool;
+    int max_streams;
+    int n_workers;
+    size_t batch;
+    size_t ring_capacity;
+    int pin_workers;
+
+    Server_Stream *streams;
+    Server_Worker *workers;
+
+    unsigned char open_lock;    // ecg_server_open (rare)
+    int next_owner;             // propriétaire des nouveaux flux (tourniquet, sous open_lock)
+    int closing;                // flux fermés pas encore vidés (atomique)
+    int stop;                   // (atomique)
+    int started;
+};
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void spin_lock(unsigned char *lock) {
+    while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+        }
+    }
+}
+
+static void spin_unlock(unsigned char *lock) {
+    __atomic_clear(lock, __ATOMIC_RELEASE);
+}
+
+static Stream_Core *stream_core(ECG_Server *server, int stream) {
+    if (!server || stream < 0 || stream >= server->max_streams) return NULL;
+    return &server->streams[stream].core.c;
+}
+
+/* Statistiques d'un lot : latence = fin d'analyse - écriture du paquet qui contient son premier échantillon. */
+static void account_batch(Server_Stream *s, uint64_t t0, size_t n) {
+    Stream_Core *c = &s->core.c;
+    Stream_Feed *f = &s->feed.f;
+    const uint64_t first = c->analyzed;
+    const uint64_t now = now_ns();
+    c->analyzed += n;
+    c->stats.samples += n;
+    c->stats.batches++;
+    c->stats.service_ns += now - t0;
+
+    const uint64_t feeds = __atomic_load_n(&f->feeds, __ATOMIC_ACQUIRE);
+    if (feeds - c->stamp_read > STAMP_COUNT) c->stamp_read = feeds - STAMP_COUNT; // horodatages écrasés
+    while (c->stamp_read < feeds
+           && __atomic_load_n(&f->stamps[c->stamp_read & (STAMP_COUNT - 1)].end, __ATOMIC_RELAXED) <= first)
+        c->stamp_read++;
+    if (c->stamp_read == feeds) return; // paquet pas encore horodaté : lot sans mesure
+
+    const uint64_t fed_ns = __atomic_load_n(&f->stamps[c->stamp_read & (STAMP_COUNT - 1)].ns, __ATOMIC_RELAXED);
+    const uint64_t latency = (now > fed_ns) ? now - fed_ns : 0;
+    c->stats.latency_last_ns = latency;
+    if (latency > c->stats.latency_max_ns) c->stats.latency_max_ns = latency;
+    c->stats.latency_sum_ns += latency;
+    c->stats.latency_count++;
+}
+
+/* Flux fermé et vidé : dernier pic, contexte rendu au pool, emplacement libéré. */
+static void stream_finish(ECG_Server *server, Stream_Core *c) {
+    ECG_Status status = ecg_flush(c->ctx, &c->peaks, &c->intervals);
+    if (status == ECG_OK && (c->peaks.R_count > 0 || c->intervals.count > 0))
+        status = c->sink(c->user, &c->peaks, &c->intervals);
+    if (status != ECG_OK && c->stats.status == ECG_OK) c->stats.status = status;
+    ecg_get_hrv(c->ctx, &c->stats.hrv);
+
+    ECG_Ring_Counters counters;
+    ecg_ring_get_counters(c->ring, &counters);
+    c->stats.dropped = counters.dropped;
+    c->stats.open = 0;
+
+    ecg_pool_release(server->pool, c->ctx);
+    c->ctx = NULL;
+    __atomic_store_n(&c->state, STREAM_FREE, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&server->closing, 1, __ATOMIC_RELEASE);
+}
+
+/* Au plus un lot du flux. Retourne le nombre d'échantillons analysés (1 pour une fermeture). */
+static size_t stream_service(ECG_Server *server, Server_Stream *s, uint64_t *load) {
+    Stream_Core *c = &s->core.c;
+    if (__atomic_test_and_set(&c->busy, __ATOMIC_ACQUIRE)) return 0; // analysé par l'ancien propriétaire
+
+    size_t n = 0;
+    const int state = __atomic_load_n(&c->state, __ATOMIC_ACQUIRE);
+    if (state != STREAM_FREE) {
+        const uint64_t t0 = now_ns();
+        const ECG_Status status = ecg_ring_poll(c->ring, c->ctx, server->batch, &c->peaks, &c->intervals,
+                                                c->sink, c->user, &n);
+        if (status != ECG_OK && c->stats.status == ECG_OK) c->stats.status = status;
+        if (n > 0) {
+            account_batch(s, t0, n);
+            ecg_get_hrv(c->ctx, &c->stats.hrv);
+        }
+
+        if (state == STREAM_CLOSING && n == 0 && ecg_ring_finished(c->ring)) {
+            stream_finish(server, c);
+            n = 1;
+        } else {
+            *load += ecg_ring_available(c->ring);
+        }
+    }
+
+    __atomic_clear(&c->busy, __ATOMIC_RELEASE);
+    return n;
+}
+
+/*
+ * Vol : le flux le plus en retard du worker le plus chargé, si ce worker a au moins deux flux en retard
+ * (déplacer son seul flux ne ferait que déplacer le problème).
+ */
+static int steal(ECG_Server *server, int thief) {
+    int victim = -1;
+    uint64_t most = 0;
+    for (int w = 0; w < server->n_workers; w++) {
+        const uint64_t load = __atomic_load_n(&server->workers[w].w.load, __ATOMIC_RELAXED);
+        if (w != thief && load > most) {
+            most = load;
+            victim = w;
+        }
+    }
+    size_t min_backlog = STEAL_MIN_BATCHES * server->batch;
+    if (min_backlog > server->ring_capacity / 2) min_backlog = server->ring_capacity / 2; // anneaux plus petits que 2 lots
+    if (victim < 0 || most < min_backlog) return 0;
+
+    int best = -1, backlogged = 0;
+    size_t best_backlog = 0;
+    for (int i = 0; i < server->max_streams; i++) {
+        Stream_Core *c = &server->streams[i].core.c;
+        if (__atomic_load_n(&c->owner, __ATOMIC_RELAXED) != victim
+            || __atomic_load_n(&c->state, __ATOMIC_ACQUIRE) == STREAM_FREE) continue;
+        // Flux en retard d'au moins deux lots : un flux à jour changerait de cœur sans rien y gagner
+        const size_t backlog = ecg_ring_available(c->ring);
+        if (backlog < min_backlog) continue;
+        backlogged++;
+        if (backlog > best_backlog) {
+            best_backlog = backlog;
+            best = i;
+        }
+    }
+    if (backlogged < 2) return 0;
+
+    Stream_Core *c = &server->streams[best].core.c;
+    int expected = victim;
+    if (!__atomic_compare_exchange_n(&c->owner, &expected, thief, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return 0;
+    __atomic_fetch_add(&c->migrations, 1, __ATOMIC_RELAXED);
+    Worker_Core *self = &server->workers[thief].w;
+    __atomic_store_n(&self->steals, self->steals + 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+static void *worker_main(void *arg) {
+    Worker_Core *self = arg;
+    ECG_Server *server = self->server;
+
+#ifdef __linux__
+    if (server->pin_workers) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((int)(self->id % (cpus > 0 ? cpus : 1)), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    int idle = 0;
+    for (;;) {
+        uint64_t load = 0;
+        size_t done = 0;
+        for (int i = 0; i < server->max_streams; i++) {
+            Server_Stream *s = &server->streams[i];
+            if (__atomic_load_n(&s->core.c.owner, __ATOMIC_RELAXED) != self->id) continue;
+            done += stream_service(server, s, &load);
+        }
+        __atomic_store_n(&self->load, load, __ATOMIC_RELAXED);
+
+        if (done > 0 || steal(server, self->id)) {
+            idle = 0;
+            continue;
+        }
+        if (__atomic_load_n(&server->stop, __ATOMIC_ACQUIRE) && __atomic_load_n(&server->closing, __ATOMIC_ACQUIRE) == 0)
+            break;
+        if (++idle < IDLE_SPINS) {
+            sched_yield();
+        } else {
+            const struct timespec pause = { 0, IDLE_SLEEP_NS };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+ECG_Server *ecg_server_create(const ECG_Params *params, const ECG_Server_Options *opt) {
+    if (!params || params->sampling_rate_hz <= 0) return NULL;
+    // Flux uniquement : pas de filtre aller-retour
+    if (params->filter == ECG_FILTER_BANDPASS_ZERO_PHASE) return NULL;
+
+    ECG_Server_Options o;
+    memset(&o, 0, sizeof(o));
+    if (opt) o = *opt;
+    if (o.workers < 0 || o.max_streams < 0) return NULL;
+    if (o.workers == 0) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        o.workers = (cpus > 0) ? (int)cpus : 1;
+    }
+    if (o.max_streams == 0) o.max_streams = DEFAULT_MAX_STREAMS;
+    if (o.ring_capacity == 0) o.ring_capacity = (size_t)(((long)DEFAULT_RING_MS * params->sampling_rate_hz) / 1000);
+
+    ECG_Server *server = calloc(1, sizeof(ECG_Server));
+    if (!server) return NULL;
+    server->params = *params;
+    server->params.max_samples = 1; // ecg_push uniquement : buffers de l'analyse globale inutiles
+    server->params.delineate = 0;
+    server->max_streams = o.max_streams;
+    server->n_workers = o.workers;
+    server->batch = o.batch;
+    server->ring_capacity = o.ring_capacity;
+    server->pin_workers = o.pin_workers;
+
+    void *streams = NULL, *workers = NULL;
+    server->pool = ecg_pool_create(&server->params, o.max_streams);
+    if (posix_memalign(&streams, SERVER_LINE, sizeof(Server_Stream) * (size_t)o.max_streams) == 0)
+        server->streams = memset(streams, 0, sizeof(Server_Stream) * (size_t)o.max_streams);
+    if (posix_memalign(&workers, SERVER_LINE, sizeof(Server_Worker) * (size_t)o.workers) == 0)
+        server->workers = memset(workers, 0, sizeof(Server_Worker) * (size_t)o.workers);
+    if (!server->pool || !server->streams || !server->workers) {
+        ecg_server_destroy(server);
+        return NULL;
+    }
+
+    // Lot par défaut : celui de ecg_ring_poll, nécessaire au seuil de vol (fenêtre MWI lue sur un premier contexte)
+    if (server->batch == 0) {
+        ECG_Context *ctx = ecg_pool_acquire(server->pool);
+        if (!ctx) {
+            ecg_server_destroy(server);
+            return NULL;
+        }
+        server->batch = DEFAULT_BATCH_WINDOWS * (ecg_mwi_window(ctx) ? ecg_mwi_window(ctx) : 1);
+        ecg_pool_release(server->pool, ctx);
+    }
+
+    for (int i = 0; i < o.max_streams; i++) {
+        Stream_Core *c = &server->streams[i].core.c;
+        c->ring = ecg_ring_create(o.ring_capacity);
+        if (!c->ring || ecg_peaks_init(&c->peaks, 0) != 0 || ecg_intervals_init(&c->intervals, 0) != 0) {
+            ecg_server_destroy(server);
+            return NULL;
+        }
+    }
+    for (int w = 0; w < o.workers; w++) {
+        server->workers[w].w.server = server;
+        server->workers[w].w.id = w;
+    }
+    return server;
+}
+
+ECG_Status ecg_server_start(ECG_Server *server) {
+    if (!server) return ECG_ERR_NULL;
+    if (server->started) return ECG_ERR_PARAM;
+
+    __atomic_store_n(&server->stop, 0, __ATOMIC_RELEASE);
+    for (int w = 0; w < server->n_workers; w++) {
+        if (pthread_create(&server->workers[w].w.thread, NULL, worker_main, &server->workers[w].w) != 0) {
+            // Arrêt des workers déjà lancés
+            __atomic_store_n(&server->stop, 1, __ATOMIC_RELEASE);
+            for (int k = 0; k < w; k++) pthread_join(server->workers[k].w.thread, NULL);
+            return ECG_ERR_FAIL;
+        }
+    }
+    server->started = 1;
+    return ECG_OK;
+}
+
+int ecg_server_open(ECG_Server *server, ECG_Ring_Sink sink, void *user) {
+    if (!server || !sink) return ECG_ERR_NULL;
+
+    int result = ECG_ERR_PARAM;
+    spin_lock(&server->open_lock);
+    for (int i = 0; i < server->max_streams; i++) {
+        Server_Stream *s = &server->streams[i];
+        Stream_Core *c = &s->core.c;
+        // busy : le worker qui vient de terminer ce flux n'a pas encore rendu la main
+        if (__atomic_load_n(&c->state, __ATOMIC_ACQUIRE) != STREAM_FREE || __atomic_load_n(&c->busy, __ATOMIC_ACQUIRE))
+            continue;
+
+        ECG_Context *ctx = ecg_pool_acquire(server->pool);
+        if (!ctx) {
+            result = ECG_ERR_ALLOC;
+            break;
+        }
+        ecg_ring_reset(c->ring);
+        c->ctx = ctx;
+        c->sink = sink;
+        c->user = user;
+        c->analyzed = 0;
+        c->stamp_read = 0;
+        memset(&c->stats, 0, sizeof(c->stats));
+        c->stats.open = 1;
+        __atomic_store_n(&c->migrations, 0, __ATOMIC_RELAXED);
+        memset(&s->feed.f, 0, sizeof(s->feed.f));
+
+        __atomic_store_n(&c->owner, server->next_owner, __ATOMIC_RELAXED);
+        server->next_owner = (server->next_owner + 1) % server->n_workers;
+        // Publie tout ce qui précède au worker propriétaire
+        __atomic_store_n(&c->state, STREAM_OPEN, __ATOMIC_RELEASE);
+        result = i;
+        break;
+    }
+    spin_unlock(&server->open_lock);
+    return result;
+}
+
+size_t ecg_server_feed(ECG_Server *server, int stream, const double *samples, size_t n) {
+    Stream_Core *c = stream_core(server, stream);
+    if (!c || __atomic_load_n(&c->state, __ATOMIC_ACQUIRE) != STREAM_OPEN) return 0;
+
+    const uint64_t t = now_ns();
+    const size_t written = ecg_ring_write(c->ring, samples, n);
+    if (written > 0) {
+        // Horodatage publié après les échantillons : un lot analysé avant reste sans mesure
+        Stream_Feed *f = &server->streams[stream].feed.f;
+        Feed_Stamp *stamp = &f->stamps[f->feeds & (STAMP_COUNT - 1)];
+        f->fed += written;
+        __atomic_store_n(&stamp->end, f->fed, __ATOMIC_RELAXED);
+        __atomic_store_n(&stamp->ns, t, __ATOMIC_RELAXED);
+        __atomic_store_n(&f->feeds, f->feeds + 1, __ATOMIC_RELEASE);
+    }
+    return written;
+}
+
+size_t ecg_server_feed_space(ECG_Server *server, int stream) {
+    Stream_Core *c = stream_core(server, stream);
+    return c ? ecg_ring_write_space(c->ring) : 0;
+}
+
+ECG_Status ecg_server_close(ECG_Server *server, int stream) {
+    Stream_Core *c = stream_core(server, stream);
+    if (!c) return server ? ECG_ERR_PARAM : ECG_ERR_NULL;
+
+    int expected = STREAM_OPEN;
+    __atomic_fetch_add(&server->closing, 1, __ATOMIC_ACQ_REL);
+    if (!__atomic_compare_exchange_n(&c->state, &expected, STREAM_CLOSING, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        __atomic_fetch_sub(&server->closing, 1, __ATOMIC_RELEASE);
+        return ECG_ERR_PARAM;
+    }
+    ecg_ring_close(c->ring);
+    return ECG_OK;
+}
+
+ECG_Status ecg_server_stop(ECG_Server *server) {
+    if (!server) return ECG_ERR_NULL;
+    if (!server->started) return ECG_OK;
+
+    __atomic_store_n(&server->stop, 1, __ATOMIC_RELEASE);
+    for (int w = 0; w < server->n_workers; w++) pthread_join(server->workers[w].w.thread, NULL);
+    server->started = 0;
+    return ECG_OK;
+}
+
+ECG_Status ecg_server_get_stream_stats(ECG_Server *server, int stream, ECG_Server_Stream_Stats *stats) {
+    Stream_Core *c = stream_core(server, stream);
+    if (!server || !stats) return ECG_ERR_NULL;
+    if (!c) return ECG_ERR_PARAM;
+
+    // Copie cohérente : le worker ne modifie les statistiques que sous busy
+    spin_lock(&c->busy);
+    *stats = c->stats;
+    if (stats->open) {
+        ECG_Ring_Counters counters;
+        ecg_ring_get_counters(c->ring, &counters);
+        stats->dropped = counters.dropped;
+    }
+    spin_unlock(&c->busy);
+    stats->worker = __atomic_load_n(&c->owner, __ATOMIC_RELAXED);
+    stats->migrations = __atomic_load_n(&c->migrations, __ATOMIC_RELAXED);
+    return ECG_OK;
+}
+
+void ecg_server_destroy(ECG_Server *server) {
+    if (!server) return;
+    ecg_server_stop(server);
+
+    if (server->streams) {
+        for (int i = 0; i < server->max_streams; i++) {
+            Stream_Core *c = &server->streams[i].core.c;
+            ecg_destroy(c->ctx); // flux jamais fermés
+            ecg_ring_destroy(c->ring);
+            ecg_peaks_free(&c->peaks);
+            ecg_intervals_free(&c->intervals);
+        }
+    }
+    ecg_pool_destroy(server->pool);
+    free(server->streams);
+    free(server->workers);
+    free(server);
+}
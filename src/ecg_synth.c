@@ -0,0 +1,238 @@
+/**
+ * @file    ecg_synth.c
+ * @brief   Générateur d'ECG synthétique (modèle de type ECGSYN) avec vérité terrain.
+ *
+ */
+#include "ecg_synth.h"
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+/* ===============================================================================
+ * Constantes du modèle
+ * =============================================================================== */
+
+/*
+ * Ondes P, Q, R, S, T d'ECGSYN : position en phase θ_i, coefficient a_i et largeur b_i.
+ * La solution du modèle dynamique sur le cycle limite est z(θ) = Σ a_i b_i² exp(-(θ - θ_i)² / 2b_i²).
+ */
+#define SYNTH_WAVES 5
+enum { WAVE_P = 0, WAVE_Q, WAVE_R, WAVE_S, WAVE_T };
+
+static const double wave_theta[SYNTH_WAVES] = { -M_PI / 3.0, -M_PI / 12.0, 0.0, M_PI / 12.0, M_PI / 2.0 };
+static const double wave_a[SYNTH_WAVES]     = { 1.2, -5.0, 30.0, -7.5, 0.75 };
+static const double wave_b[SYNTH_WAVES]     = { 0.25, 0.1, 0.1, 0.1, 0.4 };
+
+/* Au-delà de 6 largeurs, la gaussienne est < 1e-7 : pas d'exp() calculée. */
+#define WAVE_SUPPORT 6.0
+
+/* Tachogramme : composantes de Mayer (LF) et respiratoire (HF), rapport de puissance LF/HF d'ECGSYN. */
+#define HRV_LF_HZ       0.1
+#define HRV_HF_HZ       0.25
+#define HRV_LF_HF_RATIO 0.5
+#define HRV_WHITE_PART  0.1     // part de variance non périodique
+
+/* Bornes physiologiques des intervalles RR (30..240 bpm). */
+#define RR_MIN_S (60.0 / 240.0)
+#define RR_MAX_S (60.0 / 30.0)
+
+/*
+ * Gains (P, QRS, T) des dérivations I et II ; les autres dérivations des membres en découlent par les
+ * relations d'Einthoven et de Goldberger, les précordiales ont leurs propres gains (V1 négative, V4 maximale).
+ */
+static const double gain_I[3]  = { 0.5, 0.6, 0.4 };
+static const double gain_II[3] = { 1.0, 1.0, 1.0 };
+static const double gain_V[6][3] = {
+    { 0.5, -0.6, -0.2 },
+    { 0.4, -0.3,  0.6 },
+    { 0.3,  0.5,  0.8 },
+    { 0.3,  1.3,  0.9 },
+    { 0.3,  1.1,  0.7 },
+    { 0.3,  0.8,  0.5 },
+};
+
+/* ===============================================================================
+ * Helpers (internes)
+ * =============================================================================== */
+
+/* splitmix64 : état local, pas de rand() global. */
+static uint64_t rng_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Uniforme dans ]0, 1]. */
+static double rng_uniform(uint64_t *state) {
+    return ((double)(rng_next(state) >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+}
+
+/* Normale centrée réduite (Box-Muller, la seconde valeur est gardée pour l'appel suivant). */
+typedef struct {
+    uint64_t state;
+    double spare;
+    int has_spare;
+} Synth_Rng;
+
+static double rng_gauss(Synth_Rng *r) {
+    if (r->has_spare) {
+        r->has_spare = 0;
+        return r->spare;
+    }
+    const double radius = sqrt(-2.0 * log(rng_uniform(&r->state)));
+    const double angle = 2.0 * M_PI * rng_uniform(&r->state);
+    r->spare = radius * sin(angle);
+    r->has_spare = 1;
+    return radius * cos(angle);
+}
+
+/* Gains (P, QRS, T) de la dérivation lead (ordre I, II, III, aVR, aVL, aVF, V1..V6). */
+static void lead_gains(int lead, double g[3]) {
+    for (int k = 0; k < 3; k++) {
+        const double I = gain_I[k], II = gain_II[k], III = II - I;
+        switch (lead) {
+            case 0:  g[k] = I; break;
+            case 1:  g[k] = II; break;
+            case 2:  g[k] = III; break;
+            case 3:  g[k] = -(I + II) / 2.0; break;   // aVR
+            case 4:  g[k] = (I - III) / 2.0; break;   // aVL
+            case 5:  g[k] = (II + III) / 2.0; break;  // aVF
+            default: g[k] = gain_V[lead - 6][k]; break;
+        }
+    }
+}
+
+static int params_valid(const ECG_Synth_Params *p) {
+    return p->sampling_rate_hz > 0 && p->leads >= 1 && p->leads <= LEADS
+        && p->samples >= 1 && p->samples <= (size_t)INT_MAX
+        && p->heart_rate_bpm >= 30.0 && p->heart_rate_bpm <= 240.0
+        && p->hrv_std_s >= 0.0 && p->noise_std >= 0.0 && p->baseline_wander >= 0.0
+        && p->wander_hz >= 0.0 && p->amplitude > 0.0;
+}
+
+/* ===============================================================================
+ * API
+ * =============================================================================== */
+
+void ecg_synth_defaults(ECG_Synth_Params *params) {
+    if (!params) return;
+    params->sampling_rate_hz = SAMPLING_RATE;
+    params->leads = LEADS;
+    params->samples = (size_t)60 * SAMPLING_RATE;
+    params->heart_rate_bpm = 75.0;
+    params->hrv_std_s = 0.05;
+    params->noise_std = 0.01;
+    params->baseline_wander = 0.1;
+    params->wander_hz = 0.3;
+    params->amplitude = 1.0;
+    params->seed = 0x5EED;
+}
+
+int ecg_synth_generate(const ECG_Synth_Params *params, ECG_Record *rec, ECG_Peaks *truth) {
+    if (!params || !rec) return -1;
+    if (!params_valid(params)) return -2;
+
+    const int fs = params->sampling_rate_hz;
+    const int n = (int)params->samples;
+    const int leads = params->leads;
+
+    ecg_record_unmap(rec);
+    for (int lead = 0; lead < leads; lead++)
+        if (ecg_record_reserve(rec, lead, (size_t)n) != 0) return -3;
+    if (truth) truth->R_count = truth->P_count = truth->Q_count = truth->S_count = truth->T_count = 0;
+
+    // Adaptation des ondes à la fréquence cardiaque (ECGSYN) : largeurs x sqrt(hr/60), positions P/T
+    // rapprochées de R en x (hr/60)^(1/4), Q/S en x sqrt(hr/60)
+    const double hr_fact = sqrt(params->heart_rate_bpm / 60.0);
+    const double hr_fact2 = sqrt(hr_fact);
+    const double theta_scale[SYNTH_WAVES] = { hr_fact2, hr_fact, 1.0, hr_fact, hr_fact2 };
+    double theta[SYNTH_WAVES], coef[SYNTH_WAVES], inv_2b2[SYNTH_WAVES], support[SYNTH_WAVES];
+    for (int w = 0; w < SYNTH_WAVES; w++) {
+        const double b = wave_b[w] * hr_fact;
+        theta[w] = wave_theta[w] * theta_scale[w];
+        coef[w] = wave_a[w] * b * b;
+        inv_2b2[w] = 1.0 / (2.0 * b * b);
+        support[w] = WAVE_SUPPORT * b;
+    }
+
+    // Normalisation : sommet R de la dérivation II à params->amplitude
+    double z_r = 0.0;
+    for (int w = 0; w < SYNTH_WAVES; w++) z_r += coef[w] * exp(-theta[w] * theta[w] * inv_2b2[w]);
+    const double scale = params->amplitude / z_r;
+
+    double gains[LEADS][3], wander_phase[LEADS];
+    Synth_Rng rng = { params->seed, 0.0, 0 };
+    for (int lead = 0; lead < leads; lead++) {
+        lead_gains(lead, gains[lead]);
+        for (int k = 0; k < 3; k++) gains[lead][k] *= scale;
+        wander_phase[lead] = 2.0 * M_PI * rng_uniform(&rng.state);
+    }
+
+    // Tachogramme : variance répartie entre LF, HF (rapport LF/HF) et une part blanche
+    const double rr_mean = 60.0 / params->heart_rate_bpm;
+    const double var = params->hrv_std_s * params->hrv_std_s;
+    const double amp_lf = sqrt(2.0 * var * (1.0 - HRV_WHITE_PART) * HRV_LF_HF_RATIO / (1.0 + HRV_LF_HF_RATIO));
+    const double amp_hf = sqrt(2.0 * var * (1.0 - HRV_WHITE_PART) / (1.0 + HRV_LF_HF_RATIO));
+    const double std_white = sqrt(var * HRV_WHITE_PART);
+    const double phase_lf = 2.0 * M_PI * rng_uniform(&rng.state);
+    const double phase_hf = 2.0 * M_PI * rng_uniform(&rng.state);
+
+    const double inv_fs = 1.0 / (double)fs;
+    const double wander_w = 2.0 * M_PI * params->wander_hz * inv_fs;
+    double beat_start = 0.0;
+    int i = 0;
+
+    while (i < n) {
+        double rr = rr_mean + amp_lf * sin(2.0 * M_PI * HRV_LF_HZ * beat_start + phase_lf)
+                            + amp_hf * sin(2.0 * M_PI * HRV_HF_HZ * beat_start + phase_hf)
+                            + std_white * rng_gauss(&rng);
+        if (rr < RR_MIN_S) rr = RR_MIN_S;
+        if (rr > RR_MAX_S) rr = RR_MAX_S;
+
+        // Battement [beat_start, beat_start + rr[ : θ = -π + 2π (t - beat_start) / rr
+        const double beat_end = beat_start + rr;
+        int end = (int)ceil(beat_end * fs);
+        if (end > n) end = n;
+
+        // Vérité terrain : sommets du modèle, battements entièrement contenus dans le signal
+        if (truth && beat_end * fs <= (double)n) {
+            if (ecg_peaks_reserve(truth, truth->R_count + 1) != 0) return -3;
+            int idx[SYNTH_WAVES];
+            for (int w = 0; w < SYNTH_WAVES; w++)
+                idx[w] = (int)lround((beat_start + rr * (theta[w] + M_PI) / (2.0 * M_PI)) * fs);
+            truth->P[truth->P_count++] = idx[WAVE_P];
+            truth->Q[truth->Q_count++] = idx[WAVE_Q];
+            truth->R[truth->R_count++] = idx[WAVE_R];
+            truth->S[truth->S_count++] = idx[WAVE_S];
+            truth->T[truth->T_count++] = idx[WAVE_T];
+        }
+
+        // HPC : 5 gaussiennes par échantillon (souvent aucune : support borné), partagées par toutes
+        // les dérivations, qui ne sont plus que 3 produits + dérive + bruit
+        for (; i < end; i++) {
+            const double th = -M_PI + ((double)i * inv_fs - beat_start) * (2.0 * M_PI / rr);
+            double z[SYNTH_WAVES];
+            for (int w = 0; w < SYNTH_WAVES; w++) {
+                const double d = th - theta[w];
+                z[w] = (fabs(d) < support[w]) ? coef[w] * exp(-d * d * inv_2b2[w]) : 0.0;
+            }
+            const double p = z[WAVE_P], qrs = z[WAVE_Q] + z[WAVE_R] + z[WAVE_S], t = z[WAVE_T];
+
+            for (int lead = 0; lead < leads; lead++) {
+                const double *g = gains[lead];
+                double v = g[0] * p + g[1] * qrs + g[2] * t;
+                if (params->baseline_wander > 0.0) v += params->baseline_wander * sin(wander_w * i + wander_phase[lead]);
+                if (params->noise_std > 0.0) v += params->noise_std * rng_gauss(&rng);
+                rec->data[lead][i] = v;
+            }
+        }
+        beat_start = beat_end;
+    }
+
+    rec->leads = leads;
+    rec->samples = n;
+    rec->sampling_rate_hz = fs;
+    return 0;
+}
@@ -10,9 +10,22 @@
  */
 
 #include "ecg_utils.h"
+#include "ecg_kernels.h"
 
+#include <complex.h>
+#include <math.h>
 #include <stddef.h>
 
+/* ================================
+ * Constantes
+ * ================================ */
+
+/* Bloc de la cascade de biquads : 256 doubles = 2 KB, le bloc reste en L1 d'une section à l'autre */
+#define BIQUAD_BLOCK 256
+
+/* Partie imaginaire en dessous de laquelle un pôle est considéré réel */
+#define POLE_IMAG_EPS 1e-12
+
 /* ================================
  * Helpers (internes)
  * ================================ */
@@ -28,6 +41,111 @@ static double ecg_mean(const double *x, size_t n)
     return sum / (double)n;
 }
 
+/*
+ * Une section sur len échantillons, forme directe II transposée (2 retards, 5 multiplications).
+ * step = +1 : aller, step = -1 : retour (in et out pointent sur le dernier échantillon).
+ */
+static void biquad_run(const ECG_Biquad *c, ECG_Biquad_State *st, const double *in, double *out,
+                       size_t len, ptrdiff_t step)
+{
+    const double b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+    double z1 = st->z1, z2 = st->z2;
+    for (size_t i = 0; i < len; ++i) {
+        const double v = *in;
+        const double o = b0 * v + z1;
+        z1 = b1 * v - a1 * o + z2;
+        z2 = b2 * v - a2 * o;
+        *out = o;
+        in += step;
+        out += step;
+    }
+    st->z1 = z1;
+    st->z2 = z2;
+}
+
+/* Cascade complète bloc par bloc, dans le sens du temps ou à rebours. */
+static void biquad_cascade_dir(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                               const double *x, double *y, size_t n, int reverse)
+{
+    for (size_t done = 0; done < n; done += BIQUAD_BLOCK) {
+        const size_t len = (n - done < BIQUAD_BLOCK) ? n - done : BIQUAD_BLOCK;
+        const size_t first = reverse ? n - 1 - done : done;
+        const ptrdiff_t step = reverse ? -1 : 1;
+
+        /* Section 0 : x -> y, sections suivantes en place sur le bloc de y */
+        const double *in = x + first;
+        for (int s = 0; s < n_sections; ++s) {
+            biquad_run(&sections[s], &state[s], in, y + first, len, step);
+            in = y + first;
+        }
+    }
+}
+
+/* Régime établi de la dérivation l : state[s * stride] pour chaque section s. */
+static void biquad_steady_strided(const ECG_Biquad *sections, int n_sections, double x0,
+                                  ECG_Biquad_State *state, size_t stride)
+{
+    double u = x0;
+    for (int s = 0; s < n_sections; ++s) {
+        const ECG_Biquad *c = &sections[s];
+        const double den = 1.0 + c->a1 + c->a2;
+        const double y = (den != 0.0) ? u * (c->b0 + c->b1 + c->b2) / den : 0.0;
+        state[(size_t)s * stride].z1 = y - c->b0 * u;
+        state[(size_t)s * stride].z2 = c->b2 * u - c->a2 * y;
+        u = y;
+    }
+}
+
+/* Cascade entrelacée, un pas de temps par ligne ; reverse : de la dernière ligne à la première. */
+static void biquad_cascade_leads_dir(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                                     const double *x, double *y, size_t n, size_t n_leads, int reverse)
+{
+    for (size_t k = 0; k < n; ++k) {
+        const size_t t = reverse ? n - 1 - k : k;
+        const double *in = x + t * n_leads;
+        double *out = y + t * n_leads;
+        for (int s = 0; s < n_sections; ++s) {
+            const double b0 = sections[s].b0, b1 = sections[s].b1, b2 = sections[s].b2;
+            const double a1 = sections[s].a1, a2 = sections[s].a2;
+            ECG_Biquad_State *st = state + (size_t)s * n_leads;
+            /* Dérivations indépendantes : boucle vectorisable */
+            for (size_t l = 0; l < n_leads; ++l) {
+                const double v = in[l];
+                const double o = b0 * v + st[l].z1;
+                st[l].z1 = b1 * v - a1 * o + st[l].z2;
+                st[l].z2 = b2 * v - a2 * o;
+                out[l] = o;
+            }
+            in = out;
+        }
+    }
+}
+
+/*
+ * Somme et moment (sum k * x[start + k]) d'un bloc de factor échantillons de la décimation.
+ * Hors du signal, le premier / dernier échantillon est répété (bords du signal seulement).
+ */
+static void decimate_block(const double *x, size_t n, ptrdiff_t start, size_t factor, double *sum, double *moment)
+{
+    double s = 0.0, m = 0.0;
+    if (start >= 0 && (size_t)start + factor <= n) {
+        const double *b = x + start;
+        for (size_t k = 0; k < factor; k++) {
+            s += b[k];
+            m += (double)k * b[k];
+        }
+    } else {
+        for (size_t k = 0; k < factor; k++) {
+            const ptrdiff_t i = start + (ptrdiff_t)k;
+            const double v = x[(i < 0) ? 0 : ((size_t)i >= n ? n - 1 : (size_t)i)];
+            s += v;
+            m += (double)k * v;
+        }
+    }
+    *sum = s;
+    *moment = m;
+}
+
 /* ================================
  * API
  * ================================ */
@@ -136,3 +254,207 @@ void ecg_mwi(const double *x, double *y, size_t n, size_t win)
         y[i] = (w > 0) ? (sum / (double)w) : 0.0;
     }
 }
+
+double ecg_mwi_max(const double *x, double *y, size_t n, size_t win)
+{
+    if (!x || !y || n == 0) return 0.0;
+    if (win == 0) win = 1;
+
+    double sum = 0.0, max = 0.0;
+    size_t w = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i];
+        ++w;
+
+        if (w > win) {
+            sum -= x[i - win];
+            --w;
+        }
+
+        y[i] = (w > 0) ? (sum / (double)w) : 0.0;
+        if (y[i] > max) max = y[i];
+    }
+    return max;
+}
+
+size_t ecg_argmax(const double *x, size_t n)
+{
+    if (!x || n == 0) return 0;
+
+    size_t best = 0;
+    for (size_t i = 1; i < n; ++i) {
+        if (x[i] > x[best]) best = i;
+    }
+    return best;
+}
+
+int ecg_butterworth_bandpass(double fs, double low_hz, double high_hz, int order, ECG_Biquad *sections)
+{
+    if (!sections || fs <= 0.0 || order < 1 || order > ECG_BIQUAD_MAX_SECTIONS) return -1;
+    if (!(low_hz > 0.0 && low_hz < high_hz && high_hz < fs / 2.0)) return -1;
+
+    /* Pré-distorsion : coupures analogiques qui retombent sur low_hz / high_hz après la bilinéaire */
+    const double w1 = 2.0 * fs * tan(M_PI * low_hz / fs);
+    const double w2 = 2.0 * fs * tan(M_PI * high_hz / fs);
+    const double bw = w2 - w1;
+    const double w0_sq = w1 * w2;
+
+    /* Chaque pôle p du prototype donne deux pôles passe-bande, racines de s^2 - p.bw.s + w0^2 */
+    double complex poles[2 * ECG_BIQUAD_MAX_SECTIONS];
+    int n_poles = 0;
+    for (int k = 0; k < order; ++k) {
+        const double complex p = cexp(I * M_PI * (2.0 * k + order + 1) / (2.0 * order));
+        const double complex d = csqrt(p * p * bw * bw - 4.0 * w0_sq);
+        const double complex s_pair[2] = { (p * bw + d) / 2.0, (p * bw - d) / 2.0 };
+        for (int j = 0; j < 2; ++j)
+            poles[n_poles++] = (2.0 * fs + s_pair[j]) / (2.0 * fs - s_pair[j]);
+    }
+
+    /* Une section par paire conjuguée, les pôles réels (bande large) sont appariés entre eux */
+    int n_sections = 0;
+    double real_poles[2 * ECG_BIQUAD_MAX_SECTIONS];
+    int n_real = 0;
+    for (int k = 0; k < n_poles; ++k) {
+        const double re = creal(poles[k]), im = cimag(poles[k]);
+        if (fabs(im) <= POLE_IMAG_EPS) {
+            real_poles[n_real++] = re;
+        } else if (im > 0.0) {
+            sections[n_sections].a1 = -2.0 * re;
+            sections[n_sections].a2 = re * re + im * im;
+            n_sections++;
+        }
+    }
+    for (int k = 0; k + 1 < n_real; k += 2) {
+        sections[n_sections].a1 = -(real_poles[k] + real_poles[k + 1]);
+        sections[n_sections].a2 = real_poles[k] * real_poles[k + 1];
+        n_sections++;
+    }
+    if (n_sections != order) return -1;
+
+    /* Zéros en z = 1 et z = -1 : numérateur 1 - z^-2, gain unité au centre de la bande */
+    const double complex e = cexp(-I * 2.0 * atan(sqrt(w0_sq) / (2.0 * fs)));
+    for (int s = 0; s < n_sections; ++s) {
+        ECG_Biquad *c = &sections[s];
+        const double g = 1.0 / cabs((1.0 - e * e) / (1.0 + c->a1 * e + c->a2 * e * e));
+        c->b0 = g;
+        c->b1 = 0.0;
+        c->b2 = -g;
+    }
+
+    /* Tri par rayon des pôles croissant (a2 = |z|^2) : les sections les plus résonnantes en dernier */
+    for (int s = 1; s < n_sections; ++s) {
+        const ECG_Biquad c = sections[s];
+        int j = s;
+        for (; j > 0 && sections[j - 1].a2 > c.a2; --j) sections[j] = sections[j - 1];
+        sections[j] = c;
+    }
+    return n_sections;
+}
+
+void ecg_biquad_steady_state(const ECG_Biquad *sections, int n_sections, double x0, ECG_Biquad_State *state)
+{
+    if (!sections || !state || n_sections <= 0) return;
+    biquad_steady_strided(sections, n_sections, x0, state, 1);
+}
+
+void ecg_biquad_cascade(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                        const double *x, double *y, size_t n)
+{
+    if (!sections || !state || !x || !y || n == 0 || n_sections <= 0) return;
+    biquad_cascade_dir(sections, n_sections, state, x, y, n, 0);
+}
+
+void ecg_biquad_cascade_leads(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                              const double *x, double *y, size_t n, size_t n_leads)
+{
+    if (!sections || !state || !x || !y || n == 0 || n_leads == 0 || n_sections <= 0) return;
+    biquad_cascade_leads_dir(sections, n_sections, state, x, y, n, n_leads, 0);
+}
+
+void ecg_biquad_zero_phase(const ECG_Biquad *sections, int n_sections, const double *x, double *y, size_t n)
+{
+    if (!sections || !x || !y || n == 0 || n_sections <= 0 || n_sections > ECG_BIQUAD_MAX_SECTIONS) return;
+
+    ECG_Biquad_State state[ECG_BIQUAD_MAX_SECTIONS];
+    biquad_steady_strided(sections, n_sections, x[0], state, 1);
+    biquad_cascade_dir(sections, n_sections, state, x, y, n, 0);
+
+    /* Retour en place sur y : le déphasage de l'aller est compensé */
+    biquad_steady_strided(sections, n_sections, y[n - 1], state, 1);
+    biquad_cascade_dir(sections, n_sections, state, y, y, n, 1);
+}
+
+void ecg_biquad_zero_phase_leads(const ECG_Biquad *sections, int n_sections, ECG_Biquad_State *state,
+                                 const double *x, double *y, size_t n, size_t n_leads)
+{
+    if (!sections || !state || !x || !y || n == 0 || n_leads == 0 || n_sections <= 0) return;
+
+    for (size_t l = 0; l < n_leads; ++l) biquad_steady_strided(sections, n_sections, x[l], state + l, n_leads);
+    biquad_cascade_leads_dir(sections, n_sections, state, x, y, n, n_leads, 0);
+
+    const double *last = y + (n - 1) * n_leads;
+    for (size_t l = 0; l < n_leads; ++l) biquad_steady_strided(sections, n_sections, last[l], state + l, n_leads);
+    biquad_cascade_leads_dir(sections, n_sections, state, y, y, n, n_leads, 1);
+}
+
+size_t ecg_decimate(const double *x, size_t n, size_t factor, double *y)
+{
+    if (!x || !y || n == 0 || factor == 0) return 0;
+
+    /*
+     * Fenêtre triangulaire de 2 x factor - 1 points centrée sur x[j * factor], poids (factor - |t|) / factor^2.
+     * Les deux moitiés sont portées par deux blocs consécutifs de factor échantillons : avec leur somme S et
+     * leur moment M, la moitié gauche vaut M + S (poids 1..factor) et la droite (factor - 1) S - M.
+     * Chaque bloc sert à deux sorties : 2 opérations par échantillon d'entrée.
+     */
+    const size_t n_out = (n + factor - 1) / factor;
+    const double inv = 1.0 / ((double)factor * (double)factor);
+    const double right = (double)factor - 1.0;
+
+    double s_prev, m_prev;
+    decimate_block(x, n, 1 - (ptrdiff_t)factor, factor, &s_prev, &m_prev);
+    for (size_t j = 0; j < n_out; j++) {
+        double s, m;
+        decimate_block(x, n, (ptrdiff_t)(j * factor) + 1, factor, &s, &m);
+        y[j] = (m_prev + s_prev + right * s - m) * inv;
+        s_prev = s;
+        m_prev = m;
+    }
+    return n_out;
+}
+
+/* ================================
+ * Sélection des noyaux (dispatch)
+ * ================================ */
+
+static const ECG_Kernels ecg_kernels_scalar = {
+    "scalar", ECG_ISA_SCALAR,
+    ecg_apply_gain, ecg_remove_dc, ecg_moving_average, ecg_highpass_ma,
+    ecg_derivative_1, ecg_square, ecg_mwi, ecg_mwi_max, ecg_argmax
+};
+
+const ECG_Kernels *ecg_kernels_get(ECG_Isa isa)
+{
+    switch (isa) {
+    case ECG_ISA_AUTO:
+        /* Du plus large au plus étroit */
+        if (ecg_kernels_get(ECG_ISA_AVX512)) return ecg_kernels_get(ECG_ISA_AVX512);
+        if (ecg_kernels_get(ECG_ISA_AVX2)) return ecg_kernels_get(ECG_ISA_AVX2);
+        return &ecg_kernels_scalar;
+
+    case ECG_ISA_SCALAR:
+        return &ecg_kernels_scalar;
+
+#ifdef ECG_HAVE_X86_KERNELS
+    case ECG_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") ? &ecg_kernels_avx2 : NULL;
+
+    case ECG_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") ? &ecg_kernels_avx512 : NULL;
+#endif
+
+    default:
+        return NULL;
+    }
+}
@@ -0,0 +1,371 @@
+/**
+ * @file    ecg_utils_x86.c
+ * @brief   Noyaux AVX2 et AVX-512 des filtres de ecg_utils.
+ * @details Chaque fonction est compilée avec l'attribut target correspondant : le fichier n'a pas
+ *          besoin de -mavx2/-mavx512f, la sélection se fait à l'exécution (ecg_kernels_get).
+ *
+ *          Sommes glissantes : y[i] = S[i] / w avec S[i] = S[i-1] + x[i] - x[i-win].
+ *          Les différences d[i] = x[i] - x[i-win] sont indépendantes, on calcule donc S par somme
+ *          préfixe dans le registre (log2(lanes) décalages + additions) puis on ajoute la retenue
+ *          du vecteur précédent. La dépendance portée par la boucle se réduit à une addition
+ *          par vecteur au lieu de deux par échantillon.
+ *
+ */
+
+#include "ecg_kernels.h"
+
+#ifdef ECG_HAVE_X86_KERNELS
+
+#include <immintrin.h>
+
+/* ================================
+ * Helpers (communs)
+ * ================================ */
+
+/*
+ * Phase de montée de la fenêtre (w < win) : strictement identique à la version scalaire.
+ * Retourne la somme courante à l'indice min(n, win) - 1 ; *max reçoit le maximum de y (si non NULL).
+ */
+static double warmup(const double *x, double *y, size_t n, size_t win, int highpass, double *max)
+{
+    double sum = 0.0, m = 0.0;
+    const size_t end = (n < win) ? n : win;
+
+    for (size_t i = 0; i < end; ++i) {
+        sum += x[i];
+        const double ma = sum / (double)(i + 1);
+        y[i] = highpass ? x[i] - ma : ma;
+        if (y[i] > m) m = y[i];
+    }
+    if (max) *max = m;
+    return sum;
+}
+
+/* Première occurrence de m dans x[start, n) (m est le maximum calculé en vectoriel). */
+static size_t find_first(const double *x, size_t start, size_t n, double m)
+{
+    for (size_t i = start; i < n; ++i)
+        if (x[i] == m) return i;
+    return 0;
+}
+
+/* ================================
+ * AVX2
+ * ================================ */
+
+#define AVX2 __attribute__((target("avx2")))
+
+/* Somme préfixe inclusive de 4 doubles : [a, a+b, a+b+c, a+b+c+d]. */
+AVX2 static inline __m256d prefix4(__m256d v)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1));
+    v = _mm256_add_pd(v, _mm256_blend_pd(_mm256_permute4x64_pd(v, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x3));
+    return v;
+}
+
+/* max_out (peut être NULL) reçoit le maximum de y, accumulé en registre pendant l'écriture. */
+AVX2 static void sliding_avx2(const double *x, double *y, size_t n, size_t win, int highpass, double *max_out)
+{
+    if (!x || !y || n == 0) return;
+    if (win == 0) win = 1;
+
+    double max = 0.0;
+    double sum = warmup(x, y, n, win, highpass, &max);
+    if (n <= win) {
+        if (max_out) *max_out = max;
+        return;
+    }
+
+    const __m256d vwin = _mm256_set1_pd((double)win);
+    __m256d carry = _mm256_set1_pd(sum);
+    __m256d vmax = _mm256_set1_pd(max);
+    size_t i = win;
+
+    for (; i + 4 <= n; i += 4) {
+        const __m256d xi = _mm256_loadu_pd(x + i);
+        const __m256d d = _mm256_sub_pd(xi, _mm256_loadu_pd(x + i - win));
+        const __m256d s = _mm256_add_pd(prefix4(d), carry);
+        carry = _mm256_permute4x64_pd(s, _MM_SHUFFLE(3, 3, 3, 3));
+
+        const __m256d ma = _mm256_div_pd(s, vwin);
+        const __m256d out = highpass ? _mm256_sub_pd(xi, ma) : ma;
+        _mm256_storeu_pd(y + i, out);
+        vmax = _mm256_max_pd(out, vmax); // NaN en premier opérande : ignoré, comme la version scalaire
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, vmax);
+    for (int k = 0; k < 4; ++k)
+        if (lanes[k] > max) max = lanes[k];
+
+    // Reste scalaire, on repart de la retenue
+    sum = _mm256_cvtsd_f64(carry);
+    for (; i < n; ++i) {
+        sum += x[i] - x[i - win];
+        const double ma = sum / (double)win;
+        y[i] = highpass ? x[i] - ma : ma;
+        if (y[i] > max) max = y[i];
+    }
+    if (max_out) *max_out = max;
+}
+
+AVX2 static void apply_gain_avx2(double *x, size_t n, double gain)
+{
+    if (!x || n == 0) return;
+
+    const __m256d g = _mm256_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), g));
+    for (; i < n; ++i) x[i] *= gain;
+}
+
+AVX2 static void remove_dc_avx2(double *x, size_t n)
+{
+    if (!x || n == 0) return;
+
+    // Moyenne : 4 accumulateurs indépendants
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm256_add_pd(acc, _mm256_loadu_pd(x + i));
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; i < n; ++i) sum += x[i];
+
+    const double m = sum / (double)n;
+    const __m256d vm = _mm256_set1_pd(m);
+    for (i = 0; i + 4 <= n; i += 4) _mm256_storeu_pd(x + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), vm));
+    for (; i < n; ++i) x[i] -= m;
+}
+
+AVX2 static void moving_average_avx2(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx2(x, y, n, win, 0, NULL);
+}
+
+AVX2 static void highpass_ma_avx2(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx2(x, y, n, win, 1, NULL);
+}
+
+AVX2 static void mwi_avx2(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx2(x, y, n, win, 0, NULL);
+}
+
+AVX2 static double mwi_max_avx2(const double *x, double *y, size_t n, size_t win)
+{
+    double max = 0.0;
+    sliding_avx2(x, y, n, win, 0, &max);
+    return max;
+}
+
+/* Maximum en vectoriel (sans branche dépendante des données), puis recherche de sa première occurrence. */
+AVX2 static size_t argmax_avx2(const double *x, size_t n)
+{
+    if (!x || n == 0) return 0;
+
+    __m256d vmax = _mm256_set1_pd(x[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vmax = _mm256_max_pd(_mm256_loadu_pd(x + i), vmax);
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, vmax);
+    double m = x[0];
+    for (int k = 0; k < 4; ++k)
+        if (lanes[k] > m) m = lanes[k];
+    for (; i < n; ++i)
+        if (x[i] > m) m = x[i];
+
+    return find_first(x, 0, n, m);
+}
+
+AVX2 static void derivative_1_avx2(const double *x, double *y, size_t n)
+{
+    if (!x || !y || n == 0) return;
+
+    y[0] = 0.0;
+    size_t i = 1;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(y + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(x + i - 1)));
+    for (; i < n; ++i) y[i] = x[i] - x[i - 1];
+}
+
+AVX2 static void square_avx2(const double *x, double *y, size_t n)
+{
+    if (!x || !y || n == 0) return;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d v = _mm256_loadu_pd(x + i);
+        _mm256_storeu_pd(y + i, _mm256_mul_pd(v, v));
+    }
+    for (; i < n; ++i) y[i] = x[i] * x[i];
+}
+
+const ECG_Kernels ecg_kernels_avx2 = {
+    "avx2", ECG_ISA_AVX2,
+    apply_gain_avx2, remove_dc_avx2, moving_average_avx2, highpass_ma_avx2,
+    derivative_1_avx2, square_avx2, mwi_avx2, mwi_max_avx2, argmax_avx2
+};
+
+/* ================================
+ * AVX-512
+ * ================================ */
+
+#define AVX512 __attribute__((target("avx512f")))
+
+/* Somme préfixe inclusive de 8 doubles : décalages de 1, 2 puis 4 lanes (zéros en entrée). */
+AVX512 static inline __m512d prefix8(__m512d v)
+{
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xFE, _mm512_set_epi64(6, 5, 4, 3, 2, 1, 0, 0), v));
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xFC, _mm512_set_epi64(5, 4, 3, 2, 1, 0, 0, 0), v));
+    v = _mm512_add_pd(v, _mm512_maskz_permutexvar_pd(0xF0, _mm512_set_epi64(3, 2, 1, 0, 0, 0, 0, 0), v));
+    return v;
+}
+
+AVX512 static void sliding_avx512(const double *x, double *y, size_t n, size_t win, int highpass, double *max_out)
+{
+    if (!x || !y || n == 0) return;
+    if (win == 0) win = 1;
+
+    double max = 0.0;
+    double sum = warmup(x, y, n, win, highpass, &max);
+    if (n <= win) {
+        if (max_out) *max_out = max;
+        return;
+    }
+
+    const __m512d vwin = _mm512_set1_pd((double)win);
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512d carry = _mm512_set1_pd(sum);
+    __m512d vmax = _mm512_set1_pd(max);
+    size_t i = win;
+
+    for (; i + 8 <= n; i += 8) {
+        const __m512d xi = _mm512_loadu_pd(x + i);
+        const __m512d d = _mm512_sub_pd(xi, _mm512_loadu_pd(x + i - win));
+        const __m512d s = _mm512_add_pd(prefix8(d), carry);
+        carry = _mm512_permutexvar_pd(last, s);
+
+        const __m512d ma = _mm512_div_pd(s, vwin);
+        const __m512d out = highpass ? _mm512_sub_pd(xi, ma) : ma;
+        _mm512_storeu_pd(y + i, out);
+        vmax = _mm512_max_pd(out, vmax);
+    }
+
+    double lanes[8];
+    _mm512_storeu_pd(lanes, vmax);
+    for (int k = 0; k < 8; ++k)
+        if (lanes[k] > max) max = lanes[k];
+
+    sum = _mm512_cvtsd_f64(carry);
+    for (; i < n; ++i) {
+        sum += x[i] - x[i - win];
+        const double ma = sum / (double)win;
+        y[i] = highpass ? x[i] - ma : ma;
+        if (y[i] > max) max = y[i];
+    }
+    if (max_out) *max_out = max;
+}
+
+AVX512 static void apply_gain_avx512(double *x, size_t n, double gain)
+{
+    if (!x || n == 0) return;
+
+    const __m512d g = _mm512_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_loadu_pd(x + i), g));
+    for (; i < n; ++i) x[i] *= gain;
+}
+
+AVX512 static void remove_dc_avx512(double *x, size_t n)
+{
+    if (!x || n == 0) return;
+
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) acc = _mm512_add_pd(acc, _mm512_loadu_pd(x + i));
+
+    double sum = _mm512_reduce_add_pd(acc);
+    for (; i < n; ++i) sum += x[i];
+
+    const double m = sum / (double)n;
+    const __m512d vm = _mm512_set1_pd(m);
+    for (i = 0; i + 8 <= n; i += 8) _mm512_storeu_pd(x + i, _mm512_sub_pd(_mm512_loadu_pd(x + i), vm));
+    for (; i < n; ++i) x[i] -= m;
+}
+
+AVX512 static void moving_average_avx512(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx512(x, y, n, win, 0, NULL);
+}
+
+AVX512 static void highpass_ma_avx512(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx512(x, y, n, win, 1, NULL);
+}
+
+AVX512 static void mwi_avx512(const double *x, double *y, size_t n, size_t win)
+{
+    sliding_avx512(x, y, n, win, 0, NULL);
+}
+
+AVX512 static double mwi_max_avx512(const double *x, double *y, size_t n, size_t win)
+{
+    double max = 0.0;
+    sliding_avx512(x, y, n, win, 0, &max);
+    return max;
+}
+
+AVX512 static size_t argmax_avx512(const double *x, size_t n)
+{
+    if (!x || n == 0) return 0;
+
+    __m512d vmax = _mm512_set1_pd(x[0]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) vmax = _mm512_max_pd(_mm512_loadu_pd(x + i), vmax);
+
+    double lanes[8];
+    _mm512_storeu_pd(lanes, vmax);
+    double m = x[0];
+    for (int k = 0; k < 8; ++k)
+        if (lanes[k] > m) m = lanes[k];
+    for (; i < n; ++i)
+        if (x[i] > m) m = x[i];
+
+    return find_first(x, 0, n, m);
+}
+
+AVX512 static void derivative_1_avx512(const double *x, double *y, size_t n)
+{
+    if (!x || !y || n == 0) return;
+
+    y[0] = 0.0;
+    size_t i = 1;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(y + i, _mm512_sub_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(x + i - 1)));
+    for (; i < n; ++i) y[i] = x[i] - x[i - 1];
+}
+
+AVX512 static void square_avx512(const double *x, double *y, size_t n)
+{
+    if (!x || !y || n == 0) return;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d v = _mm512_loadu_pd(x + i);
+        _mm512_storeu_pd(y + i, _mm512_mul_pd(v, v));
+    }
+    for (; i < n; ++i) y[i] = x[i] * x[i];
+}
+
+const ECG_Kernels ecg_kernels_avx512 = {
+    "avx512", ECG_ISA_AVX512,
+    apply_gain_avx512, remove_dc_avx512, moving_average_avx512, highpass_ma_avx512,
+    derivative_1_avx512, square_avx512, mwi_avx512, mwi_max_avx512, argmax_avx512
+};
+
+#endif /* ECG_HAVE_X86_KERNELS */
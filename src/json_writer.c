@@ -1,43 +1,348 @@
 #include "json_writer.h"
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-static void write_int_array(FILE *f, const int *a, int n) {
+/* Taille max d'un entier formaté ("-2147483648") et d'un nombre %.2f du chemin rapide. */
+#define INT_CHARS    11
+#define FIXED_CHARS  24
+#define SEP_CHARS    2
+
+/* Au-delà, v * 100 n'est plus un entier exact en double : on repasse par snprintf. */
+#define FIXED_MAX    4.0e13
+
+/* ================================
+ * Buffer de sortie
+ * ================================ */
+
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+} Out_Buffer;
+
+/* Garantit extra octets libres (doublement) : une réservation par tableau, pas par élément. */
+static int out_reserve(Out_Buffer *b, size_t extra) {
+    if (b->len + extra <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + extra) cap *= 2;
+    char *p = realloc(b->data, cap);
+    if (!p) return -1;
+    b->data = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int out_str(Out_Buffer *b, const char *s) {
+    size_t n = strlen(s);
+    if (out_reserve(b, n) != 0) return -1;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+/* ================================
+ * Formatage des nombres
+ * ================================ */
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Entier non signé en décimal, deux chiffres par itération. Retourne le nombre de caractères. */
+static size_t format_u64(char *dst, unsigned long long v) {
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    while (v >= 100) {
+        const unsigned k = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[k + 1];
+        *--p = digit_pairs[k];
+    }
+    if (v >= 10) {
+        *--p = digit_pairs[v * 2 + 1];
+        *--p = digit_pairs[v * 2];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    const size_t n = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(dst, p, n);
+    return n;
+}
+
+/* Équivalent de printf("%d"). */
+static size_t format_int(char *dst, int v) {
+    if (v < 0) {
+        *dst = '-';
+        return 1 + format_u64(dst + 1, (unsigned long long)(-(long long)v));
+    }
+    return format_u64(dst, (unsigned long long)v);
+}
+
+/*
+ * Équivalent de printf("%.2f") pour |v| < FIXED_MAX : arrondi au plus proche de la valeur binaire exacte,
+ * égalité au pair. v * 100 = p + err exactement (fma) ; la partie fractionnaire de p est un multiple
+ * de ulp(p), donc err ne peut changer la décision que si elle vaut exactement 0.5.
+ */
+static size_t format_fixed2(char *dst, double v) {
+    const double a = fabs(v);
+    const double p = a * 100.0;
+    const double err = fma(a, 100.0, -p);
+    double k = floor(p);
+    const double frac = p - k;
+    if (frac > 0.5 || (frac == 0.5 && (err > 0.0 || (err == 0.0 && fmod(k, 2.0) != 0.0)))) k += 1.0;
+
+    const unsigned long long cents = (unsigned long long)k;
+    size_t n = 0;
+    if (signbit(v)) dst[n++] = '-';
+    n += format_u64(dst + n, cents / 100);
+    dst[n++] = '.';
+    dst[n++] = digit_pairs[(cents % 100) * 2];
+    dst[n++] = digit_pairs[(cents % 100) * 2 + 1];
+    return n;
+}
+
+static int out_int_array(Out_Buffer *b, const int *a, int n) {
+    if (n <= 0) return 0;
+    if (out_reserve(b, (size_t)n * (INT_CHARS + SEP_CHARS)) != 0) return -1;
+    char *p = b->data + b->len;
     for (int i = 0; i < n; i++) {
-        if (i) fputc(',', f), fputc(' ', f);
-        fprintf(f, "%d", a[i]);
+        if (i) *p++ = ',', *p++ = ' ';
+        p += format_int(p, a[i]);
     }
+    b->len = (size_t)(p - b->data);
+    return 0;
 }
 
-static void write_double_array(FILE *f, const double *a, int n) {
+static int out_double_array(Out_Buffer *b, const double *a, int n) {
+    if (n <= 0) return 0;
+    if (out_reserve(b, (size_t)n * (FIXED_CHARS + SEP_CHARS)) != 0) return -1;
     for (int i = 0; i < n; i++) {
-        if (i) fputc(',', f), fputc(' ', f);
-        fprintf(f, "%.2f", a[i]);
+        char *p = b->data + b->len;
+        if (i) *p++ = ',', *p++ = ' ';
+        if (fabs(a[i]) < FIXED_MAX) {
+            p += format_fixed2(p, a[i]);
+            b->len = (size_t)(p - b->data);
+            continue;
+        }
+
+        // Valeur énorme ou non finie (hors RR physiologique) : snprintf, place réservée à part
+        char tmp[512];
+        const int len = snprintf(tmp, sizeof(tmp), "%.2f", a[i]);
+        b->len = (size_t)(p - b->data);
+        if (len < 0 || out_reserve(b, (size_t)len + (size_t)(n - i) * (FIXED_CHARS + SEP_CHARS)) != 0) return -1;
+        memcpy(b->data + b->len, tmp, (size_t)len);
+        b->len += (size_t)len;
     }
+    return 0;
 }
 
-int write_json(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals) {
-    FILE *f = fopen(filename, "w");
-    if (!f) {
-        perror("fopen");
-        return -1;
+static int out_json_string(Out_Buffer *b, const char *str) {
+    if (out_reserve(b, strlen(str) * 6 + 2) != 0) return -1;
+    char *p = b->data + b->len;
+    *p++ = '"';
+    for (const unsigned char *s = (const unsigned char *)str; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            *p++ = '\\';
+            *p++ = (char)*s;
+        } else if (*s < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            memcpy(p, "\\u00", 4);
+            p[4] = hex[*s >> 4];
+            p[5] = hex[*s & 15];
+            p += 6;
+        } else {
+            *p++ = (char)*s;
+        }
     }
+    *p++ = '"';
+    b->len = (size_t)(p - b->data);
+    return 0;
+}
 
-    static char outbuf[1 << 20];
-    setvbuf(f, outbuf, _IOFBF, sizeof(outbuf));
+/* Nombre réel à précision complète (seuils de la MWI, très petits : "%.2f" les effacerait). */
+static int out_double_g(Out_Buffer *b, double v) {
+    if (!isfinite(v)) return out_str(b, "null");
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "%.17g", v);
+    return out_str(b, tmp);
+}
 
-    fputs("{\n", f);
-    fputs("  \"peaks\": {\n", f);
-    fputs("    \"R\": [", f);
-    write_int_array(f, peaks->R, peaks->R_count);
-    fputs("]\n  },\n", f);
+static int out_u64(Out_Buffer *b, unsigned long long v) {
+    if (out_reserve(b, 20) != 0) return -1;
+    b->len += format_u64(b->data + b->len, v);
+    return 0;
+}
 
-    fputs("  \"intervals\": {\n", f);
-    fputs("    \"RR\": [", f);
-    write_double_array(f, intervals->RR, intervals->count);
-    fputs("]\n  }\n", f);
+/* ================================
+ * Sérialisation
+ * ================================ */
 
-    fputs("}\n", f);
+/* Tableaux de pics : R seul, ou R/P/Q/S/T (ECG_JSON_ALL_PEAKS). */
+static int out_peaks(Out_Buffer *b, const ECG_Peaks *peaks, int flags, const char *indent, const char *sep) {
+    const int *arrays[] = { peaks->R, peaks->P, peaks->Q, peaks->S, peaks->T };
+    const int counts[] = { peaks->R_count, peaks->P_count, peaks->Q_count, peaks->S_count, peaks->T_count };
+    static const char *const names[] = { "\"R\": [", "\"P\": [", "\"Q\": [", "\"S\": [", "\"T\": [" };
+    const int n = (flags & ECG_JSON_ALL_PEAKS) ? 5 : 1;
 
-    fclose(f);
-    return 0;
+    int rc = 0;
+    for (int k = 0; k < n && rc == 0; k++) {
+        if (k) rc |= out_str(b, sep);
+        rc |= out_str(b, indent);
+        rc |= out_str(b, names[k]);
+        rc |= out_int_array(b, arrays[k], counts[k]);
+        rc |= out_str(b, "]");
+    }
+    return rc;
+}
+
+/* Section "stats" : hors du chemin chaud (une fois par document), snprintf pour les réels. */
+static int out_stats(Out_Buffer *b, const ECG_Stats *s) {
+    static const char *const time_names[] = {
+        "highpass", "derivative", "square", "mwi", "fused", "detect", "delineate", "intervals", "stream"
+    };
+    const uint64_t times[] = {
+        s->ns_highpass, s->ns_derivative, s->ns_square, s->ns_mwi,
+        s->ns_fused, s->ns_detect, s->ns_delineate, s->ns_intervals, s->ns_stream
+    };
+
+    int rc = out_str(b, ",\n  \"stats\": {\n    \"enabled\": ");
+    rc |= out_str(b, s->enabled ? "true" : "false");
+    rc |= out_str(b, ",\n    \"calls\": ");
+    rc |= out_u64(b, s->calls);
+    rc |= out_str(b, ",\n    \"samples\": ");
+    rc |= out_u64(b, s->samples);
+
+    rc |= out_str(b, ",\n    \"time_ns\": {");
+    for (size_t k = 0; k < sizeof(times) / sizeof(times[0]); k++) {
+        rc |= out_str(b, k ? ", \"" : "\"");
+        rc |= out_str(b, time_names[k]);
+        rc |= out_str(b, "\": ");
+        rc |= out_u64(b, times[k]);
+    }
+
+    rc |= out_str(b, "},\n    \"candidates\": {\"local_maxima\": ");
+    rc |= out_u64(b, s->local_maxima);
+    rc |= out_str(b, ", \"rejected_refractory\": ");
+    rc |= out_u64(b, s->rejected_refractory);
+    rc |= out_str(b, ", \"rejected_threshold\": ");
+    rc |= out_u64(b, s->rejected_threshold);
+    rc |= out_str(b, ", \"accepted\": ");
+    rc |= out_u64(b, s->accepted);
+
+    const double th[] = { s->threshold_min, s->threshold_max, s->threshold_last, s->signal_peak, s->noise_peak };
+    static const char *const th_names[] = { "min", "max", "last", "signal_peak", "noise_peak" };
+    rc |= out_str(b, "},\n    \"threshold\": {");
+    for (int k = 0; k < 5; k++) {
+        rc |= out_str(b, k ? ", \"" : "\"");
+        rc |= out_str(b, th_names[k]);
+        rc |= out_str(b, "\": ");
+        rc |= out_double_g(b, th[k]);
+    }
+    rc |= out_str(b, ", \"history\": [");
+    for (int k = 0; k < s->threshold_history_count; k++) {
+        if (k) rc |= out_str(b, ", ");
+        rc |= out_double_g(b, s->threshold_history[k]);
+    }
+    rc |= out_str(b, "]}\n  }");
+    return rc;
+}
+
+/* Section "hrv" : une fois par document, 6 chiffres significatifs suffisent (ms et dixièmes de bpm). */
+static int out_hrv(Out_Buffer *b, const ECG_Hrv *h) {
+    static const char *const names[] = {
+        "last_rr_s", "mean_rr_s", "sdnn_s", "rmssd_s", "pnn50", "mean_hr_bpm", "rolling_hr_bpm"
+    };
+    const double values[] = {
+        h->last_rr_s, h->mean_rr_s, h->sdnn_s, h->rmssd_s, h->pnn50, h->mean_hr_bpm, h->rolling_hr_bpm
+    };
+
+    int rc = out_str(b, ",\n  \"hrv\": {\"count\": ");
+    rc |= out_u64(b, (unsigned long long)(h->count > 0 ? h->count : 0));
+    for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+        char tmp[32];
+        snprintf(tmp, sizeof(tmp), "%.6g", isfinite(values[k]) ? values[k] : 0.0);
+        rc |= out_str(b, ", \"");
+        rc |= out_str(b, names[k]);
+        rc |= out_str(b, "\": ");
+        rc |= out_str(b, tmp);
+    }
+    rc |= out_str(b, "}");
+    return rc;
+}
+
+/* Document complet, même mise en forme que l'ancienne version fprintf. */
+static int out_document(Out_Buffer *b, const ECG_Peaks *peaks, const ECG_Intervals *intervals,
+                        const ECG_Json_Lead *leads, int n_leads, int flags, const ECG_Stats *stats,
+                        const ECG_Hrv *hrv) {
+    int rc = out_str(b, "{\n  \"peaks\": {\n");
+    rc |= out_peaks(b, peaks, flags, "    ", ",\n");
+    rc |= out_str(b, "\n  },\n  \"intervals\": {\n    \"RR\": [");
+    rc |= out_double_array(b, intervals->RR, intervals->count);
+    rc |= out_str(b, "]\n  }");
+
+    if (leads && n_leads > 0) {
+        rc |= out_str(b, ",\n  \"leads\": [\n");
+        for (int l = 0; l < n_leads && rc == 0; l++) {
+            rc |= out_str(b, "    {\"name\": ");
+            rc |= out_json_string(b, leads[l].name);
+            rc |= out_str(b, ", \"peaks\": {");
+            rc |= out_peaks(b, leads[l].peaks, flags, "", ", ");
+            rc |= out_str(b, "}, \"intervals\": {\"RR\": [");
+            rc |= out_double_array(b, leads[l].intervals->RR, leads[l].intervals->count);
+            rc |= out_str(b, (l + 1 < n_leads) ? "]}},\n" : "]}}\n");
+        }
+        rc |= out_str(b, "  ]");
+    }
+    if (stats) rc |= out_stats(b, stats);
+    if (hrv) rc |= out_hrv(b, hrv);
+
+    rc |= out_str(b, "\n}\n");
+    return rc;
+}
+
+/* ================================
+ * API
+ * ================================ */
+
+int write_json_ex(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals,
+                  const ECG_Json_Lead *leads, int n_leads, int flags, const ECG_Stats *stats,
+                  const ECG_Hrv *hrv) {
+    if (!filename || !peaks || !intervals) return -1;
+
+    Out_Buffer b = { NULL, 0, 0 };
+    int rc = out_document(&b, peaks, intervals, leads, n_leads, flags, stats, hrv) == 0 ? ecg_write_file(filename, b.data, b.len) : -3;
+    free(b.data);
+    return rc;
+}
+
+int write_json(const char *filename, const ECG_Peaks *peaks, const ECG_Intervals *intervals) {
+    return write_json_ex(filename, peaks, intervals, NULL, 0, 0, NULL, NULL);
+}
+
+int write_json_line(FILE *f, const char *name, const ECG_Peaks *peaks, const ECG_Intervals *intervals) {
+    if (!f || !name || !peaks || !intervals) return -1;
+
+    // Ligne formatée hors verrou, puis un seul fwrite : les threads ne s'attendent que pour la copie
+    Out_Buffer b = { NULL, 0, 0 };
+    int rc = out_str(&b, "{\"file\": ");
+    rc |= out_json_string(&b, name);
+    rc |= out_str(&b, ", \"peaks\": {\"R\": [");
+    rc |= out_int_array(&b, peaks->R, peaks->R_count);
+    rc |= out_str(&b, "]}, \"intervals\": {\"RR\": [");
+    rc |= out_double_array(&b, intervals->RR, intervals->count);
+    rc |= out_str(&b, "]}}\n");
+
+    if (rc == 0) {
+        flockfile(f);
+        rc = (fwrite(b.data, 1, b.len, f) == b.len && !ferror(f)) ? 0 : -2;
+        funlockfile(f);
+    } else {
+        rc = -3;
+    }
+
+    free(b.data);
+    return rc;
 }
@@ -1,74 +1,1118 @@
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "columnar_writer.h"
 #include "csv_reader.h"
+#include "ecg_batch.h"
+#include "ecg_binary.h"
 #include "ecg_processing.h"
+#include "ecg_ring.h"
+#include "ecg_server.h"
+#include "ecg_synth.h"
 #include "json_writer.h"
 #include "output_structs.h"
 
-int main(int argc, char *argv[])
+#ifdef ECG_ISA_LAUNCHER
+#include <limits.h>
+#include <unistd.h>
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+/* Ajoute les pics et intervalles d'un bloc aux résultats cumulés. */
+static ECG_Status append_results(ECG_Peaks *peaks, ECG_Intervals *intervals,
+                                 const ECG_Peaks *chunk_peaks, const ECG_Intervals *chunk_intervals)
 {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <input_csv> <output_json>\n", argv[0]);
-        return 1;
+    if (ecg_peaks_reserve(peaks, peaks->R_count + chunk_peaks->R_count) != 0
+        || ecg_intervals_reserve(intervals, intervals->count + chunk_intervals->count) != 0)
+        return ECG_ERR_ALLOC;
+
+    for (int i = 0; i < chunk_peaks->R_count; i++)
+        peaks->R[peaks->R_count++] = chunk_peaks->R[i];
+    for (int i = 0; i < chunk_intervals->count; i++)
+        intervals->RR[intervals->count++] = chunk_intervals->RR[i];
+    return ECG_OK;
+}
+
+/*
+ * Analyse en streaming : le signal est découpé en blocs de chunk_size échantillons
+ * et poussé bloc par bloc, comme le ferait une passerelle de monitoring.
+ */
+static ECG_Status analyze_stream(ECG_Context *ctx, const double *signal, size_t n_samples, size_t chunk_size,
+                                 ECG_Peaks *peaks, ECG_Intervals *intervals)
+{
+    ECG_Peaks chunk_peaks;
+    ECG_Intervals chunk_intervals;
+    ECG_Status st = ECG_OK;
+
+    if (ecg_peaks_init(&chunk_peaks, 0) != 0 || ecg_intervals_init(&chunk_intervals, 0) != 0) {
+        ecg_peaks_free(&chunk_peaks);
+        ecg_intervals_free(&chunk_intervals);
+        return ECG_ERR_ALLOC;
     }
 
-    if (read_csv(argv[1]) != 0) {
-        fprintf(stderr, "Erreur lecture CSV.\n");
-        return 2;
+    peaks->R_count = 0;
+    intervals->count = 0;
+
+    for (size_t off = 0; off < n_samples && st == ECG_OK; off += chunk_size) {
+        size_t n = (n_samples - off < chunk_size) ? n_samples - off : chunk_size;
+        st = ecg_push(ctx, signal + off, n, &chunk_peaks, &chunk_intervals);
+        if (st == ECG_OK) st = append_results(peaks, intervals, &chunk_peaks, &chunk_intervals);
     }
 
-    ECG_Peaks peaks;
-    ECG_Intervals intervals;
-    memset(&peaks, 0, sizeof(peaks));
-    memset(&intervals, 0, sizeof(intervals));
+    // Fin du flux : on vide le pic en attente
+    if (st == ECG_OK) st = ecg_flush(ctx, &chunk_peaks, &chunk_intervals);
+    if (st == ECG_OK) st = append_results(peaks, intervals, &chunk_peaks, &chunk_intervals);
+
+    ecg_peaks_free(&chunk_peaks);
+    ecg_intervals_free(&chunk_intervals);
+    return st;
+}
+
+/* Résultats cumulés du consommateur de l'anneau. */
+typedef struct {
+    ECG_Peaks *peaks;
+    ECG_Intervals *intervals;
+} Ring_Results;
+
+static ECG_Status ring_sink(void *user, const ECG_Peaks *peaks, const ECG_Intervals *intervals)
+{
+    Ring_Results *r = user;
+    return append_results(r->peaks, r->intervals, peaks, intervals);
+}
+
+/*
+ * Streaming découplé : un thread relit le signal par paquets de chunk_size échantillons dans un anneau SPSC
+ * (comme le lecteur d'un capteur), l'autre l'analyse (ecg_ring_consume). La relecture d'un fichier peut
+ * attendre la place libre : aucune perte, mêmes pics que analyze_stream.
+ */
+static ECG_Status analyze_ring(ECG_Context *ctx, const double *signal, size_t n_samples, size_t chunk_size,
+                               size_t ring_capacity, ECG_Peaks *peaks, ECG_Intervals *intervals)
+{
+#ifdef _OPENMP
+    // Un paquet en attente + une fenêtre MWI non entamée par le consommateur
+    if (ring_capacity < chunk_size + ecg_mwi_window(ctx)) ring_capacity = chunk_size + ecg_mwi_window(ctx);
+    ECG_Ring *ring = ecg_ring_create(ring_capacity);
+    if (!ring) return ECG_ERR_ALLOC;
+
+    peaks->R_count = 0;
+    intervals->count = 0;
+    Ring_Results results = { peaks, intervals };
+    ECG_Status st = ECG_OK;
+
+    #pragma omp parallel sections num_threads(2)
+    {
+        #pragma omp section
+        {
+            for (size_t off = 0; off < n_samples; off += chunk_size) {
+                const size_t n = (n_samples - off < chunk_size) ? n_samples - off : chunk_size;
+                while (ecg_ring_write_space(ring) < n) sched_yield();
+                ecg_ring_write(ring, signal + off, n);
+            }
+            ecg_ring_close(ring);
+        }
+        #pragma omp section
+        {
+            st = ecg_ring_consume(ring, ctx, 0, ring_sink, &results);
+        }
+    }
+
+    ECG_Ring_Counters c;
+    ecg_ring_get_counters(ring, &c);
+    printf("Anneau : %llu échantillons écrits, %llu perdus, %llu lots, remplissage max %zu.\n",
+           (unsigned long long)c.written, (unsigned long long)c.dropped, (unsigned long long)c.batches,
+           c.high_water);
+    ecg_ring_destroy(ring);
+    return st;
+#else
+    (void)ctx; (void)signal; (void)n_samples; (void)chunk_size; (void)ring_capacity; (void)peaks; (void)intervals;
+    fprintf(stderr, "Erreur: --ring nécessite OpenMP (un thread producteur, un thread d'analyse).\n");
+    return ECG_ERR_FAIL;
+#endif
+}
+
+/* Résultats par dérivation de l'analyse multi-dérivations (section "leads" du JSON). */
+typedef struct {
+    ECG_Peaks peaks[LEADS];
+    ECG_Intervals intervals[LEADS];
+    int count;
+} Lead_Results;
+
+static void lead_results_free(Lead_Results *res)
+{
+    for (int l = 0; l < res->count; l++) {
+        ecg_peaks_free(&res->peaks[l]);
+        ecg_intervals_free(&res->intervals[l]);
+    }
+    res->count = 0;
+}
+
+/*
+ * Analyse des 12 dérivations en parallèle : le JSON contient les pics R fusionnés entre dérivations,
+ * les résultats de chaque dérivation restent dans res (libérés par l'appelant).
+ * interleaved : l'enregistrement est entrelacé une fois, puis toutes les dérivations avancent ensemble
+ * (ecg_analyze_interleaved, une voie SIMD par dérivation).
+ */
+static ECG_Status analyze_all_leads(const ECG_Params *params, ECG_Record *rec, int interleaved,
+                                    Lead_Results *res, ECG_Peaks *consensus, ECG_Intervals *intervals)
+{
+    const double *signals[LEADS];
+    const int n_leads = rec->leads;
+    ECG_Status st = ECG_OK;
+
+    for (int l = 0; l < n_leads; l++) {
+        // Décodage à la demande des lignes que la lecture aurait laissées brutes, avant le parallélisme
+        signals[l] = ecg_record_lead(rec, l);
+        if (!signals[l]) st = ECG_ERR_FAIL;
+        int ok = ecg_peaks_init(&res->peaks[l], 0) == 0;
+        ok = (ecg_intervals_init(&res->intervals[l], 0) == 0) && ok;
+        res->count = l + 1;
+        if (!ok) st = ECG_ERR_ALLOC;
+    }
+
+    if (st == ECG_OK && interleaved) {
+        const size_t n_samples = (size_t)rec->samples;
+        double *rows = malloc(sizeof(double) * n_samples * (size_t)n_leads);
+        st = rows ? ecg_interleave_leads(signals, n_samples, n_leads, rows) : ECG_ERR_ALLOC;
+        if (st == ECG_OK)
+            st = ecg_analyze_interleaved(params, rows, n_samples, n_leads, res->peaks, res->intervals, consensus);
+        free(rows);
+    } else if (st == ECG_OK) {
+        st = ecg_analyze_all_leads(params, signals, (size_t)rec->samples, n_leads, res->peaks, res->intervals, consensus);
+    }
+
+    if (st == ECG_OK) {
+        for (int l = 0; l < n_leads; l++)
+            printf("Lead %2d : %d pics R, %d intervalles RR\n", l + 1, res->peaks[l].R_count, res->intervals[l].count);
+        printf("Consensus : %d pics R\n", consensus->R_count);
+        st = ecg_compute_intervals(consensus, params->sampling_rate_hz, intervals);
+    }
+    return st;
+}
+
+/*
+ * Analyse en précision réduite : la dérivation est convertie en float32 ou en int16
+ * (amplitude max -> INT16_MAX, comme un ADC 16 bits) puis passée à ecg_analyze_f32 / ecg_analyze_i16.
+ */
+static ECG_Status analyze_reduced(const ECG_Params *params, const double *signal, size_t n_samples, int lead_index,
+                                  ECG_Peaks *peaks, ECG_Intervals *intervals, ECG_Stats *stats, ECG_Hrv *hrv)
+{
+    const size_t elem = (params->precision == ECG_PRECISION_I16) ? sizeof(int16_t) : sizeof(float);
+    void *samples = malloc(elem * n_samples);
+    ECG_Context *ctx = ecg_create(params);
+    ECG_Status st = (samples && ctx) ? ECG_OK : ECG_ERR_ALLOC;
+
+    if (st == ECG_OK && params->precision == ECG_PRECISION_I16) {
+        double max_abs = 0.0;
+        for (size_t i = 0; i < n_samples; i++)
+            if (fabs(signal[i]) > max_abs) max_abs = fabs(signal[i]);
+        const double inv_scale = (max_abs > 0.0) ? INT16_MAX / max_abs : 1.0;
+
+        int16_t *q = samples;
+        for (size_t i = 0; i < n_samples; i++) q[i] = (int16_t)lrint(signal[i] * inv_scale);
+        st = ecg_analyze_i16(ctx, q, n_samples, lead_index, peaks, intervals);
+    } else if (st == ECG_OK) {
+        float *f = samples;
+        for (size_t i = 0; i < n_samples; i++) f[i] = (float)signal[i];
+        st = ecg_analyze_f32(ctx, f, n_samples, lead_index, peaks, intervals);
+    }
+
+    // Contexte local : compteurs et HRV copiés avant sa destruction
+    if (ctx && stats) ecg_get_stats(ctx, stats);
+    if (ctx && hrv) ecg_get_hrv(ctx, hrv);
+    ecg_destroy(ctx);
+    free(samples);
+    return st;
+}
+
+/*
+ * Contrôle de précision : les indices R du chemin réduit doivent être ceux du chemin double.
+ * Retourne 0 si les deux listes sont identiques.
+ */
+static int verify_precision(ECG_Context *ctx, const double *signal, size_t n_samples, int lead_index,
+                            const ECG_Peaks *peaks)
+{
+    ECG_Peaks ref;
+    if (ecg_peaks_init(&ref, 0) != 0 || ecg_analyze(ctx, signal, n_samples, lead_index, &ref, NULL) != ECG_OK) {
+        ecg_peaks_free(&ref);
+        fprintf(stderr, "Erreur: analyse de référence (double) impossible.\n");
+        return -1;
+    }
+
+    int same = 0;
+    for (int i = 0; i < ref.R_count && i < peaks->R_count; i++) same += ref.R[i] == peaks->R[i];
+    const int ok = ref.R_count == peaks->R_count && same == ref.R_count;
+
+    printf("Vérification précision : %d/%d pics R identiques au chemin double (%d détectés) -> %s\n",
+           same, ref.R_count, peaks->R_count, ok ? "OK" : "ÉCHEC");
+    ecg_peaks_free(&ref);
+    return ok ? 0 : -1;
+}
+
+/* Concordance minimale (sensibilité et valeur prédictive) de la détection décimée au chemin pleine résolution. */
+#define DECIMATION_MIN_AGREEMENT 0.99
+
+/*
+ * Écart de la détection décimée au chemin pleine résolution : les pics R sont appariés dans l'ordre à un
+ * échantillon décimé près (params->decimation échantillons), les autres comptent comme manqués ou en trop.
+ * Retourne 0 si la sensibilité et la valeur prédictive positive atteignent DECIMATION_MIN_AGREEMENT.
+ */
+static int verify_decimation(const ECG_Params *params, const double *signal, size_t n_samples, int lead_index,
+                             const ECG_Peaks *peaks)
+{
+    ECG_Params full = *params;
+    full.decimation = 0;
+    ECG_Context *ctx = ecg_create(&full);
+    ECG_Peaks ref;
+    if (ecg_peaks_init(&ref, 0) != 0 || !ctx || ecg_analyze(ctx, signal, n_samples, lead_index, &ref, NULL) != ECG_OK) {
+        ecg_peaks_free(&ref);
+        ecg_destroy(ctx);
+        fprintf(stderr, "Erreur: analyse de référence (pleine résolution) impossible.\n");
+        return -1;
+    }
+
+    const int tolerance = params->decimation;
+    int matched = 0, same = 0, max_delta = 0;
+    long sum_delta = 0;
+    for (int i = 0, j = 0; i < ref.R_count && j < peaks->R_count;) {
+        const int delta = peaks->R[j] - ref.R[i];
+        if (delta < -tolerance) {
+            j++;
+        } else if (delta > tolerance) {
+            i++;
+        } else {
+            const int abs_delta = abs(delta);
+            matched++;
+            same += abs_delta == 0;
+            sum_delta += abs_delta;
+            if (abs_delta > max_delta) max_delta = abs_delta;
+            i++;
+            j++;
+        }
+    }
+
+    const double ms = 1000.0 / params->sampling_rate_hz;
+    const double se = ref.R_count ? (double)matched / ref.R_count : 1.0;
+    const double ppv = peaks->R_count ? (double)matched / peaks->R_count : 1.0;
+    const int ok = se >= DECIMATION_MIN_AGREEMENT && ppv >= DECIMATION_MIN_AGREEMENT;
+    printf("Vérification décimation x%d : %d/%d pics R appariés au chemin pleine résolution à %d échantillons près "
+           "(%d identiques), %d manqués, %d en trop, écart moyen %.2f ms, max %.2f ms, Se %.2f %%, VPP %.2f %% "
+           "(min %.0f %%) -> %s\n",
+           params->decimation, matched, ref.R_count, tolerance, same, ref.R_count - matched, peaks->R_count - matched,
+           matched ? (double)sum_delta / matched * ms : 0.0, max_delta * ms, 100.0 * se, 100.0 * ppv,
+           100.0 * DECIMATION_MIN_AGREEMENT, ok ? "OK" : "ÉCHEC");
+    ecg_peaks_free(&ref);
+    ecg_destroy(ctx);
+    return ok ? 0 : -1;
+}
+
+/* Options de la ligne de commande (communes à l'analyse simple et au mode batch). */
+typedef struct {
+    size_t chunk_size;  // 0 = analyse globale
+    size_t ring;        // capacité de l'anneau SPSC du streaming, 0 = ecg_push direct
+    int fused;
+    int all_leads;
+    int interleaved;    // --all-leads : moteur entrelacé (pics R uniquement)
+    int jobs;           // modes batch et serve, 0 = un worker par cœur
+    int beds;           // mode serve : flux simultanés, 0 = un par fichier
+    ECG_Isa isa;
+    ECG_Precision precision;
+    int verify;         // compare les pics R de la précision réduite au chemin double (ou décimé à la pleine résolution)
+    int json_flags;     // ECG_JSON_*
+    int per_lead;       // section "leads" du JSON (avec --all-leads)
+    int columnar;       // sortie binaire en colonnes au lieu du JSON
+    int stats;          // section "stats" du JSON (instrumentation ECG_ENABLE_STATS)
+    int hrv;            // section "hrv" du JSON (variabilité cardiaque)
+    int fs;             // fréquence des entrées qui n'en donnent pas (CSV), 0 = SAMPLING_RATE
+    ECG_Filter filter;  // étape 1 : passe-haut x - MA(x) ou passe-bande
+    double band_low_hz; // --band, 0 = 5 Hz
+    double band_high_hz; // --band, 0 = 15 Hz
+    int decimation;     // détection décimée (ECG_Params.decimation), 0 = pleine résolution
+    int chunks;         // analyse parallèle en segments recouvrants (ecg_analyze_parallel), 0 = ecg_analyze
+} Cli_Options;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s <input_csv|input.ecgb> <output_json> [options]\n"
+                    "       %s batch <dossier|liste.txt> <sortie.jsonl|dossier_sortie> [--jobs N] [options]\n"
+                    "       %s serve <sortie.jsonl> <fichiers...> [--beds N] [--jobs N] [--stream <chunk>]\n"
+                    "             [--ring <samples>]\n"
+                    "       %s convert <input_csv> <output.ecgb> [--dtype f64|f32|i16] [--fs <Hz>]\n"
+                    "       %s synth <output.csv|output.ecgb> [--duration <s>] [--hr <bpm>] [--hrv <s>]\n"
+                    "             [--noise <mV>] [--wander <mV>] [--fs <Hz>] [--leads <n>] [--seed <n>]\n"
+                    "             [--dtype f64|f32|i16] [--truth <verite.json>]\n"
+                    "Options: [--stream <chunk_samples> [--ring <samples>]] [--fused] [--all-leads [--interleaved]]\n"
+                    "         [--isa auto|scalar|avx2|avx512] [--precision f64|f32|i16 [--verify]]\n"
+                    "         [--all-peaks] [--per-lead] [--format json|columnar] [--stats] [--hrv] [--fs <Hz>]\n"
+                    "         [--filter ma|bandpass|zero-phase [--band <f_bas>:<f_haut>]] [--decimate <n> [--verify]]\n"
+                    "         [--chunks <n>]\n",
+                    prog, prog, prog, prog, prog);
+}
+
+/* Retourne 0 si toutes les options sont valides. */
+static int parse_options(int argc, char *argv[], int first, Cli_Options *opt)
+{
+    memset(opt, 0, sizeof(*opt));
+    opt->isa = ECG_ISA_AUTO;
+
+    for (int i = first; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            opt->chunk_size = (size_t)strtoul(argv[++i], NULL, 10);
+            if (opt->chunk_size == 0) {
+                fprintf(stderr, "Erreur: taille de bloc invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+            opt->ring = (size_t)strtoul(argv[++i], NULL, 10);
+            if (opt->ring == 0) {
+                fprintf(stderr, "Erreur: capacité d'anneau invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--fused") == 0) {
+            opt->fused = 1;
+        } else if (strcmp(argv[i], "--all-leads") == 0) {
+            opt->all_leads = 1;
+        } else if (strcmp(argv[i], "--interleaved") == 0) {
+            opt->interleaved = 1;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            opt->jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--beds") == 0 && i + 1 < argc) {
+            opt->beds = atoi(argv[++i]);
+            if (opt->beds <= 0) {
+                fprintf(stderr, "Erreur: nombre de lits invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc) {
+            static const char *names[] = { "auto", "scalar", "avx2", "avx512" };
+            const char *name = argv[++i];
+            int isa = -1;
+            for (int k = 0; k < (int)(sizeof(names) / sizeof(names[0])); k++)
+                if (strcmp(name, names[k]) == 0) isa = k;
+            if (isa < 0 || !ecg_kernels_get((ECG_Isa)isa)) {
+                fprintf(stderr, "Erreur: jeu d'instructions '%s' non supporté.\n", name);
+                return -1;
+            }
+            opt->isa = (ECG_Isa)isa;
+        } else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "f64") == 0) opt->precision = ECG_PRECISION_F64;
+            else if (strcmp(name, "f32") == 0) opt->precision = ECG_PRECISION_F32;
+            else if (strcmp(name, "i16") == 0) opt->precision = ECG_PRECISION_I16;
+            else {
+                fprintf(stderr, "Erreur: précision '%s' inconnue.\n", name);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            opt->verify = 1;
+        } else if (strcmp(argv[i], "--all-peaks") == 0) {
+            opt->json_flags |= ECG_JSON_ALL_PEAKS;
+        } else if (strcmp(argv[i], "--per-lead") == 0) {
+            opt->per_lead = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            opt->stats = 1;
+        } else if (strcmp(argv[i], "--hrv") == 0) {
+            opt->hrv = 1;
+        } else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc) {
+            opt->fs = atoi(argv[++i]);
+            if (opt->fs <= 0) {
+                fprintf(stderr, "Erreur: fréquence d'échantillonnage invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "ma") == 0) opt->filter = ECG_FILTER_MA;
+            else if (strcmp(name, "bandpass") == 0) opt->filter = ECG_FILTER_BANDPASS;
+            else if (strcmp(name, "zero-phase") == 0) opt->filter = ECG_FILTER_BANDPASS_ZERO_PHASE;
+            else {
+                fprintf(stderr, "Erreur: filtre '%s' inconnu.\n", name);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--band") == 0 && i + 1 < argc) {
+            char *end = NULL;
+            opt->band_low_hz = strtod(argv[++i], &end);
+            opt->band_high_hz = (end && *end == ':') ? strtod(end + 1, NULL) : 0.0;
+            if (opt->band_low_hz <= 0.0 || opt->band_high_hz <= opt->band_low_hz) {
+                fprintf(stderr, "Erreur: bande invalide (attendu <f_bas>:<f_haut> en Hz).\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--decimate") == 0 && i + 1 < argc) {
+            opt->decimation = atoi(argv[++i]);
+            if (opt->decimation < 1) {
+                fprintf(stderr, "Erreur: facteur de décimation invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--chunks") == 0 && i + 1 < argc) {
+            opt->chunks = atoi(argv[++i]);
+            if (opt->chunks < 1) {
+                fprintf(stderr, "Erreur: nombre de segments invalide.\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "json") == 0) opt->columnar = 0;
+            else if (strcmp(name, "columnar") == 0) opt->columnar = 1;
+            else {
+                fprintf(stderr, "Erreur: format '%s' inconnu.\n", name);
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "Option inconnue: %s\n", argv[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
 
+/* Paramètres d'analyse par défaut du programme. */
+static ECG_Params default_params(const Cli_Options *opt)
+{
     ECG_Params params;
     memset(&params, 0, sizeof(params));
-    params.sampling_rate_hz = SAMPLING_RATE;
+    params.sampling_rate_hz = opt->fs ? opt->fs : SAMPLING_RATE; // un .ecgb garde sa propre fréquence
     params.leads            = LEADS;
     params.gain             = 100.0; // <-- Ajuster le gain si nécessaire
     params.r_threshold_hint = 0.0; // <-- Optionnel, peut être 0.0, et peut-être adaptatif au long du code.
+    params.fused            = opt->fused;
+    params.isa              = opt->isa;
+    params.delineate        = (opt->json_flags & ECG_JSON_ALL_PEAKS) || opt->columnar; // P/Q/S/T en sortie
+    params.filter           = opt->filter;
+    params.band_low_hz      = opt->band_low_hz;
+    params.band_high_hz     = opt->band_high_hz;
+    params.decimation       = opt->decimation;
+    return params;
+}
+
+/* Sous-commande batch : un seul processus pour tout un dossier ou une liste de fichiers. */
+static int run_batch(int argc, char *argv[])
+{
+    Cli_Options opt;
+    if (argc < 4 || parse_options(argc, argv, 4, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ECG_Batch_Options batch;
+    batch.params = default_params(&opt);
+    batch.lead_index = 1; // LEAD II, comme l'analyse simple
+    batch.jobs = opt.jobs;
+
+    int failures = ecg_batch_run(argv[2], argv[3], &batch);
+    if (failures < 0) {
+        fprintf(stderr, "Erreur: mode batch impossible.\n");
+        return 2;
+    }
+
+    printf("Batch terminé : %d enregistrement(s) en échec.\n", failures);
+    return failures ? 6 : 0;
+}
+
+/* Un lit du mode serve : enregistrement rejoué, position de relecture et pics cumulés. */
+typedef struct {
+    const char *name;
+    const double *signal;
+    size_t samples;
+    size_t offset;
+    int stream;         // identifiant ecg_server_open
+    int closed;
+    ECG_Peaks peaks;
+    ECG_Intervals intervals;
+    Ring_Results results;
+} Serve_Bed;
+
+/*
+ * Sous-commande serve : chaque lit rejoue la LEAD II d'un fichier (en tourniquet sur les fichiers) par paquets
+ * de --stream échantillons dans un flux du serveur. Le thread principal joue tous les capteurs : il n'attend
+ * jamais un flux plein (ce qui ne tient pas dans l'anneau est reporté au tour suivant), ce qui laisse les
+ * workers équilibrer la charge. Aucune perte, quelles que soient les tailles de --stream et de --ring.
+ */
+static int run_serve(int argc, char *argv[])
+{
+    int first_opt = 3;
+    while (first_opt < argc && strncmp(argv[first_opt], "--", 2) != 0) first_opt++;
+    const int n_files = first_opt - 3;
+
+    Cli_Options opt;
+    if (argc < 4 || n_files == 0 || parse_options(argc, argv, first_opt, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const int lead_index = 1; // LEAD II, comme l'analyse simple
+    ECG_Record *recs = calloc((size_t)n_files, sizeof(ECG_Record));
+    const int beds = opt.beds ? opt.beds : n_files;
+    Serve_Bed *bed = calloc((size_t)beds, sizeof(Serve_Bed));
+    ECG_Server *server = NULL;
+    FILE *out = NULL;
+    int loaded = 0, rc = 0;
+    if (!recs || !bed) {
+        fprintf(stderr, "Erreur: allocation impossible.\n");
+        rc = 4;
+        goto cleanup;
+    }
+
+    ECG_Params params = default_params(&opt);
+    for (; loaded < n_files; loaded++) {
+        ECG_Record *rec = &recs[loaded];
+        ecg_record_init(rec);
+        if (ecg_record_load_leads(argv[3 + loaded], rec, 1u << lead_index) != 0 || lead_index >= rec->leads) {
+            fprintf(stderr, "Erreur lecture %s.\n", argv[3 + loaded]);
+            ecg_record_free(rec);
+            rc = 2;
+            goto cleanup;
+        }
+        // Paramètres d'analyse communs à tous les flux : une seule fréquence
+        const int fs = rec->sampling_rate_hz ? rec->sampling_rate_hz : params.sampling_rate_hz;
+        if (loaded == 0) params.sampling_rate_hz = fs;
+        if (fs != params.sampling_rate_hz) {
+            fprintf(stderr, "Erreur: %s à %d Hz, les autres fichiers à %d Hz.\n", argv[3 + loaded], fs,
+                    params.sampling_rate_hz);
+            ecg_record_free(rec);
+            rc = 1;
+            goto cleanup;
+        }
+    }
+    const size_t chunk = opt.chunk_size ? opt.chunk_size : (size_t)(params.sampling_rate_hz / 10); // 100 ms
 
+    ECG_Server_Options so;
+    memset(&so, 0, sizeof(so));
+    so.workers = opt.jobs;
+    so.max_streams = beds;
+    so.ring_capacity = opt.ring;
+    server = ecg_server_create(&params, &so);
+    out = fopen(argv[2], "w");
+    if (!server || !out || ecg_server_start(server) != ECG_OK) {
+        fprintf(stderr, "Erreur: démarrage du serveur impossible.\n");
+        rc = server ? 3 : 4;
+        goto cleanup;
+    }
+
+    for (int b = 0; b < beds; b++) {
+        const ECG_Record *rec = &recs[b % n_files];
+        bed[b].name = argv[3 + b % n_files];
+        bed[b].signal = rec->data[lead_index];
+        bed[b].samples = (size_t)rec->samples;
+        bed[b].results.peaks = &bed[b].peaks;
+        bed[b].results.intervals = &bed[b].intervals;
+        if (ecg_peaks_init(&bed[b].peaks, 0) != 0 || ecg_intervals_init(&bed[b].intervals, 0) != 0) {
+            rc = 4;
+            break;
+        }
+        bed[b].stream = ecg_server_open(server, ring_sink, &bed[b].results);
+        if (bed[b].stream < 0) {
+            rc = 4;
+            break;
+        }
+    }
+    if (rc != 0) {
+        fprintf(stderr, "Erreur: ouverture des flux impossible.\n");
+        goto cleanup;
+    }
+
+    // Tourniquet sur les lits : un paquet par lit et par tour, tronqué à la place libre de son anneau
+    // (un paquet plus grand que l'anneau, moins la fenêtre MWI que le worker y laisse, n'y tiendrait jamais)
+    for (int open = beds; open > 0;) {
+        int progress = 0;
+        for (int b = 0; b < beds; b++) {
+            Serve_Bed *s = &bed[b];
+            if (s->closed) continue;
+            size_t n = (s->samples - s->offset < chunk) ? s->samples - s->offset : chunk;
+            const size_t space = ecg_server_feed_space(server, s->stream);
+            if (n > space) n = space;
+            if (n > 0) {
+                s->offset += ecg_server_feed(server, s->stream, s->signal + s->offset, n);
+                progress = 1;
+            }
+            if (s->offset == s->samples) {
+                ecg_server_close(server, s->stream);
+                s->closed = 1;
+                open--;
+                progress = 1;
+            }
+        }
+        if (!progress) sched_yield();
+    }
+    ecg_server_stop(server);
+
+    uint64_t samples = 0, latency_sum = 0, latency_count = 0, latency_max = 0, migrations = 0, dropped = 0;
+    for (int b = 0; b < beds; b++) {
+        ECG_Server_Stream_Stats st;
+        ecg_server_get_stream_stats(server, bed[b].stream, &st);
+        if (st.status != ECG_OK || write_json_line(out, bed[b].name, &bed[b].peaks, &bed[b].intervals) != 0) {
+            fprintf(stderr, "Erreur: lit %d (%s).\n", b, bed[b].name);
+            rc = 6;
+        }
+        samples += st.samples;
+        latency_sum += st.latency_sum_ns;
+        latency_count += st.latency_count;
+        if (st.latency_max_ns > latency_max) latency_max = st.latency_max_ns;
+        migrations += st.migrations;
+        dropped += st.dropped;
+    }
+    printf("Serveur : %d lits, %llu échantillons, latence moyenne %.1f µs (max %.1f µs), %llu migrations, "
+           "%llu perdus.\n",
+           beds, (unsigned long long)samples, latency_count ? (double)latency_sum / latency_count / 1e3 : 0.0,
+           (double)latency_max / 1e3, (unsigned long long)migrations, (unsigned long long)dropped);
+
+cleanup:
+    ecg_server_destroy(server);
+    if (out && fclose(out) != 0 && rc == 0) rc = 3;
+    for (int b = 0; bed && b < beds; b++) {
+        ecg_peaks_free(&bed[b].peaks);
+        ecg_intervals_free(&bed[b].intervals);
+    }
+    for (int i = 0; i < loaded; i++) ecg_record_free(&recs[i]);
+    free(bed);
+    free(recs);
+    return rc;
+}
+
+/* Sous-commande convert : CSV (ou binaire) -> format binaire compact. */
+static int run_convert(int argc, char *argv[])
+{
+    ECG_Dtype dtype = ECG_DTYPE_F64;
+    int fs = 0;
+
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--dtype") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "f64") == 0) dtype = ECG_DTYPE_F64;
+            else if (strcmp(name, "f32") == 0) dtype = ECG_DTYPE_F32;
+            else if (strcmp(name, "i16") == 0) dtype = ECG_DTYPE_I16;
+            else {
+                fprintf(stderr, "Erreur: type '%s' inconnu.\n", name);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc) {
+            fs = atoi(argv[++i]);
+            if (fs <= 0) {
+                fprintf(stderr, "Erreur: fréquence d'échantillonnage invalide.\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Option inconnue: %s\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    ECG_Record rec;
+    ecg_record_init(&rec);
+
+    int rc = 0;
+    if (ecg_record_load(argv[2], &rec) != 0) {
+        fprintf(stderr, "Erreur lecture %s.\n", argv[2]);
+        rc = 2;
+    } else {
+        if (fs == 0) fs = rec.sampling_rate_hz ? rec.sampling_rate_hz : SAMPLING_RATE;
+        if (ecg_binary_write(argv[3], &rec, dtype, fs) != 0) rc = 3;
+        else printf("%d leads x %d échantillons écrits dans %s\n", rec.leads, rec.samples, argv[3]);
+    }
+
+    ecg_record_free(&rec);
+    return rc;
+}
+
+/* Nom du fichier de vérité terrain par défaut : sortie sans extension + ".truth.json". */
+static void truth_path(char *dst, size_t size, const char *output)
+{
+    const char *dot = strrchr(output, '.');
+    const char *slash = strrchr(output, '/');
+    const int stem = (dot && (!slash || dot > slash)) ? (int)(dot - output) : (int)strlen(output);
+    snprintf(dst, size, "%.*s.truth.json", stem, output);
+}
+
+/* Sous-commande synth : ECG synthétique (CSV ou binaire selon l'extension) + vérité terrain JSON. */
+static int run_synth(int argc, char *argv[])
+{
+    ECG_Synth_Params sp;
+    ecg_synth_defaults(&sp);
+    ECG_Dtype dtype = ECG_DTYPE_F64;
+    double duration_s = (double)sp.samples / sp.sampling_rate_hz;
+    const char *truth_file = NULL;
+
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int i = 3; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Option inconnue: %s\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+        const char *val = argv[++i];
+        if (strcmp(arg, "--duration") == 0) duration_s = atof(val);
+        else if (strcmp(arg, "--hr") == 0) sp.heart_rate_bpm = atof(val);
+        else if (strcmp(arg, "--hrv") == 0) sp.hrv_std_s = atof(val);
+        else if (strcmp(arg, "--noise") == 0) sp.noise_std = atof(val);
+        else if (strcmp(arg, "--wander") == 0) sp.baseline_wander = atof(val);
+        else if (strcmp(arg, "--fs") == 0) sp.sampling_rate_hz = atoi(val);
+        else if (strcmp(arg, "--leads") == 0) sp.leads = atoi(val);
+        else if (strcmp(arg, "--seed") == 0) sp.seed = strtoull(val, NULL, 0);
+        else if (strcmp(arg, "--truth") == 0) truth_file = val;
+        else if (strcmp(arg, "--dtype") == 0) {
+            if (strcmp(val, "f64") == 0) dtype = ECG_DTYPE_F64;
+            else if (strcmp(val, "f32") == 0) dtype = ECG_DTYPE_F32;
+            else if (strcmp(val, "i16") == 0) dtype = ECG_DTYPE_I16;
+            else {
+                fprintf(stderr, "Erreur: type '%s' inconnu.\n", val);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Option inconnue: %s\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    sp.samples = (duration_s > 0.0 && sp.sampling_rate_hz > 0) ? (size_t)llround(duration_s * sp.sampling_rate_hz) : 0;
+
+    char default_truth[4096];
+    if (!truth_file) {
+        truth_path(default_truth, sizeof(default_truth), argv[2]);
+        truth_file = default_truth;
+    }
+
+    ECG_Record rec;
+    ECG_Peaks truth;
+    ECG_Intervals truth_rr;
+    ecg_record_init(&rec);
+    int rc = (ecg_peaks_init(&truth, 0) == 0 && ecg_intervals_init(&truth_rr, 0) == 0) ? 0 : 4;
+
+    const int gen = rc ? -3 : ecg_synth_generate(&sp, &rec, &truth);
+    if (rc == 0 && gen != 0) {
+        fprintf(stderr, gen == -2 ? "Erreur: paramètres de génération invalides.\n"
+                                  : "Erreur: allocation du signal synthétique impossible.\n");
+        rc = (gen == -2) ? 1 : 4;
+    }
+
+    // Format de sortie choisi par l'extension
+    if (rc == 0) {
+        const char *ext = strrchr(argv[2], '.');
+        const int binary = ext && strcmp(ext, ECG_BIN_EXTENSION) == 0;
+        const int written = binary ? ecg_binary_write(argv[2], &rec, dtype, sp.sampling_rate_hz)
+                                   : write_csv_record(argv[2], &rec);
+        if (written != 0) rc = 3;
+    }
+    if (rc == 0 && (ecg_compute_intervals(&truth, sp.sampling_rate_hz, &truth_rr) != ECG_OK
+                    || write_json_ex(truth_file, &truth, &truth_rr, NULL, 0, ECG_JSON_ALL_PEAKS, NULL, NULL) != 0)) {
+        fprintf(stderr, "Erreur écriture de la vérité terrain.\n");
+        rc = 3;
+    }
+    if (rc == 0)
+        printf("%d leads x %d échantillons (%d battements) écrits dans %s, vérité terrain dans %s\n",
+               rec.leads, rec.samples, truth.R_count, argv[2], truth_file);
+
+    ecg_record_free(&rec);
+    ecg_peaks_free(&truth);
+    ecg_intervals_free(&truth_rr);
+    return rc;
+}
+
+#ifdef ECG_ISA_LAUNCHER
+/*
+ * Versions -march construites à côté du programme (ECG_ISA_BUILDS), de la plus capable à la moins capable.
+ * Le test couvre les extensions que le compilateur peut émettre à ce niveau.
+ */
+#if defined(__x86_64__)
+static int cpu_x86_64_v3(void)
+{
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+    return __builtin_cpu_supports("x86-64-v3");
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("bmi2");
+#endif
+}
+
+static int cpu_x86_64_v4(void)
+{
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+    return __builtin_cpu_supports("x86-64-v4");
+#else
+    return cpu_x86_64_v3() && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512dq")
+        && __builtin_cpu_supports("avx512vl");
+#endif
+}
+#elif defined(__aarch64__) && defined(__linux__)
+static int cpu_armv8_2(void)
+{
+    const unsigned long need = HWCAP_CRC32 | HWCAP_ATOMICS | HWCAP_ASIMDRDM | HWCAP_DCPOP;
+    return (getauxval(AT_HWCAP) & need) == need;
+}
+#endif
+
+static const struct {
+    const char *level;
+    int (*supported)(void);
+} isa_builds[] = {
+#if defined(__x86_64__)
+    { "x86-64-v4", cpu_x86_64_v4 },
+    { "x86-64-v3", cpu_x86_64_v3 },
+#elif defined(__aarch64__) && defined(__linux__)
+    { "armv8.2-a", cpu_armv8_2 },
+#else
+    { NULL, NULL }
+#endif
+};
+
+/*
+ * Relance le programme avec la meilleure version -march que le CPU supporte (<programme>-<niveau>).
+ * Ne retourne que si aucune ne convient : la version générique continue.
+ * ECG_DISPATCH=off : version générique ; ECG_DISPATCH=<niveau> : ce niveau, sans test du CPU.
+ */
+static void exec_best_build(char *argv[])
+{
+    const char *forced = getenv("ECG_DISPATCH");
+    if (forced && strcmp(forced, "off") == 0) return;
+
+    char self[PATH_MAX];
+    const ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len > 0) self[len] = '\0';
+    else if (strchr(argv[0], '/')) snprintf(self, sizeof(self), "%s", argv[0]);
+    else return;
+
+    for (size_t i = 0; i < sizeof(isa_builds) / sizeof(isa_builds[0]); i++) {
+        if (!isa_builds[i].level) continue;
+        if (forced ? strcmp(forced, isa_builds[i].level) != 0 : !isa_builds[i].supported()) continue;
+
+        char path[PATH_MAX + 32];
+        snprintf(path, sizeof(path), "%s-%s", self, isa_builds[i].level);
+        if (access(path, X_OK) != 0) continue;
+        execv(path, argv);
+        perror(path); // exécution impossible : on reste sur la version générique
+        return;
+    }
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+#ifdef ECG_ISA_LAUNCHER
+    exec_best_build(argv);
+#endif
+    if (argc >= 2 && strcmp(argv[1], "batch") == 0) return run_batch(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0) return run_serve(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "convert") == 0) return run_convert(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "synth") == 0) return run_synth(argc, argv);
+
+    Cli_Options opt;
+    if (argc < 3 || parse_options(argc, argv, 3, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // CSV ou binaire : pas de copie, l'analyse lit directement rec.data (projection pour le float64).
+    // Une seule dérivation analysée : les autres lignes ne sont pas converties
+    const int lead_index = 1; // Analyser la LEAD II (index 1)
+    ECG_Record rec;
+    ecg_record_init(&rec);
+    if (ecg_record_load_leads(argv[1], &rec, opt.all_leads ? ECG_LEADS_ALL : 1u << lead_index) != 0) {
+        fprintf(stderr, "Erreur lecture %s.\n", argv[1]);
+        ecg_record_free(&rec);
+        return 2;
+    }
+    printf("Enregistrement chargé avec %d leads et %d échantillons.\n", rec.leads, rec.samples);
+
+    Lead_Results lead_results;
+    lead_results.count = 0;
+
+    ECG_Peaks peaks;
+    ECG_Intervals intervals;
+    if (ecg_peaks_init(&peaks, 0) != 0 || ecg_intervals_init(&intervals, 0) != 0) {
+        fprintf(stderr, "Erreur: allocation des résultats impossible.\n");
+        ecg_peaks_free(&peaks);
+        ecg_intervals_free(&intervals);
+        ecg_record_free(&rec);
+        return 4;
+    }
+
+    ECG_Params params = default_params(&opt);
+    params.max_samples = (size_t)rec.samples; // Buffers dimensionnés sur l'enregistrement
+    if (rec.sampling_rate_hz > 0) params.sampling_rate_hz = rec.sampling_rate_hz;
+
+    int rc = 0;
     ECG_Context *ctx = ecg_create(&params);
     if (!ctx) {
         fprintf(stderr, "Erreur: ecg_create() a échoué.\n");
-        return 4;
+        rc = 4;
+        goto cleanup;
     }
 
-    int lead_index = 1; // Analyser la LEAD II (index 1)
-    if (lead_index < 0 || lead_index >= LEADS) {
+    if (lead_index < 0 || lead_index >= rec.leads) {
         fprintf(stderr, "Erreur: lead_index invalide.\n");
-        ecg_destroy(ctx);
-        return 5;
+        rc = 5;
+        goto cleanup;
     }
 
     /* Ici vous êtes libre de déconstruire en chunk ou d'analyser le signal dans son entiéreté
        Dans la réalité vous serez plus ammené a avoir un flux continus plutôt qu'un gros chunk de données */
-    ECG_Status st = ecg_analyze(
-        ctx,
-        ecg_data[lead_index],
-        (size_t)sample_count,
-        lead_index,
-        &peaks,
-        &intervals
-    );
+    if (opt.per_lead && !opt.all_leads) {
+        fprintf(stderr, "Erreur: --per-lead nécessite --all-leads.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.interleaved && !opt.all_leads) {
+        fprintf(stderr, "Erreur: --interleaved nécessite --all-leads.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (params.delineate && opt.interleaved && opt.per_lead)
+        fprintf(stderr, "Attention: le moteur entrelacé ne produit que les pics R (pas d'ondes P/Q/S/T).\n");
+    if (opt.hrv && opt.columnar) {
+        fprintf(stderr, "Erreur: --hrv ne s'applique qu'à la sortie JSON.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.stats && (opt.all_leads || opt.columnar)) {
+        fprintf(stderr, "Erreur: --stats ne s'applique qu'à une seule dérivation en sortie JSON.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.ring > 0 && opt.chunk_size == 0) {
+        fprintf(stderr, "Erreur: --ring nécessite --stream.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (params.delineate && opt.chunk_size > 0)
+        fprintf(stderr, "Attention: le mode streaming ne produit que les pics R (pas d'ondes P/Q/S/T).\n");
+    if (opt.filter == ECG_FILTER_BANDPASS_ZERO_PHASE && opt.chunk_size > 0) {
+        fprintf(stderr, "Erreur: --filter zero-phase ne s'applique qu'à l'analyse globale (pas de --stream).\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.filter != ECG_FILTER_MA && opt.precision != ECG_PRECISION_F64) {
+        fprintf(stderr, "Erreur: le passe-bande n'existe qu'en précision double.\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.decimation > 1 && (opt.precision != ECG_PRECISION_F64 || opt.interleaved || opt.chunk_size > 0)) {
+        fprintf(stderr, "Erreur: --decimate ne s'applique qu'à l'analyse globale en précision double "
+                        "(ni --stream, ni --interleaved).\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.chunks > 0 && (opt.all_leads || opt.chunk_size > 0 || opt.stats || opt.decimation > 1
+                           || opt.precision != ECG_PRECISION_F64)) {
+        fprintf(stderr, "Erreur: --chunks ne s'applique qu'à l'analyse globale d'une dérivation en précision double "
+                        "(ni --all-leads, ni --stream, ni --stats, ni --decimate).\n");
+        rc = 1;
+        goto cleanup;
+    }
+    if (opt.precision != ECG_PRECISION_F64 && (opt.all_leads || opt.chunk_size > 0)) {
+        fprintf(stderr, "Erreur: --precision ne s'applique qu'à l'analyse globale d'une dérivation.\n");
+        rc = 1;
+        goto cleanup;
+    }
+
+    ECG_Status st;
+    ECG_Stats stats;
+    memset(&stats, 0, sizeof(stats));
+    ECG_Hrv hrv;
+    memset(&hrv, 0, sizeof(hrv));
+    if (opt.precision != ECG_PRECISION_F64) {
+        ECG_Params reduced = params;
+        reduced.precision = opt.precision;
+        st = analyze_reduced(&reduced, rec.data[lead_index], (size_t)rec.samples, lead_index, &peaks, &intervals,
+                             &stats, &hrv);
+        if (st == ECG_OK && opt.verify
+            && verify_precision(ctx, rec.data[lead_index], (size_t)rec.samples, lead_index, &peaks) != 0) {
+            rc = 7;
+            goto cleanup;
+        }
+    } else if (opt.all_leads) {
+        st = analyze_all_leads(&params, &rec, opt.interleaved, &lead_results, &peaks, &intervals);
+    } else if (opt.chunks > 0) {
+        st = ecg_analyze_parallel(&params, rec.data[lead_index], (size_t)rec.samples, lead_index, opt.chunks, &peaks,
+                                  &intervals);
+    } else if (opt.chunk_size > 0 && opt.ring > 0) {
+        st = analyze_ring(ctx, rec.data[lead_index], (size_t)rec.samples, opt.chunk_size, opt.ring, &peaks,
+                          &intervals);
+    } else if (opt.chunk_size > 0) {
+        st = analyze_stream(ctx, rec.data[lead_index], (size_t)rec.samples, opt.chunk_size, &peaks, &intervals);
+    } else {
+        st = ecg_analyze(
+            ctx,
+            rec.data[lead_index],
+            (size_t)rec.samples,
+            lead_index,
+            &peaks,
+            &intervals
+        );
+        if (st == ECG_OK && opt.verify && opt.decimation > 1
+            && verify_decimation(&params, rec.data[lead_index], (size_t)rec.samples, lead_index, &peaks) != 0) {
+            rc = 7;
+            goto cleanup;
+        }
+    }
 
     if (st != ECG_OK) {
         fprintf(stderr, "Erreur: ecg_analyze() a retourné %d.\n", (int)st);
-        ecg_destroy(ctx);
-        return 6;
+        rc = 6;
+        goto cleanup;
     }
 
     printf("%d pics R détectés.\n", peaks.R_count);
 
-    ecg_destroy(ctx);
+    // HRV tenue par le contexte au fil des battements ; le consensus multi-dérivations et l'analyse
+    // parallèle (un contexte par segment) sont cumulés ici
+    if (opt.all_leads || opt.chunks > 0) {
+        ECG_Hrv_State hrv_state;
+        ecg_hrv_reset(&hrv_state);
+        for (int i = 0; i < intervals.count; i++) ecg_hrv_update(&hrv_state, intervals.RR[i]);
+        ecg_hrv_get(&hrv_state, &hrv);
+    } else if (opt.precision == ECG_PRECISION_F64) {
+        ecg_get_hrv(ctx, &hrv);
+    }
+    if (opt.hrv)
+        printf("HRV : %d RR, %.1f bpm (%.1f bpm sur les %d derniers), SDNN %.1f ms, RMSSD %.1f ms, pNN50 %.1f %%\n",
+               hrv.count, hrv.mean_hr_bpm, hrv.rolling_hr_bpm, MAX_RR_HISTORY, hrv.sdnn_s * 1e3, hrv.rmssd_s * 1e3,
+               hrv.pnn50);
 
-    if (write_json(argv[2], &peaks, &intervals) != 0) {
-        fprintf(stderr, "Erreur écriture JSON.\n");
-        return 3;
+    // Compteurs du contexte (le chemin réduit les a déjà copiés depuis son contexte local)
+    if (opt.stats && opt.precision == ECG_PRECISION_F64) ecg_get_stats(ctx, &stats);
+    if (opt.stats && !stats.enabled)
+        fprintf(stderr, "Attention: instrumentation non compilée (ECG_ENABLE_STATS), section \"stats\" vide.\n");
+
+    // Section "leads" : une entrée par dérivation analysée (--all-leads --per-lead)
+    // Noms des lignes du CSV (lead1, lead2, ...)
+    char lead_names[LEADS][16];
+    ECG_Json_Lead json_leads[LEADS];
+    const int n_json_leads = opt.per_lead ? lead_results.count : 0;
+    for (int l = 0; l < n_json_leads; l++) {
+        snprintf(lead_names[l], sizeof(lead_names[l]), "lead%d", l + 1);
+        json_leads[l].name = lead_names[l];
+        json_leads[l].peaks = &lead_results.peaks[l];
+        json_leads[l].intervals = &lead_results.intervals[l];
+    }
+
+    const int written = opt.columnar
+        ? write_columnar(argv[2], &peaks, &intervals, params.sampling_rate_hz)
+        : write_json_ex(argv[2], &peaks, &intervals, json_leads, n_json_leads, opt.json_flags,
+                        opt.stats ? &stats : NULL, opt.hrv ? &hrv : NULL);
+    if (written != 0) {
+        fprintf(stderr, "Erreur écriture des résultats.\n");
+        rc = 3;
+        goto cleanup;
     }
 
     printf("Analyse terminée. Résultats sauvegardés dans %s\n", argv[2]);
-    return 0;
+
+cleanup:
+    ecg_destroy(ctx);
+    lead_results_free(&lead_results);
+    ecg_peaks_free(&peaks);
+    ecg_intervals_free(&intervals);
+    ecg_record_free(&rec);
+    return rc;
 }
@@ -0,0 +1,215 @@
+/**
+ * @file    number_parser.c
+ * @brief   Conversion texte -> double : chemin rapide de Clinger + algorithme d'Eisel-Lemire.
+ * @details Références : D. Lemire, "Number Parsing at a Gigabyte per Second" (2021) ;
+ *          N. Mushtak, D. Lemire, "Fast Number Parsing Without Fallback" (2023) pour la preuve que
+ *          le produit sur 128 bits suffit toujours pour une mantisse exacte de 19 chiffres au plus.
+ *
+ */
+
+#include "number_parser.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "number_parser_table.h"
+
+/* ================================
+ * Constantes
+ * ================================ */
+
+/* Nombre de chiffres significatifs qui tiennent sans perte dans un uint64_t (10^19 < 2^64). */
+#define MAX_EXACT_DIGITS 19
+
+/* Puissances de 10 exactes en double (chemin rapide de Clinger). */
+static const double exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* ================================
+ * Helpers (internes)
+ * ================================ */
+
+static int is_digit(char c)
+{
+    return (unsigned)(c - '0') <= 9u;
+}
+
+/*
+ * Eisel-Lemire : w * 10^q arrondi au plus proche (pair en cas d'égalité), pour w != 0 exact.
+ * Retourne 0 si le cas sort du domaine traité (table, sous-normaux, dépassement).
+ */
+static int eisel_lemire(uint64_t w, int q, int neg, double *out)
+{
+#ifdef __SIZEOF_INT128__
+    if (q < POW5_Q_MIN || q > POW5_Q_MAX) return 0;
+
+    const int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    // Produit w x 5^q sur 128 bits ; la partie basse n'est utile que si les 9 bits sous la mantisse sont tous à 1
+    const uint64_t *p5 = pow5_128[q - POW5_Q_MIN];
+    unsigned __int128 first = (unsigned __int128)w * p5[0];
+    uint64_t hi = (uint64_t)(first >> 64);
+    uint64_t lo = (uint64_t)first;
+    if ((hi & 0x1FF) == 0x1FF) {
+        const uint64_t second_hi = (uint64_t)(((unsigned __int128)w * p5[1]) >> 64);
+        lo += second_hi;
+        if (second_hi > lo) hi++;
+    }
+
+    const int upperbit = (int)(hi >> 63);
+    const int shift = upperbit + 64 - 52 - 3;
+    uint64_t mantissa = hi >> shift;
+
+    // floor(log2(10^q)) + 63, puis biais de l'exposant binaire
+    int power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+    if (power2 <= 0) return 0;
+
+    // Égalité exacte entre deux flottants : arrondi au pair
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+        mantissa &= ~(uint64_t)1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((uint64_t)2 << 52)) {
+        mantissa = (uint64_t)1 << 52;
+        power2++;
+    }
+    mantissa &= ~((uint64_t)1 << 52);
+    if (power2 >= 0x7FF) return 0;
+
+    const uint64_t bits = mantissa | ((uint64_t)power2 << 52) | ((uint64_t)neg << 63);
+    memcpy(out, &bits, sizeof(bits));
+    return 1;
+#else
+    (void)w; (void)q; (void)neg; (void)out;
+    return 0;
+#endif
+}
+
+/* w * 10^q, w exact : Clinger si tout est exact en double, sinon Eisel-Lemire. */
+static int to_double(uint64_t w, int q, int neg, double *out)
+{
+    if (w <= ((uint64_t)1 << 53) && q >= -22 && q <= 22) {
+        // Deux valeurs exactes : une seule opération IEEE, donc arrondi correct
+        double v = (double)w;
+        v = (q < 0) ? v / exact_pow10[-q] : v * exact_pow10[q];
+        *out = neg ? -v : v;
+        return 1;
+    }
+    return eisel_lemire(w, q, neg, out);
+}
+
+/* Dernier recours (cas rares) : strtod sur une copie terminée par '\0' du nombre. */
+static void fallback_strtod(const char *start, const char *stop, double *out)
+{
+    char buf[512];
+    size_t len = (size_t)(stop - start);
+    if (len >= sizeof(buf)) len = sizeof(buf) - 1;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    *out = strtod(buf, NULL);
+}
+
+/* "inf", "infinity", "nan" (insensible à la casse). */
+static const char *parse_special(const char *p, const char *end, int neg, double *out)
+{
+    static const char *const words[] = { "infinity", "inf", "nan" };
+    for (int k = 0; k < 3; k++) {
+        size_t len = strlen(words[k]), i = 0;
+        while (i < len && p + i < end && (p[i] | 0x20) == words[k][i]) i++;
+        if (i == len) {
+            *out = (k == 2) ? NAN : (neg ? -INFINITY : INFINITY);
+            return p + len;
+        }
+    }
+    return NULL;
+}
+
+/* ================================
+ * API
+ * ================================ */
+
+const char *parse_double(const char *p, const char *end, double *out)
+{
+    const char *start = p;
+    int neg = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+
+    // Mantisse : au plus 19 chiffres significatifs accumulés, les suivants ne font que déplacer l'exposant
+    uint64_t w = 0;
+    int nd = 0, exp10 = 0, any = 0, truncated = 0;
+
+    for (; p < end && is_digit(*p); p++) {
+        const unsigned d = (unsigned)(*p - '0');
+        any = 1;
+        if (nd < MAX_EXACT_DIGITS) {
+            w = w * 10 + d;
+            if (w) nd++;
+        } else {
+            exp10++;
+            truncated |= (d != 0);
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++) {
+            const unsigned d = (unsigned)(*p - '0');
+            any = 1;
+            if (nd < MAX_EXACT_DIGITS) {
+                w = w * 10 + d;
+                if (w) nd++;
+                exp10--;
+            } else {
+                truncated |= (d != 0);
+            }
+        }
+    }
+
+    if (!any) {
+        const char *q = parse_special(p, end, neg, out);
+        return q ? q : start;
+    }
+
+    // Exposant : 'e' sans chiffre derrière ne fait pas partie du nombre (comme strtod)
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0, e = 0;
+        if (q < end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q < end && is_digit(*q)) {
+            for (; q < end && is_digit(*q); q++)
+                if (e < 100000) e = e * 10 + (*q - '0');
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+
+    if (w == 0) {
+        *out = neg ? -0.0 : 0.0;
+        return p;
+    }
+
+    if (!truncated) {
+        if (to_double(w, exp10, neg, out)) return p;
+    } else {
+        // Mantisse tronquée : la vraie valeur est dans [w, w+1[ x 10^q, résultat sûr si les deux bornes coïncident
+        double lo, hi;
+        if (to_double(w, exp10, neg, &lo) && to_double(w + 1, exp10, neg, &hi) && lo == hi) {
+            *out = lo;
+            return p;
+        }
+    }
+
+    fallback_strtod(start, p, out);
+    return p;
+}
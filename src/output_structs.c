@@ -0,0 +1,129 @@
+/**
+ * @file    output_structs.c
+ * @brief   Gestion mémoire des structures de résultats (pics et intervalles) et écriture des fichiers de sortie.
+ * @details Les tableaux sont alloués une fois puis agrandis par doublement de capacité :
+ *          coût amorti O(1) par pic ajouté, et aucune troncature silencieuse sur les longs
+ *          enregistrements (Holter 24 h).
+ *
+ */
+
+#include "output_structs.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ================================
+ * Helpers (internes)
+ * ================================ */
+
+static int grow_capacity(int current, int needed)
+{
+    int cap = (current > 0) ? current : MAX_BEATS;
+    while (cap < needed) cap *= 2;
+    return cap;
+}
+
+static int realloc_ints(int **a, int cap)
+{
+    int *p = realloc(*a, sizeof(int) * (size_t)cap);
+    if (!p) return -1;
+    *a = p;
+    return 0;
+}
+
+/* ================================
+ * API
+ * ================================ */
+
+int ecg_peaks_init(ECG_Peaks *peaks, int capacity)
+{
+    if (!peaks) return -1;
+
+    memset(peaks, 0, sizeof(*peaks));
+    return ecg_peaks_reserve(peaks, (capacity > 0) ? capacity : MAX_BEATS);
+}
+
+int ecg_peaks_reserve(ECG_Peaks *peaks, int capacity)
+{
+    if (!peaks) return -1;
+    if (capacity <= peaks->capacity) return 0;
+
+    const int cap = grow_capacity(peaks->capacity, capacity);
+    if (realloc_ints(&peaks->R, cap) || realloc_ints(&peaks->P, cap) || realloc_ints(&peaks->Q, cap)
+        || realloc_ints(&peaks->S, cap) || realloc_ints(&peaks->T, cap)) {
+        return -2;
+    }
+
+    peaks->capacity = cap;
+    return 0;
+}
+
+void ecg_peaks_free(ECG_Peaks *peaks)
+{
+    if (!peaks) return;
+
+    free(peaks->R);
+    free(peaks->P);
+    free(peaks->Q);
+    free(peaks->S);
+    free(peaks->T);
+    memset(peaks, 0, sizeof(*peaks));
+}
+
+int ecg_intervals_init(ECG_Intervals *intervals, int capacity)
+{
+    if (!intervals) return -1;
+
+    memset(intervals, 0, sizeof(*intervals));
+    return ecg_intervals_reserve(intervals, (capacity > 0) ? capacity : MAX_BEATS);
+}
+
+int ecg_intervals_reserve(ECG_Intervals *intervals, int capacity)
+{
+    if (!intervals) return -1;
+    if (capacity <= intervals->capacity) return 0;
+
+    const int cap = grow_capacity(intervals->capacity, capacity);
+    double *p = realloc(intervals->RR, sizeof(double) * (size_t)cap);
+    if (!p) return -2;
+
+    intervals->RR = p;
+    intervals->capacity = cap;
+    return 0;
+}
+
+void ecg_intervals_free(ECG_Intervals *intervals)
+{
+    if (!intervals) return;
+
+    free(intervals->RR);
+    memset(intervals, 0, sizeof(*intervals));
+}
+
+int ecg_write_file(const char *filename, const void *data, size_t len)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    const unsigned char *p = data;
+    int rc = 0;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            perror("write");
+            rc = -2;
+            break;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+
+    if (close(fd) != 0) rc = -2;
+    return rc;
+}